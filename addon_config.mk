@@ -64,22 +64,22 @@ linux64:
 	# binary libraries, these will be usually parsed from the file system but some 
 	# libraries need to passed to the linker in a specific order 
 	ADDON_INCLUDES_EXCLUDE = libs/libcurl/include
-	ADDON_PKG_CONFIG_LIBRARIES = libcurl
+	ADDON_PKG_CONFIG_LIBRARIES = libcurl openssl
 linux:
         # binary libraries, these will be usually parsed from the file system but some
         # libraries need to passed to the linker in a specific order
         ADDON_INCLUDES_EXCLUDE = libs/libcurl/include
-        ADDON_PKG_CONFIG_LIBRARIES = libcurl
+        ADDON_PKG_CONFIG_LIBRARIES = libcurl openssl
 win_cb:
 linuxarmv6l:
         # binary libraries, these will be usually parsed from the file system but some
         # libraries need to passed to the linker in a specific order
         ADDON_INCLUDES_EXCLUDE = libs/libcurl/include
-        ADDON_PKG_CONFIG_LIBRARIES = libcurl
+        ADDON_PKG_CONFIG_LIBRARIES = libcurl openssl
 linuxarmv7l:
         # binary libraries, these will be usually parsed from the file system but some
         # libraries need to passed to the linker in a specific order
         ADDON_INCLUDES_EXCLUDE = libs/libcurl/include
-        ADDON_PKG_CONFIG_LIBRARIES = libcurl
+        ADDON_PKG_CONFIG_LIBRARIES = libcurl openssl
 android/armeabi:	
 android/armeabi-v7a:	
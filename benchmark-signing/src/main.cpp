@@ -0,0 +1,403 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+
+// Microbenchmarks for the per-request CPU work in ofxOAuth: signing (as
+// done by ofxOAuth::get and ofxOAuth::post), percent-encoding, base64,
+// token reply parsing and response body accumulation.
+//
+// The nonce and timestamp are fixed, so every run signs exactly the same
+// bytes.  The first vector is the example from the OAuth 1.0 spec
+// (appendix A.5), and its signature is checked, so a broken build of
+// liboauth shows up as a failed check rather than as a fast number.
+//
+// Output is CSV, one line per benchmark:
+//
+//     benchmark,iterations,ns_per_op_min,ns_per_op_median,check
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <oauth.h>
+#include "ofxOAuthFormDecoder.h"
+
+
+struct TestVector
+{
+    const char* name;
+    const char* method;
+    const char* url;
+    const char* query;
+    const char* consumerKey;
+    const char* consumerSecret;
+    const char* token;
+    const char* tokenSecret;
+    const char* nonce;
+    const char* timestamp;
+    const char* expectedSignature; //< 0 if unknown
+};
+
+
+static const TestVector vectors[] =
+{
+    {
+        "spec_a5", "GET",
+        "http://photos.example.net/photos", "file=vacation.jpg&size=original",
+        "dpf43f3p2l4k3l03", "kd94hf93k423kf44",
+        "nnch734d00sl2jdk", "pfkkdhi9sl3r4s00",
+        "kllo9940pd9333jh", "1191242096",
+        "tR3+Ty81lMeYAr/Fid0kMTYa/WM="
+    },
+    {
+        "timeline", "GET",
+        "https://api.twitter.com/1.1/statuses/home_timeline.json",
+        "count=200&include_entities=true&exclude_replies=false&trim_user=false&since_id=210462857140252672",
+        "xvz1evFS4wEEPTGEFPHBog", "kAcSOqF21Fu85e7zjz7ZN2U4ZRhfV3WpwPAoE3Z7kBw",
+        "370773112-GmHxMAgYyLbNEtIKZeRNFsMKPR9EyMZeS9weJAEb", "LswwdoUaIvS8ltyTt5jkRh4J50vUPVVHtR2YPi5kE",
+        "kYjzVBB8Y0ZFabxSWbWovY3uYSQ2pTgmZeNu2VS4cg", "1318622958",
+        0
+    },
+    {
+        "status_update", "POST",
+        "https://api.twitter.com/1.1/statuses/update.json",
+        "status=Hello%20Ladies%20%2B%20Gentlemen%2C%20a%20signed%20OAuth%20request%21&include_entities=true",
+        "xvz1evFS4wEEPTGEFPHBog", "kAcSOqF21Fu85e7zjz7ZN2U4ZRhfV3WpwPAoE3Z7kBw",
+        "370773112-GmHxMAgYyLbNEtIKZeRNFsMKPR9EyMZeS9weJAEb", "LswwdoUaIvS8ltyTt5jkRh4J50vUPVVHtR2YPi5kE",
+        "kYjzVBB8Y0ZFabxSWbWovY3uYSQ2pTgmZeNu2VS4cg", "1318622958",
+        0
+    }
+};
+
+
+// Signs a request the way ofxOAuth::get and ofxOAuth::post do, with the
+// vector's nonce and timestamp, and returns the Authorization header
+// parameters.  For GET the remaining parameters are serialized back into
+// the url, for POST into the body.
+static std::string sign(const TestVector& v)
+{
+    int argc = 0;
+    char** argv = 0;
+
+    std::string url = std::string(v.url) + "?" + v.query;
+
+    argc = oauth_split_url_parameters(url.c_str(), &argv);
+
+    std::string nonce = std::string("oauth_nonce=") + v.nonce;
+    std::string timestamp = std::string("oauth_timestamp=") + v.timestamp;
+
+    oauth_add_param_to_array(&argc, &argv, nonce.c_str());
+    oauth_add_param_to_array(&argc, &argv, timestamp.c_str());
+
+    oauth_sign_array2_process(&argc,
+                              &argv,
+                              0,
+                              OA_HMAC,
+                              v.method,
+                              v.consumerKey,
+                              v.consumerSecret,
+                              v.token,
+                              v.tokenSecret);
+
+    bool isPost = 0 == strcmp(v.method, "POST");
+
+    char* params = oauth_serialize_url_sep(argc, isPost ? 1 : 0, argv, const_cast<char*>("&"), 1);
+    char* header = oauth_serialize_url_sep(argc, 1, argv, const_cast<char*>(", "), isPost ? 2 : 6);
+
+    std::string result = header ? header : "";
+
+    free(params);
+    free(header);
+    oauth_free_array(&argc, &argv);
+
+    return result;
+}
+
+
+// The oauth_signature value of serialized header parameters, unescaped.
+static std::string getSignature(const std::string& header)
+{
+    std::string::size_type begin = header.find("oauth_signature=");
+
+    if(begin == std::string::npos) return "";
+
+    begin += 16;
+
+    // ofxOAuth::get quotes the values (mode 6), ofxOAuth::post does not (mode 2).
+    if(begin < header.size() && header[begin] == '"') ++begin;
+
+    std::string::size_type end = header.find_first_of("\", ", begin);
+
+    char* value = oauth_url_unescape(header.substr(begin, end - begin).c_str(), 0);
+    std::string signature = value ? value : "";
+    free(value);
+
+    return signature;
+}
+
+
+struct MemoryStruct
+{
+    char* data;
+    std::size_t size;
+};
+
+
+// The body accumulation of the old ofx_oauth_curl_get and friends,
+// minus the final ofLogVerbose: a realloc per chunk, plus a debug string
+// that is built whether or not verbose logging is on.
+static std::size_t WriteMemoryCallback(void* ptr,
+                                       std::size_t size,
+                                       std::size_t nmemb,
+                                       void* data)
+{
+    std::stringstream ss;
+    ss << "IN MEMORY CALLBACK" << std::endl;
+    ss << "ptr: " << ptr << std::endl;
+    ss << "size: " << size << std::endl;
+    ss << "nmemb: " << nmemb << std::endl;
+    ss << "data: " << data << std::endl;
+
+    std::size_t realsize = size * nmemb;
+
+    struct MemoryStruct *mem = (struct MemoryStruct *)data;
+
+    mem->data = (char*)realloc(mem->data, mem->size + realsize + 1);
+
+    if (mem->data)
+    {
+        memcpy(&(mem->data[mem->size]), ptr, realsize);
+        mem->size += realsize;
+        mem->data[mem->size] = 0;
+    }
+
+    ss << "----" << std::endl;
+    ss << "ptr: " << ptr << std::endl;
+    ss << "size: " << size << std::endl;
+    ss << "nmemb: " << nmemb << std::endl;
+    ss << "data: " << data << std::endl;
+    ss << "realsize: " << realsize << std::endl;
+
+    return realsize;
+}
+
+
+// The body accumulation of ofxOAuthTransport.
+static std::size_t appendCallback(char* ptr, std::size_t size, std::size_t nmemb, void* data)
+{
+    static_cast<std::string*>(data)->append(ptr, size * nmemb);
+    return size * nmemb;
+}
+
+
+// Keeps results alive so the compiler cannot drop the measured work.
+static volatile std::size_t sink = 0;
+
+
+template<class Operation>
+static void run(const std::string& name, std::size_t iterations, const std::string& check, Operation operation)
+{
+    const int repetitions = 7;
+
+    if(iterations < 1) iterations = 1;
+
+    // warm up caches and the allocator.
+    for(std::size_t i = 0; i < iterations / 10 + 1; ++i) sink += operation();
+
+    std::vector<double> samples;
+
+    for(int r = 0; r < repetitions; ++r)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        for(std::size_t i = 0; i < iterations; ++i) sink += operation();
+
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+        samples.push_back(std::chrono::duration<double, std::nano>(end - start).count() / iterations);
+    }
+
+    std::sort(samples.begin(), samples.end());
+
+    printf("%s,%zu,%.1f,%.1f,%s\n", name.c_str(), iterations, samples.front(), samples[samples.size() / 2], check.c_str());
+    fflush(stdout);
+}
+
+
+int main(int argc, char* argv[])
+{
+    double scale = argc > 1 ? atof(argv[1]) : 1.0;
+
+    if(scale <= 0) scale = 1.0;
+
+    bool isValid = true;
+
+    printf("benchmark,iterations,ns_per_op_min,ns_per_op_median,check\n");
+
+    // signing, end to end.
+    for(std::size_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]); ++i)
+    {
+        const TestVector& v = vectors[i];
+
+        std::string signature = getSignature(sign(v));
+        std::string check = signature;
+
+        if(0 != v.expectedSignature)
+        {
+            bool isMatch = signature == v.expectedSignature;
+            check = isMatch ? "ok" : "MISMATCH:" + signature;
+            isValid = isValid && isMatch;
+        }
+
+        run(std::string("sign_") + v.name, static_cast<std::size_t>(20000 * scale), check, [&v]()
+        {
+            return sign(v).size();
+        });
+    }
+
+    // the HMAC-SHA1 and base64 inside the signature.
+    std::string baseString = "GET&http%3A%2F%2Fphotos.example.net%2Fphotos&file%3Dvacation.jpg%26oauth_consumer_key%3Ddpf43f3p2l4k3l03%26oauth_nonce%3Dkllo9940pd9333jh%26oauth_signature_method%3DHMAC-SHA1%26oauth_timestamp%3D1191242096%26oauth_token%3Dnnch734d00sl2jdk%26oauth_version%3D1.0%26size%3Doriginal";
+
+    {
+        char* signature = oauth_sign_hmac_sha1(baseString.c_str(), "kd94hf93k423kf44&pfkkdhi9sl3r4s00");
+        bool isMatch = signature && 0 == strcmp(signature, vectors[0].expectedSignature);
+        isValid = isValid && isMatch;
+        free(signature);
+
+        run("hmac_sha1", static_cast<std::size_t>(100000 * scale), isMatch ? "ok" : "MISMATCH", [&baseString]()
+        {
+            char* signature = oauth_sign_hmac_sha1(baseString.c_str(), "kd94hf93k423kf44&pfkkdhi9sl3r4s00");
+            std::size_t size = strlen(signature);
+            free(signature);
+            return size;
+        });
+    }
+
+    std::vector<unsigned char> binary(1024);
+
+    for(std::size_t i = 0; i < binary.size(); ++i)
+    {
+        binary[i] = static_cast<unsigned char>((i * 131) & 0xff);
+    }
+
+    run("base64_20B", static_cast<std::size_t>(200000 * scale), "", [&binary]()
+    {
+        char* encoded = oauth_encode_base64(20, &binary[0]);
+        std::size_t size = strlen(encoded);
+        free(encoded);
+        return size;
+    });
+
+    run("base64_1KB", static_cast<std::size_t>(50000 * scale), "", [&binary]()
+    {
+        char* encoded = oauth_encode_base64(static_cast<int>(binary.size()), &binary[0]);
+        std::size_t size = strlen(encoded);
+        free(encoded);
+        return size;
+    });
+
+    // a status text with spaces, reserved characters and utf-8.
+    std::string text;
+
+    while(text.size() < 1024)
+    {
+        text += "Hello Ladies + Gentlemen, a signed OAuth request! caf\xc3\xa9 50% off/today?&=";
+    }
+
+    run("url_escape_1KB", static_cast<std::size_t>(50000 * scale), "", [&text]()
+    {
+        char* escaped = oauth_url_escape(text.c_str());
+        std::size_t size = strlen(escaped);
+        free(escaped);
+        return size;
+    });
+
+    // the access token reply, as parsed by obtainAccessToken.
+    const std::string reply = "oauth_token=370773112-GmHxMAgYyLbNEtIKZeRNFsMKPR9EyMZeS9weJAEb&oauth_token_secret=LswwdoUaIvS8ltyTt5jkRh4J50vUPVVHtR2YPi5kE&user_id=370773112&screen_name=some%20user&x_auth_expires=0";
+
+    run("reply_parse", static_cast<std::size_t>(500000 * scale), "", [&reply]()
+    {
+        std::string buffer = reply; // decoded in place
+        ofxOAuthFormDecoder decoder(buffer);
+        ofxOAuthFormDecoder::Field field;
+
+        std::size_t fields = 0;
+
+        while(decoder.next(field))
+        {
+            if(field.id != ofxOAuthFormDecoder::UNKNOWN_KEY) fields += field.value.size;
+        }
+
+        return fields;
+    });
+
+    // a 64 KB body, delivered in the 16 KB chunks curl uses by default and
+    // in the small chunks a slow connection produces.
+    std::string body(64 * 1024, 'x');
+
+    const std::size_t chunkSizes[] = { 16384, 1460 };
+
+    for(std::size_t c = 0; c < sizeof(chunkSizes) / sizeof(chunkSizes[0]); ++c)
+    {
+        std::size_t chunkSize = chunkSizes[c];
+        std::string suffix = "_64KB_" + std::to_string(chunkSize) + "B_chunks";
+
+        run("write_memory_callback" + suffix, static_cast<std::size_t>(5000 * scale), "", [&body, chunkSize]()
+        {
+            MemoryStruct mem = { 0, 0 };
+
+            for(std::size_t offset = 0; offset < body.size(); offset += chunkSize)
+            {
+                std::size_t n = std::min(chunkSize, body.size() - offset);
+                WriteMemoryCallback(const_cast<char*>(body.data() + offset), 1, n, &mem);
+            }
+
+            std::size_t size = mem.size;
+            free(mem.data);
+            return size;
+        });
+
+        run("transport_write_callback" + suffix, static_cast<std::size_t>(5000 * scale), "", [&body, chunkSize]()
+        {
+            std::string response;
+
+            for(std::size_t offset = 0; offset < body.size(); offset += chunkSize)
+            {
+                std::size_t n = std::min(chunkSize, body.size() - offset);
+                appendCallback(const_cast<char*>(body.data() + offset), 1, n, &response);
+            }
+
+            return response.size();
+        });
+    }
+
+    return isValid ? 0 : 1;
+}
@@ -0,0 +1,308 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+// Measures upload throughput of the two ways ofxOAuth can hand a file to
+// curl: through stdio (a form file part / a FILE* as READDATA, the old path)
+// and from a memory mapping (ofxOAuthUploadSource).  Uploads go to a local
+// sink server that discards the body, so the numbers reflect the client's
+// copy path rather than the network.
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <string>
+#include <vector>
+#include <curl/curl.h>
+#include "ofxOAuthMultipartForm.h"
+#include "ofxOAuthUploadSource.h"
+
+
+// A minimal HTTP server that reads each request, discards the body and
+// answers 200.
+static void* sinkServer(void* data)
+{
+    int listener = *static_cast<int*>(data);
+
+    std::vector<char> buffer(1 << 20);
+
+    for(;;)
+    {
+        int client = accept(listener, 0, 0);
+
+        if(client < 0) break;
+
+        std::string head;
+        long long contentLength = 0;
+        long long received = 0;
+
+        for(;;)
+        {
+            ssize_t n = recv(client, &buffer[0], buffer.size(), 0);
+
+            if(n <= 0) break;
+
+            if(contentLength == 0 || head.find("\r\n\r\n") == std::string::npos)
+            {
+                head.append(&buffer[0], n);
+
+                std::string::size_type end = head.find("\r\n\r\n");
+
+                if(end == std::string::npos) continue;
+
+                const char* cl = strcasestr(head.c_str(), "content-length:");
+                contentLength = cl ? atoll(cl + 15) : 0;
+
+                if(strcasestr(head.c_str(), "expect: 100-continue"))
+                {
+                    const char* cont = "HTTP/1.1 100 Continue\r\n\r\n";
+                    send(client, cont, strlen(cont), 0);
+                }
+
+                received = head.size() - (end + 4);
+            }
+            else
+            {
+                received += n;
+            }
+
+            if(received >= contentLength) break;
+        }
+
+        const char* reply = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\nConnection: close\r\n\r\nok";
+        send(client, reply, strlen(reply), 0);
+        close(client);
+    }
+
+    return 0;
+}
+
+
+static std::size_t discard(char*, std::size_t size, std::size_t nmemb, void*)
+{
+    return size * nmemb;
+}
+
+
+static double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+
+enum Mode
+{
+    MULTIPART_STDIO,
+    MULTIPART_MMAP,
+    RAW_STDIO,
+    RAW_MMAP
+};
+
+
+static const char* modeName(Mode mode)
+{
+    switch(mode)
+    {
+        case MULTIPART_STDIO: return "multipart_stdio";
+        case MULTIPART_MMAP: return "multipart_mmap";
+        case RAW_STDIO: return "raw_stdio";
+        case RAW_MMAP: return "raw_mmap";
+    }
+
+    return "";
+}
+
+
+static bool upload(const std::string& url, const std::string& path, std::size_t size, Mode mode)
+{
+    CURL* curl = curl_easy_init();
+
+    ofxOAuthMultipartForm::Post post = 0;
+    ofxOAuthMultipartForm form;
+    FILE* file = 0;
+    ofxOAuthUploadSource source;
+
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, discard);
+
+    switch(mode)
+    {
+        case MULTIPART_STDIO:
+        {
+#if defined(OFX_OAUTH_HAS_CURL_MIME)
+            post = curl_mime_init(curl);
+            curl_mimepart* part = curl_mime_addpart(post);
+            curl_mime_name(part, "media[]");
+            curl_mime_filedata(part, path.c_str());
+            curl_easy_setopt(curl, CURLOPT_MIMEPOST, post);
+#else
+            struct curl_httppost* last = 0;
+            curl_formadd(&post, &last,
+                         CURLFORM_COPYNAME, "media[]",
+                         CURLFORM_FILE, path.c_str(),
+                         CURLFORM_END);
+            curl_easy_setopt(curl, CURLOPT_HTTPPOST, post);
+#endif
+            break;
+        }
+        case MULTIPART_MMAP:
+            form.addFile("media[]", path);
+            post = form.attach(curl);
+            break;
+        case RAW_STDIO:
+            file = fopen(path.c_str(), "rb");
+            curl_easy_setopt(curl, CURLOPT_POST, 1L);
+            curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t)size);
+            curl_easy_setopt(curl, CURLOPT_READDATA, file);
+            break;
+        case RAW_MMAP:
+            source.openFile(path);
+            curl_easy_setopt(curl, CURLOPT_POST, 1L);
+            curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t)source.size());
+            curl_easy_setopt(curl, CURLOPT_READFUNCTION, ofxOAuthUploadSource::readCallback);
+            curl_easy_setopt(curl, CURLOPT_READDATA, (void*)&source);
+            break;
+    }
+
+    CURLcode res = curl_easy_perform(curl);
+
+    long status = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+
+    if(post) ofxOAuthMultipartForm::freePost(post);
+    if(file) fclose(file);
+    curl_easy_cleanup(curl);
+
+    return res == CURLE_OK && status == 200;
+}
+
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::size_t> sizes;
+
+    for(int i = 1; i < argc; ++i)
+    {
+        sizes.push_back(static_cast<std::size_t>(atol(argv[i])));
+    }
+
+    if(sizes.empty())
+    {
+        sizes.push_back(10);
+        sizes.push_back(50);
+        sizes.push_back(100);
+        sizes.push_back(500);
+    }
+
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+
+    socklen_t length = sizeof(address);
+
+    if(bind(listener, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+       listen(listener, 16) != 0 ||
+       getsockname(listener, (struct sockaddr*)&address, &length) != 0)
+    {
+        fprintf(stderr, "Unable to start the sink server.\n");
+        return 1;
+    }
+
+    pthread_t thread;
+    pthread_create(&thread, 0, sinkServer, &listener);
+
+    char url[64];
+    snprintf(url, sizeof(url), "http://127.0.0.1:%d/upload", ntohs(address.sin_port));
+
+    const int repetitions = 3;
+
+    // machine readable, one line per size and mode.
+    printf("mode,size_mb,seconds,mb_per_second\n");
+
+    for(std::size_t i = 0; i < sizes.size(); ++i)
+    {
+        std::size_t size = sizes[i] * 1024 * 1024;
+
+        char path[] = "/tmp/ofxOAuthUploadXXXXXX";
+        int fd = mkstemp(path);
+
+        std::vector<char> block(1 << 20, 'x');
+
+        for(std::size_t written = 0; written < size; written += block.size())
+        {
+            if(write(fd, &block[0], block.size()) < 0) break;
+        }
+
+        close(fd);
+
+        Mode modes[] = { MULTIPART_STDIO, MULTIPART_MMAP, RAW_STDIO, RAW_MMAP };
+
+        for(std::size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); ++m)
+        {
+            // warm the page cache so every mode starts from the same place.
+            upload(url, path, size, modes[m]);
+
+            double best = 1e9;
+
+            for(int r = 0; r < repetitions; ++r)
+            {
+                double start = now();
+
+                if(!upload(url, path, size, modes[m]))
+                {
+                    fprintf(stderr, "Upload failed: %s\n", modeName(modes[m]));
+                }
+
+                double elapsed = now() - start;
+                if(elapsed < best) best = elapsed;
+            }
+
+            printf("%s,%zu,%.4f,%.1f\n", modeName(modes[m]), sizes[i], best, sizes[i] / best);
+            fflush(stdout);
+        }
+
+        unlink(path);
+    }
+
+    close(listener);
+    curl_global_cleanup();
+
+    return 0;
+}
@@ -0,0 +1,135 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+
+#include <stdlib.h>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include "ofxOAuthClient.h"
+#include "ofxOAuthMockProvider.h"
+
+
+#if !defined(OFX_OAUTH_HAS_COROUTINES)
+#error "example-headless-coroutine needs C++20 coroutines (-std=c++20)."
+#endif
+
+
+// Sends the requests one after another from a coroutine.  Each one is
+// awaited with resumeOn(client.getUpdateExecutor()), so everything after a
+// co_await runs inside client.update() on the main thread, never on the
+// transport's I/O thread.
+ofxOAuthCoroutine fetch(ofxOAuthClient& client,
+                        int requests,
+                        std::thread::id mainThread,
+                        int& failures,
+                        bool& isDone)
+{
+    for(int i = 0; i < requests; ++i)
+    {
+        ofxOAuthResponse response = co_await client.getAsync("/1.1/account/verify_credentials.json", "mock_size=64")
+            .resumeOn(client.getUpdateExecutor());
+
+        if(std::this_thread::get_id() != mainThread)
+        {
+            ofLogError("fetch") << "Resumed off the main thread.";
+            ++failures;
+        }
+
+        if(response.status == 200)
+        {
+            std::cout << response.body << std::endl;
+        }
+        else
+        {
+            ++failures;
+        }
+    }
+
+    isDone = true;
+}
+
+
+// example-headless with its requests awaited from a C++20 coroutine, resumed
+// by the application's own update loop.
+//
+// usage: example-headless-coroutine [requests]
+int main(int argc, char* argv[])
+{
+    int requests = argc > 1 ? atoi(argv[1]) : 3;
+
+    ofxOAuthMockProvider provider;
+
+    if(!provider.start())
+    {
+        ofLogError("main") << "Unable to start the mock provider on " << provider.getURL();
+        return EXIT_FAILURE;
+    }
+
+    ofxOAuthMockProvider::Settings settings = provider.getSettings();
+
+    ofxOAuthClient client;
+    client.setCredentialsPathname("headless_credentials.xml");
+    client.setVerifierCallbackURL("oob");
+    client.setup(provider.getURL(),
+                 provider.getRequestTokenURL(),
+                 provider.getAccessTokenURL(),
+                 provider.getAuthorizationURL(),
+                 settings.consumerKey,
+                 settings.consumerSecret);
+
+    // a saved access token belongs to an earlier provider.
+    client.setAccessToken("");
+    client.setAccessTokenSecret("");
+
+    client.obtainRequestToken();
+    client.requestUserVerification(false);
+    client.setRequestTokenVerifier(provider.authorize(client.getRequestToken()));
+    client.obtainAccessToken();
+
+    if(!client.isAuthorized())
+    {
+        ofLogError("main") << "Authorization failed.";
+        return EXIT_FAILURE;
+    }
+
+    int failures = 0;
+    bool isDone = false;
+
+    fetch(client, requests, std::this_thread::get_id(), failures, isDone);
+
+    // the application's update loop.
+    while(!isDone)
+    {
+        client.update();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    provider.stop();
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,103 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#include <stdlib.h>
+#include <iostream>
+#include <string>
+#include "ofxOAuthClient.h"
+#include "ofxOAuthMockProvider.h"
+
+
+// Runs the token flow and a signed request with no openFrameworks app, the
+// way a daemon would.  The provider is the local mock one, so this works
+// offline; the user approval step is done by the provider itself.
+//
+// usage: example-headless [requests]
+int main(int argc, char* argv[])
+{
+    int requests = argc > 1 ? atoi(argv[1]) : 3;
+
+    ofxOAuthMockProvider provider;
+
+    if(!provider.start())
+    {
+        ofLogError("main") << "Unable to start the mock provider on " << provider.getURL();
+        return EXIT_FAILURE;
+    }
+
+    ofxOAuthMockProvider::Settings settings = provider.getSettings();
+
+    ofxOAuthClient client;
+    client.setCredentialsPathname("headless_credentials.xml");
+    client.setVerifierCallbackURL("oob");
+    client.setup(provider.getURL(),
+                 provider.getRequestTokenURL(),
+                 provider.getAccessTokenURL(),
+                 provider.getAuthorizationURL(),
+                 settings.consumerKey,
+                 settings.consumerSecret);
+
+    // a saved access token belongs to an earlier provider.
+    client.setAccessToken("");
+    client.setAccessTokenSecret("");
+
+    client.obtainRequestToken();
+
+    std::string url = client.requestUserVerification(false);
+
+    ofLogNotice("main") << "A user would approve the request token at : " << url;
+
+    client.setRequestTokenVerifier(provider.authorize(client.getRequestToken()));
+    client.obtainAccessToken();
+
+    if(!client.isAuthorized())
+    {
+        ofLogError("main") << "Authorization failed.";
+        return EXIT_FAILURE;
+    }
+
+    ofLogNotice("main") << "Authorized as " << client.getScreenName() << ".";
+
+    int failures = 0;
+
+    for(int i = 0; i < requests; ++i)
+    {
+        ofxOAuthResponse response;
+
+        if(client.request(ofxOAuthClient::OFX_HTTP_GET, "/1.1/account/verify_credentials.json", "mock_size=64", "", response) && response.status == 200)
+        {
+            std::cout << response.body << std::endl;
+        }
+        else
+        {
+            ++failures;
+        }
+    }
+
+    provider.stop();
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
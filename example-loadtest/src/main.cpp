@@ -0,0 +1,44 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#include "ofMain.h"
+#include "ofAppNoWindow.h"
+#include "ofApp.h"
+
+
+// usage: example-loadtest [clients] [requests per client] [latency ms] [response bytes]
+int main(int argc, char* argv[])
+{
+    ofApp::Settings settings;
+
+    if(argc > 1) settings.clients = ofToInt(argv[1]);
+    if(argc > 2) settings.requestsPerClient = ofToInt(argv[2]);
+    if(argc > 3) settings.provider.latency = ofToInt(argv[3]);
+    if(argc > 4) settings.provider.responseSize = ofToInt(argv[4]);
+
+    ofAppNoWindow window;
+    ofSetupOpenGL(&window, 100, 100, OF_WINDOW);
+    ofRunApp(new ofApp(settings));
+}
@@ -0,0 +1,223 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#include "ofApp.h"
+
+
+//------------------------------------------------------------------------------
+LoadClient::LoadClient(int id,
+                       int requests,
+                       ofxOAuthMockProvider& provider,
+                       LoadResults& results):
+    _id(id),
+    _requests(requests),
+    _provider(provider),
+    _results(results)
+{
+}
+
+//------------------------------------------------------------------------------
+void LoadClient::run()
+{
+    if(authorize())
+    {
+        ofxOAuthResponse response;
+
+        for(int i = 0; i < _requests; ++i)
+        {
+            Poco::Timestamp start;
+
+            if(request(OFX_HTTP_GET, "/1.1/resource.json", "", "", response) && response.status == 200)
+            {
+                _results.resource.record(static_cast<uint64_t>(start.elapsed()));
+            }
+            else
+            {
+                ++_results.resourceErrors;
+            }
+        }
+    }
+    else
+    {
+        // count the requests that never happened, so totals add up.
+        _results.resourceErrors += _requests;
+    }
+
+    ++_results.finished;
+}
+
+//------------------------------------------------------------------------------
+bool LoadClient::authorize()
+{
+    ofxOAuthMockProvider::Settings settings = _provider.getSettings();
+
+    // every run starts from scratch, against a provider with no tokens.
+    std::string credentials = ofToDataPath("loadtest_credentials_" + ofToString(_id) + ".xml", true);
+    ofFile::removeFile(credentials, false);
+
+    setCredentialsPathname(credentials);
+    setVerifierCallbackURL("oob");
+
+    setup(_provider.getURL(),
+          _provider.getRequestTokenURL(),
+          _provider.getAccessTokenURL(),
+          _provider.getAuthorizationURL(),
+          settings.consumerKey,
+          settings.consumerSecret);
+
+    Poco::Timestamp start;
+
+    obtainRequestToken();
+
+    if(getRequestToken().empty())
+    {
+        ++_results.requestTokenErrors;
+        return false;
+    }
+
+    _results.requestToken.record(static_cast<uint64_t>(start.elapsed()));
+
+    // the user approves at once.
+    setRequestTokenVerifier(_provider.authorize(getRequestToken()));
+
+    start.update();
+
+    obtainAccessToken();
+
+    if(getAccessToken().empty())
+    {
+        ++_results.accessTokenErrors;
+        return false;
+    }
+
+    _results.accessToken.record(static_cast<uint64_t>(start.elapsed()));
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+ofApp::ofApp(const Settings& _settings):
+    settings(_settings),
+    provider(_settings.provider),
+    isReported(false)
+{
+}
+
+//------------------------------------------------------------------------------
+void ofApp::setup()
+{
+    if(!provider.start())
+    {
+        ofLogError("ofApp::setup") << "Unable to start the mock provider on " << provider.getURL();
+        ofExit(1);
+        return;
+    }
+
+    ofLogNotice("ofApp::setup") << settings.clients << " clients x " << settings.requestsPerClient << " requests against " << provider.getURL();
+
+    pool = std::shared_ptr<Poco::ThreadPool>(new Poco::ThreadPool(settings.clients, settings.clients));
+
+    for(int i = 0; i < settings.clients; ++i)
+    {
+        clients.push_back(std::shared_ptr<LoadClient>(new LoadClient(i, settings.requestsPerClient, provider, results)));
+    }
+
+    startTime.update();
+
+    for(std::size_t i = 0; i < clients.size(); ++i)
+    {
+        pool->start(*clients[i]);
+    }
+}
+
+//------------------------------------------------------------------------------
+void ofApp::update()
+{
+    if(!isReported && results.finished == settings.clients)
+    {
+        report();
+        isReported = true;
+        ofExit();
+    }
+}
+
+//------------------------------------------------------------------------------
+void ofApp::exit()
+{
+    if(pool) pool->joinAll();
+    clients.clear();
+    provider.stop();
+}
+
+//------------------------------------------------------------------------------
+void ofApp::report()
+{
+    double seconds = startTime.elapsed() / 1000000.0;
+
+    struct Phase
+    {
+        const char* name;
+        const ofxOAuthHistogram* histogram;
+        unsigned long long errors;
+    };
+
+    Phase phases[] = {
+        { "request_token", &results.requestToken, results.requestTokenErrors },
+        { "access_token", &results.accessToken, results.accessTokenErrors },
+        { "resource", &results.resource, results.resourceErrors }
+    };
+
+    std::cout << "phase,count,errors,p50_ms,p90_ms,p99_ms,max_ms" << std::endl;
+
+    unsigned long long requests = 0;
+
+    for(std::size_t i = 0; i < sizeof(phases) / sizeof(phases[0]); ++i)
+    {
+        ofxOAuthHistogram::Snapshot snapshot = phases[i].histogram->getSnapshot();
+
+        requests += snapshot.count;
+
+        std::cout << phases[i].name << ",";
+        std::cout << snapshot.count << ",";
+        std::cout << phases[i].errors << ",";
+        std::cout << snapshot.getPercentile(0.5) / 1000.0 << ",";
+        std::cout << snapshot.getPercentile(0.9) / 1000.0 << ",";
+        std::cout << snapshot.getPercentile(0.99) / 1000.0 << ",";
+        std::cout << snapshot.max / 1000.0 << std::endl;
+    }
+
+    std::cout << std::endl;
+    std::cout << "clients,requests,seconds,requests_per_second" << std::endl;
+    std::cout << settings.clients << "," << requests << "," << seconds << "," << (seconds > 0 ? requests / seconds : 0) << std::endl;
+
+    ofxOAuthMockProvider::Stats stats = provider.getStats();
+
+    std::map<std::string, unsigned long long>::const_iterator iter = stats.problems.begin();
+
+    for(; iter != stats.problems.end(); ++iter)
+    {
+        ofLogWarning("ofApp::report") << "Provider rejected " << iter->second << " requests with " << iter->first << ".";
+    }
+}
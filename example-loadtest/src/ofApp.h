@@ -0,0 +1,118 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "Poco/Runnable.h"
+#include "Poco/ThreadPool.h"
+#include "ofMain.h"
+#include "ofxOAuthClient.h"
+#include "ofxOAuthHistogram.h"
+#include "ofxOAuthMockProvider.h"
+
+
+// Latencies (in microseconds) and failures, shared by all clients.
+struct LoadResults
+{
+    LoadResults(): requestTokenErrors(0), accessTokenErrors(0), resourceErrors(0), finished(0)
+    {
+    }
+
+    ofxOAuthHistogram requestToken;
+    ofxOAuthHistogram accessToken;
+    ofxOAuthHistogram resource;
+
+    std::atomic<unsigned long long> requestTokenErrors;
+    std::atomic<unsigned long long> accessTokenErrors;
+    std::atomic<unsigned long long> resourceErrors;
+
+    std::atomic<int> finished; //< clients
+};
+
+
+// One user: runs the whole token flow against the mock provider on a pool
+// thread, then makes signed requests back to back.  The flow is driven here,
+// so it is an ofxOAuthClient rather than an ofxOAuth tied to the app loop.
+class LoadClient: public ofxOAuthClient, public Poco::Runnable
+{
+public:
+    LoadClient(int id,
+               int requests,
+               ofxOAuthMockProvider& provider,
+               LoadResults& results);
+
+    void run();
+
+protected:
+    bool authorize();
+
+    int _id;
+    int _requests;
+    ofxOAuthMockProvider& _provider;
+    LoadResults& _results;
+
+};
+
+
+// Starts a mock provider, drives it with many concurrent clients
+// and prints throughput and latency percentiles as CSV when they finish.
+class ofApp: public ofBaseApp
+{
+public:
+    struct Settings
+    {
+        Settings(): clients(32), requestsPerClient(100)
+        {
+        }
+
+        int clients;
+        int requestsPerClient;
+        ofxOAuthMockProvider::Settings provider;
+    };
+
+    ofApp(const Settings& settings);
+
+    void setup();
+    void update();
+    void exit();
+
+    void report();
+
+    Settings settings;
+
+    ofxOAuthMockProvider provider;
+    LoadResults results;
+
+    std::vector<std::shared_ptr<LoadClient> > clients;
+    std::shared_ptr<Poco::ThreadPool> pool;
+
+    Poco::Timestamp startTime;
+    bool isReported;
+
+};
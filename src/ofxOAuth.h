@@ -23,87 +23,42 @@
 // =============================================================================
 
 
+
 #pragma once
 
 
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <oauth.h>
-#include "Poco/String.h"
+#include <memory>
+#include <string>
 #include "ofMain.h"
-#include "ofxXmlSettings.h"
-#include "ofxOAuthVerifierCallbackServer.h"
+#include "ofxOAuthClient.h"
 #include "ofxOAuthVerifierCallbackInterface.h"
+#include "ofxOAuthVerifierCallbackServer.h"
 
 
-class ofxOAuth: public ofxOAuthVerifierCallbackInterface
+// ofxOAuthClient in an openFrameworks app.  The token flow is driven from
+// the update event, the authorization page is opened in the browser and the
+// verifier is received by a local callback server.  Credential and
+// certificate paths are relative to the data folder.
+class ofxOAuth: public ofxOAuthClient, public ofxOAuthVerifierCallbackInterface
 {
 public:
-    enum AuthMethod
-    {
-        OFX_OA_HMAC=0,
-        OFX_OA_RSA,
-        OFX_OA_PLAINTEXT
-    };
-
-    enum AuthHttpMethod
-    {
-        OFX_HTTP_GET,
-        OFX_HTTP_POST
-    };
-
     ofxOAuth();
 
     virtual ~ofxOAuth();
 
-    void setup();
-
-    void setup(const std::string& apiURL,
-               const std::string& consumerKey,
-               const std::string& consumerSecret);
-    
-    void setup(const std::string& apiURL,
-               const std::string& requestTokenUrl,
-               const std::string& accessTokenUrl,
-               const std::string& authorizeUrl,
-               const std::string& consumerKey,
-               const std::string& consumerSecret);
-
     void update(ofEventArgs& args);
-    
-    bool isAuthorized();
 
-    std::string get(const std::string& uri,
-                    const std::string& queryParams = "");
+    using ofxOAuthClient::postfile_multipartdata;
 
-    std::string post(const std::string& uri,
-                     const std::string& queryParams = "");
-    
+    // Posts a file straight from memory (e.g. an encoded frame), without
+    // writing it to disk first.  The data is not copied.
     std::string postfile_multipartdata(const std::string& uri,
-                     const std::string& queryParams = "",
-                     const std::string& filefieldname = "",
-                     const std::string& filepath = "");
-    
-    // getters and setters
-    std::string getApiURL();
-    void setApiURL(const std::string& v, bool autoSetEndpoints = true);
-    
-    std::string getRequestTokenURL();
-    void setRequestTokenURL(const std::string& v);
-    std::string getAccessTokenURL();
-    void setAccessTokenURL(const std::string& v);
-    std::string getAuthorizationURL();
-    void setAuthorizationURL(const std::string& v);
-    std::string getVerifierCallbackURL();
-    void setVerifierCallbackURL(const std::string& v);
+                     const std::string& queryParams,
+                     const std::string& filefieldname,
+                     const ofBuffer& buffer,
+                     const std::string& filename,
+                     const std::string& contentType = "");
 
-    void setApplicationDisplayName(const std::string& v); // xoauth_displayname
-    std::string getApplicationDisplayName();
-    
-    void setApplicationScope(const std::string& v); // google specific
-    std::string getApplicationScope();
-    
     // verifier callback server
     void setEnableVerifierCallbackServer(bool v);
     bool isVerifierCallbackServerEnabled();
@@ -115,127 +70,19 @@ public:
     int getVerifierCallbackServerPort() const;
     void setVerifierCallbackServerPort(int portNumber);
 
-    
-    // request token / secret
-    std::string getRequestToken();
-    void setRequestToken(const std::string& v);
-    std::string getRequestTokenSecret();
-    void setRequestTokenSecret(const string& v);
-    std::string getRequestTokenVerifier();
+    using ofxOAuthClient::setRequestTokenVerifier;
+
     void setRequestTokenVerifier(const std::string& requestToken,
                                  const std::string& requestTokenVerifier);
-    void setRequestTokenVerifier(const std::string& requestTokenVerifier);
-
-    // request access token / secret
-    std::string getAccessToken();
-    void setAccessToken(const std::string& v);
-    std::string getAccessTokenSecret();
-    void setAccessTokenSecret(const std::string& v);
 
-    std::string getScreenName();
-    void setScreenName(const std::string& v);
-    
-    std::string getEncodedUserId();
-    void setEncodedUserId(const std::string& v);
-
-    std::string getUserId();
-    void setUserId(const std::string& v);
-    
-    std::string getEncodedUserPassword();
-    void setEncodedUserPassword(const std::string& v);
+    // Notified, on the requesting thread, when a host's circuit changes state.
+    ofEvent<ofxOAuthCircuitBreaker::Transition> circuitBreakerEvent;
 
-    std::string getUserPassword();
-    void setUserPassword(const std::string& v);
-    
-    // request consumer token / secret
-    std::string getConsumerKey() const;
-    void setConsumerKey(const std::string& v);
-    std::string getConsumerSecret() const;
-    void setConsumerSecret(const std::string& v);
-    
-    void setApiName(const std::string& v);
-    std::string getApiName() const;
-
-    std::map<std::string, std::string> getCustomInfo() const;
-
-    // token verifier
-    std::string getRealm() const;
-    void setRealm(const std::string& v);
-    
-    
-    void setSSLCACertificateFile(const std::string& pathname);
-    
-    
-    void setCredentialsPathname(const std::string& credentials);
-    std::string getCredentialsPathname();
-    
-    void resetErrors();
-    
 protected:
-    
-    void saveCredentials();
-    void loadCredentials();
-
-    AuthMethod getOAuthMethod();
-    void setOAuthMethod(AuthMethod v);
-
-    std::map<std::string,std::string> obtainRequestToken();
-    std::map<std::string,std::string> obtainAccessToken();
-    
-    std::string requestUserVerification(bool launchBrowser = true);
-    std::string requestUserVerification(std::string additionalAuthParams,
-                                        bool launchBrowser = true);
-
-    
-    std::string credentialsPathname;
-    
-    // URLS
-    std::string apiURL;
-    
-    std::string requestTokenURL;
-    std::string accessTokenURL;
-    std::string authorizationURL;
-    std::string verifierCallbackURL;
-
-    std::string applicationDisplayName;
-    std::string applicationScope;
-    
-    bool callbackConfirmed;
-    bool verificationRequested;
-    bool accessFailed;
-    bool accessFailedReported;
-    
-    // keys, secrets and verifiers
-    
-    std::string consumerKey;    // provided by the api for each app
-    std::string consumerSecret; // provided by the api for each app
-    
-    std::string requestToken;         // initially acquired via obtainRequestToken()
-    std::string requestTokenSecret;   // initially acquired via obtainRequestToken()
-    std::string requestTokenVerifier;      // acquired via web server callback or manual entry by user
-
-    // the following
-    std::string apiName;
-    std::string accessToken;          // after requestToken, requestTokenSecret and requestVerifier,
-    std::string accessTokenSecret;
-    std::string encodedUserId;
-
-    std::string screenName;
-    std::string userId;
-    std::string encodedUserPassword;
-    std::string userPassword;
-
-
-    // for dta such as screenName, userId, encodedUserPassword, userPassword, etc.
-    std::map<std::string, std::string> customInfo;
-
-    // other stuff
-    
-    std::string realm;
-    AuthMethod oauthMethod;
-    AuthHttpMethod httpMethod;
-    // where is our ssl cert bundles stored?
-    std::string SSLCACertificateFile;
+    void beginVerification();
+    void endVerification();
+    void launchBrowser(const std::string& url);
+    std::string getDataPath(const std::string& path) const;
 
     // authorization callback server
     bool enableVerifierCallbackServer;
@@ -250,12 +97,4 @@ protected:
     void receivedVerifierCallbackGetParams(const Poco::Net::NameValueCollection& getParams);
     void receivedVerifierCallbackPostParams(const Poco::Net::NameValueCollection& postParams);
 
-    std::string appendQuestionMark(const std::string& url) const;
-
-private:
-    OAuthMethod _getOAuthMethod();
-    std::string _getHttpMethod();
-
-    std::string _old_curlopt_cainfo; 
-    
 };
@@ -0,0 +1,303 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include "Poco/Mutex.h"
+#include "ofxOAuthExecutor.h"
+#include "ofxOAuthLog.h"
+#include "ofxOAuthTransport.h"
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+#define OFX_OAUTH_HAS_COROUTINES 1
+#endif
+
+
+// A request in flight, returned by ofxOAuthClient::requestAsync(),
+// getAsync(), postAsync() and postFileAsync().  The request is already on
+// its way; the response is taken once, either by a continuation:
+//
+//      client.getAsync("/1.1/account/verify_credentials.json").then([](ofxOAuthResponse& response)
+//      {
+//          // ...
+//      }, &client.getUpdateExecutor());
+//
+// or as a future:
+//
+//      std::future<ofxOAuthResponse> reply = client.postAsync("/1.1/statuses/update.json", "status=Hello").getFuture();
+//
+// or, in C++20, by awaiting it from a coroutine:
+//
+//      ofxOAuthCoroutine fetch(ofxOAuthClient& client)
+//      {
+//          ofxOAuthResponse me = co_await client.getAsync("/1.1/account/verify_credentials.json")
+//              .resumeOn(client.getUpdateExecutor());
+//          ofxOAuthResponse timeline = co_await client.getAsync("/1.1/statuses/home_timeline.json");
+//          // ...
+//      }
+//
+// Without an executor the continuation runs on the transport's I/O thread,
+// where it holds up every other transfer; hand anything slow to another
+// executor.
+class ofxOAuthAsyncResponse
+{
+public:
+    typedef std::function<void(ofxOAuthResponse& response)> Continuation;
+
+    // Shared between the handle and the transfer.
+    class State
+    {
+    public:
+        State(): _isDone(false), _executor(0)
+        {
+        }
+
+        // Stores the response and runs the continuation, if there is one.
+        void complete(const ofxOAuthResponse& response)
+        {
+            ofxOAuthExecutor::Task waiter;
+            ofxOAuthExecutor* executor = 0;
+
+            {
+                Poco::Mutex::ScopedLock lock(_mutex);
+                _response = response;
+                _isDone = true;
+                waiter.swap(_waiter);
+                executor = _executor;
+            }
+
+            if(waiter) _dispatch(waiter, executor);
+        }
+
+        // Sets what runs once the response is in; runs it now if it
+        // already is.  Returns false if it ran on the calling thread.
+        bool wait(ofxOAuthExecutor::Task waiter, ofxOAuthExecutor* executor)
+        {
+            {
+                Poco::Mutex::ScopedLock lock(_mutex);
+
+                if(!_isDone)
+                {
+                    _waiter = waiter;
+                    _executor = executor;
+                    return true;
+                }
+            }
+
+            if(0 != executor)
+            {
+                _dispatch(waiter, executor);
+                return true;
+            }
+
+            return false;
+        }
+
+        bool isDone() const
+        {
+            Poco::Mutex::ScopedLock lock(_mutex);
+            return _isDone;
+        }
+
+        // Only valid once done.
+        ofxOAuthResponse& getResponse()
+        {
+            return _response;
+        }
+
+    private:
+        static void _dispatch(ofxOAuthExecutor::Task& waiter, ofxOAuthExecutor* executor)
+        {
+            if(0 != executor)
+            {
+                executor->post(waiter);
+                return;
+            }
+
+            try
+            {
+                waiter();
+            }
+            catch(const std::exception& exc)
+            {
+                ofLogError("ofxOAuthAsyncResponse") << "Continuation failed: " << exc.what();
+            }
+        }
+
+        bool _isDone;
+        ofxOAuthResponse _response;
+        ofxOAuthExecutor::Task _waiter;
+        ofxOAuthExecutor* _executor;
+
+        mutable Poco::Mutex _mutex;
+    };
+
+    ofxOAuthAsyncResponse(): _state(std::make_shared<State>()), _executor(0)
+    {
+    }
+
+    explicit ofxOAuthAsyncResponse(std::shared_ptr<State> state): _state(state), _executor(0)
+    {
+    }
+
+    // An already finished request that was never sent.
+    static ofxOAuthAsyncResponse failed(CURLcode error, const std::string& errorMessage)
+    {
+        ofxOAuthResponse response;
+        response.error = error;
+        response.errorMessage = errorMessage;
+
+        std::shared_ptr<State> state = std::make_shared<State>();
+        state->complete(response);
+        return ofxOAuthAsyncResponse(state);
+    }
+
+    // Calls continuation with the response, on executor (which must outlive
+    // the request), or on the thread that completes it if executor is 0.
+    void then(Continuation continuation, ofxOAuthExecutor* executor = 0)
+    {
+        std::shared_ptr<State> state = _state;
+
+        ofxOAuthExecutor::Task waiter = [state, continuation]()
+        {
+            continuation(state->getResponse());
+        };
+
+        if(!_state->wait(waiter, executor))
+        {
+            waiter();
+        }
+    }
+
+    // A future for the response.  Its get() blocks the calling thread, so
+    // never wait on it from a continuation running on the I/O thread.
+    std::future<ofxOAuthResponse> getFuture()
+    {
+        std::shared_ptr<std::promise<ofxOAuthResponse> > promise = std::make_shared<std::promise<ofxOAuthResponse> >();
+
+        std::future<ofxOAuthResponse> future = promise->get_future();
+
+        then([promise](ofxOAuthResponse& response)
+        {
+            promise->set_value(response);
+        });
+
+        return future;
+    }
+
+    // The executor an awaiting coroutine resumes on.  It must outlive the
+    // request.
+    ofxOAuthAsyncResponse& resumeOn(ofxOAuthExecutor& executor)
+    {
+        _executor = &executor;
+        return *this;
+    }
+
+    bool isReady() const
+    {
+        return _state->isDone();
+    }
+
+    std::shared_ptr<State> getState() const
+    {
+        return _state;
+    }
+
+#if defined(OFX_OAUTH_HAS_COROUTINES)
+    bool await_ready() const
+    {
+        // with an executor, resume there even if the response is in.
+        return 0 == _executor && _state->isDone();
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        return _state->wait([handle]() { handle.resume(); }, _executor);
+    }
+
+    ofxOAuthResponse await_resume()
+    {
+        return _state->getResponse();
+    }
+#endif
+
+private:
+    std::shared_ptr<State> _state;
+    ofxOAuthExecutor* _executor;
+
+};
+
+
+#if defined(OFX_OAUTH_HAS_COROUTINES)
+// A coroutine that starts at once and is not awaited, for running a flow of
+// awaited requests.  An exception that escapes it is logged.
+struct ofxOAuthCoroutine
+{
+    struct promise_type
+    {
+        ofxOAuthCoroutine get_return_object()
+        {
+            return ofxOAuthCoroutine();
+        }
+
+        std::suspend_never initial_suspend() noexcept
+        {
+            return std::suspend_never();
+        }
+
+        std::suspend_never final_suspend() noexcept
+        {
+            return std::suspend_never();
+        }
+
+        void return_void()
+        {
+        }
+
+        void unhandled_exception()
+        {
+            try
+            {
+                throw;
+            }
+            catch(const std::exception& exc)
+            {
+                ofLogError("ofxOAuthCoroutine") << "Unhandled exception: " << exc.what();
+            }
+            catch(...)
+            {
+                ofLogError("ofxOAuthCoroutine") << "Unhandled exception.";
+            }
+        }
+    };
+};
+#endif
@@ -0,0 +1,79 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include <stdio.h>
+#include <string>
+#if defined(_WIN32)
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+
+class ofxOAuthAtomicFile
+{
+public:
+    // Writes data to path + ".tmp", syncs it and renames it over path, so
+    // readers see either the old file or the new one, never a partial one.
+    static bool write(const std::string& path, const std::string& data)
+    {
+        std::string tmpPath = path + ".tmp";
+
+        FILE* file = fopen(tmpPath.c_str(), "wb");
+
+        if(0 == file) return false;
+
+        bool success = fwrite(data.data(), 1, data.size(), file) == data.size();
+        success = (0 == fflush(file)) && success;
+#if defined(_WIN32)
+        success = (0 == _commit(_fileno(file))) && success;
+#else
+        success = (0 == fsync(fileno(file))) && success;
+#endif
+        success = (0 == fclose(file)) && success;
+
+#if defined(_WIN32)
+        // rename() will not replace an existing file on windows, and
+        // removing it first would leave no file at all after a crash.
+        success = success && 0 != MoveFileExA(tmpPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+        success = success && 0 == rename(tmpPath.c_str(), path.c_str());
+#endif
+
+        if(!success)
+        {
+            remove(tmpPath.c_str());
+            return false;
+        }
+
+        return true;
+    }
+
+};
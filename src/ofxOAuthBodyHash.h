@@ -0,0 +1,212 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <list>
+#include <map>
+#include <string>
+#include <oauth.h>
+#include <openssl/evp.h>
+#include "Poco/Mutex.h"
+#include "ofxOAuthUploadSource.h"
+
+
+// Computes the oauth_body_hash parameter (base64 SHA-1 of the body, see
+// http://oauth.googlecode.com/svn/spec/ext/body_hash/1.0/oauth-bodyhash.html)
+// incrementally.  Unlike liboauth's oauth_body_hash_file(), which reads the
+// file with stdio before the upload reads it again, a file is hashed
+// straight from the same ofxOAuthUploadSource mapping that the upload then
+// streams from, so the file only comes off the disk once.
+//
+//      ofxOAuthUploadSource source;
+//      source.openFile(path);
+//      std::string param = ofxOAuthBodyHash::hash(source); // oauth_body_hash=...
+//
+class ofxOAuthBodyHash
+{
+public:
+    // create / destroy rather than new / free: the bundled liboauth links
+    // against OpenSSL 1.0, which lacks the latter; 1.1+ keeps the former as
+    // macros.
+    ofxOAuthBodyHash(): _context(EVP_MD_CTX_create())
+    {
+        reset();
+    }
+
+    virtual ~ofxOAuthBodyHash()
+    {
+        EVP_MD_CTX_destroy(_context);
+    }
+
+    void reset()
+    {
+        EVP_DigestInit_ex(_context, EVP_sha1(), 0);
+    }
+
+    void update(const void* data, std::size_t size)
+    {
+        EVP_DigestUpdate(_context, data, size);
+    }
+
+    // Returns the "oauth_body_hash=..." parameter, not yet url-escaped, in
+    // the same form as oauth_body_hash_data().  Resets the hash.
+    std::string finish()
+    {
+        unsigned int length = 0;
+
+        // oauth_body_hash_encode() frees the digest.
+        unsigned char* digest = static_cast<unsigned char*>(malloc(EVP_MAX_MD_SIZE));
+
+        EVP_DigestFinal_ex(_context, digest, &length);
+
+        std::string result;
+
+        char* param = oauth_body_hash_encode(length, digest);
+
+        if(0 != param)
+        {
+            result = param;
+            free(param);
+        }
+
+        reset();
+
+        return result;
+    }
+
+    // Hashes the whole source, leaving it rewound for the upload.
+    static std::string hash(ofxOAuthUploadSource& source)
+    {
+        ofxOAuthBodyHash bodyHash;
+
+        const std::size_t blockSize = 1024 * 1024;
+
+        for(std::size_t offset = 0; offset < source.size(); offset += blockSize)
+        {
+            std::size_t length = source.size() - offset < blockSize ? source.size() - offset : blockSize;
+            bodyHash.update(source.data() + offset, length);
+        }
+
+        source.rewind();
+
+        return bodyHash.finish();
+    }
+
+    static std::string hash(const void* data, std::size_t size)
+    {
+        ofxOAuthBodyHash bodyHash;
+        bodyHash.update(data, size);
+        return bodyHash.finish();
+    }
+
+private:
+    ofxOAuthBodyHash(const ofxOAuthBodyHash&);
+    ofxOAuthBodyHash& operator = (const ofxOAuthBodyHash&);
+
+    EVP_MD_CTX* _context;
+
+};
+
+
+// Remembers the body hash of recently uploaded files, keyed by path, size
+// and modification time, so that uploading (or retrying) an unchanged file
+// does not hash it again.
+class ofxOAuthBodyHashCache
+{
+public:
+    ofxOAuthBodyHashCache(std::size_t capacity = 64): _capacity(capacity)
+    {
+    }
+
+    virtual ~ofxOAuthBodyHashCache()
+    {
+    }
+
+    // Returns the oauth_body_hash parameter for the file opened in source.
+    std::string get(const std::string& path, ofxOAuthUploadSource& source)
+    {
+        std::string key = _makeKey(path);
+
+        if(key.empty()) return ofxOAuthBodyHash::hash(source);
+
+        {
+            Poco::Mutex::ScopedLock lock(_mutex);
+
+            std::map<std::string, std::string>::iterator iter = _hashes.find(key);
+
+            if(iter != _hashes.end()) return iter->second;
+        }
+
+        std::string param = ofxOAuthBodyHash::hash(source);
+
+        Poco::Mutex::ScopedLock lock(_mutex);
+
+        if(_hashes.insert(std::make_pair(key, param)).second)
+        {
+            _order.push_back(key);
+
+            while(_order.size() > _capacity)
+            {
+                _hashes.erase(_order.front());
+                _order.pop_front();
+            }
+        }
+
+        return param;
+    }
+
+    void clear()
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        _hashes.clear();
+        _order.clear();
+    }
+
+private:
+    static std::string _makeKey(const std::string& path)
+    {
+        struct stat statbuf;
+
+        if(0 != stat(path.c_str(), &statbuf)) return "";
+
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "|%lld|%lld", (long long)statbuf.st_size, (long long)statbuf.st_mtime);
+
+        return path + buffer;
+    }
+
+    std::size_t _capacity;
+    std::map<std::string, std::string> _hashes;
+    std::list<std::string> _order; //< oldest first
+    Poco::Mutex _mutex;
+
+};
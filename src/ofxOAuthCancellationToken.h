@@ -0,0 +1,66 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include <atomic>
+
+
+// Lets another thread abort a request that is in flight.  The transport
+// polls the token from curl's progress callback, which runs at least once a
+// second even while a transfer is stalled, so a cancelled request returns
+// within about a second with CURLE_ABORTED_BY_CALLBACK.
+//
+//      std::shared_ptr<ofxOAuthCancellationToken> token(new ofxOAuthCancellationToken());
+//      ... oauth.request(ofxOAuth::OFX_HTTP_GET, uri, "", "", response, "", token);
+//      ... token->cancel(); // from any thread
+//
+class ofxOAuthCancellationToken
+{
+public:
+    ofxOAuthCancellationToken(): _isCancelled(false)
+    {
+    }
+
+    virtual ~ofxOAuthCancellationToken()
+    {
+    }
+
+    void cancel()
+    {
+        _isCancelled = true;
+    }
+
+    bool isCancelled() const
+    {
+        return _isCancelled;
+    }
+
+private:
+    std::atomic<bool> _isCancelled;
+
+};
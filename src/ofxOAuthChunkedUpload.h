@@ -0,0 +1,729 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Poco/Mutex.h"
+#include "Poco/Runnable.h"
+#include "Poco/Thread.h"
+#include "Poco/Timestamp.h"
+#include "ofxOAuthAtomicFile.h"
+#include "ofxOAuthMultipartForm.h"
+#include "ofxOAuthRetryPolicy.h"
+#include "ofxOAuthTransport.h"
+#include "ofxOAuthUploadSource.h"
+
+
+// Uploads large media through a chunked INIT / APPEND / FINALIZE flow (as
+// used by the Twitter media upload endpoint).  The file is memory-mapped and
+// split into segments; each APPEND is signed separately and several segments
+// are uploaded at once over the transport's pooled connections.  Progress is
+// checkpointed to disk after every segment, so an interrupted upload picks
+// up where it left off the next time upload() is called for the same file.
+// If the server no longer accepts the checkpoint's media id (a 400 or 404
+// to a request naming it, e.g. it has expired), the upload starts over
+// from INIT.  Transport errors, 401, 429 and 5xx replies are retried with
+// jittered exponential backoff, honoring Retry-After.  When FINALIZE
+// reports processing_info, STATUS is polled until the media is ready to
+// use.
+//
+//      ofxOAuthChunkedUpload::Settings settings;
+//      settings.url = "https://upload.twitter.com/1.1/media/upload.json";
+//      settings.mediaType = "video/mp4";
+//
+//      std::string mediaId;
+//      if(oauth.postfile_chunked(settings, ofToDataPath("video.mp4", true), mediaId)) ...
+//
+class ofxOAuthChunkedUpload
+{
+public:
+    // Returns a complete "Authorization: OAuth ..." header for the request.
+    // query holds any form-urlencoded body parameters that must be signed.
+    typedef std::function<std::string(const std::string& method,
+                                      const std::string& url,
+                                      const std::string& query)> Signer;
+
+    // Called from the upload threads with the bytes acknowledged so far.
+    typedef std::function<void(std::size_t sent, std::size_t total)> ProgressCallback;
+
+    struct Settings
+    {
+        Settings():
+            fieldName("media"),
+            segmentSize(4 * 1024 * 1024),
+            concurrency(4),
+            maxAttempts(3),
+            baseDelay(500),
+            maxDelay(30000),
+            waitForProcessing(true),
+            maxProcessingTime(600)
+        {
+        }
+
+        std::string url;
+        std::string mediaType;      //< e.g. video/mp4
+        std::string mediaCategory;  //< optional, e.g. tweet_video
+        std::string fieldName;      //< the APPEND file field
+        std::string checkpointPath; //< defaults to the file path + ".upload"
+        std::size_t segmentSize;
+        std::size_t concurrency;    //< segments in flight at once
+        std::size_t maxAttempts;    //< per request
+        long baseDelay;             //< milliseconds before the first retry
+        long maxDelay;              //< milliseconds, the longest wait
+        bool waitForProcessing;     //< poll STATUS until processing succeeds
+        long maxProcessingTime;     //< seconds to wait for processing
+    };
+
+    ofxOAuthChunkedUpload(ofxOAuthTransport& transport, Signer signer):
+        _transport(transport),
+        _signer(signer),
+        _size(0),
+        _modified(0),
+        _segmentCount(0),
+        _nextSegment(0),
+        _bytesSent(0),
+        _failed(false),
+        _isRejected(false),
+        _random(std::random_device()())
+    {
+    }
+
+    virtual ~ofxOAuthChunkedUpload()
+    {
+    }
+
+    void setProgressCallback(ProgressCallback callback)
+    {
+        _progressCallback = callback;
+    }
+
+    // Blocks until the upload is finalized (and, if asked, processed) or
+    // has failed.  On failure the checkpoint is kept, so calling upload()
+    // again resumes it, unless the server rejected the upload outright.
+    bool upload(const Settings& settings, const std::string& path, std::string& mediaId)
+    {
+        _settings = settings;
+        _checkpointPath = settings.checkpointPath.empty() ? path + ".upload" : settings.checkpointPath;
+        _error.clear();
+        _failed = false;
+
+        if(_settings.segmentSize == 0) _settings.segmentSize = 4 * 1024 * 1024;
+        if(_settings.concurrency == 0) _settings.concurrency = 1;
+        if(_settings.maxAttempts == 0) _settings.maxAttempts = 1;
+
+        if(!_source.openFile(path))
+        {
+            _error = "Unable to open " + path;
+            return false;
+        }
+
+        struct stat statbuf;
+        _modified = (0 == stat(path.c_str(), &statbuf)) ? (long long)statbuf.st_mtime : 0;
+
+        _size = _source.size();
+        _segmentCount = (_size + _settings.segmentSize - 1) / _settings.segmentSize;
+        _completed.clear();
+
+        bool isResumed = _loadCheckpoint();
+        bool success = _run(isResumed);
+
+        // the checkpoint's media id is no longer accepted; start over.
+        if(!success && _isRejected && isResumed)
+        {
+            remove(_checkpointPath.c_str());
+            success = _run(false);
+        }
+
+        _source.close();
+
+        // resuming a rejected upload would only be rejected again.
+        if(success || _isRejected)
+        {
+            remove(_checkpointPath.c_str());
+        }
+
+        if(success)
+        {
+            mediaId = _mediaId;
+        }
+
+        return success;
+    }
+
+    // A description of the last failure.
+    std::string getError() const
+    {
+        return _error;
+    }
+
+    std::size_t getSegmentCount() const
+    {
+        return _segmentCount;
+    }
+
+protected:
+    // Uploads every segment not yet completed and finalizes.  Starts with
+    // INIT unless resuming.
+    bool _run(bool isResumed)
+    {
+        _nextSegment = 0;
+        _bytesSent = 0;
+        _failed = false;
+        _isRejected = false;
+        _error.clear();
+
+        if(!isResumed)
+        {
+            _completed.clear();
+            _mediaId.clear();
+
+            if(!_init()) return false;
+
+            _saveCheckpoint();
+        }
+
+        for(std::set<std::size_t>::const_iterator iter = _completed.begin(); iter != _completed.end(); ++iter)
+        {
+            _bytesSent += _segmentLength(*iter);
+        }
+
+        // a single segment gains nothing from extra threads.
+        std::size_t workers = std::min(_settings.concurrency, _segmentCount - _completed.size());
+
+        if(workers > 0)
+        {
+            std::vector<Worker*> threads;
+
+            for(std::size_t i = 0; i < workers; ++i)
+            {
+                threads.push_back(new Worker(*this));
+                threads.back()->thread.start(*threads.back());
+            }
+
+            for(std::size_t i = 0; i < threads.size(); ++i)
+            {
+                threads[i]->thread.join();
+                delete threads[i];
+            }
+        }
+
+        return !_failed && _finalize();
+    }
+
+    class Worker: public Poco::Runnable
+    {
+    public:
+        Worker(ofxOAuthChunkedUpload& upload): _upload(upload)
+        {
+        }
+
+        void run()
+        {
+            _upload._work();
+        }
+
+        Poco::Thread thread;
+
+    private:
+        ofxOAuthChunkedUpload& _upload;
+    };
+
+    void _work()
+    {
+        std::size_t index = 0;
+
+        while(_takeSegment(index))
+        {
+            if(!_append(index))
+            {
+                Poco::Mutex::ScopedLock lock(_mutex);
+                _failed = true;
+                return;
+            }
+
+            std::size_t sent = 0;
+
+            {
+                Poco::Mutex::ScopedLock lock(_mutex);
+                _completed.insert(index);
+                _bytesSent += _segmentLength(index);
+                sent = _bytesSent;
+                _saveCheckpoint();
+            }
+
+            if(_progressCallback) _progressCallback(sent, _size);
+        }
+    }
+
+    bool _takeSegment(std::size_t& index)
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+
+        while(!_failed && _nextSegment < _segmentCount)
+        {
+            index = _nextSegment++;
+            if(_completed.find(index) == _completed.end()) return true;
+        }
+
+        return false;
+    }
+
+    std::size_t _segmentLength(std::size_t index) const
+    {
+        std::size_t offset = index * _settings.segmentSize;
+        return std::min(_settings.segmentSize, _size - offset);
+    }
+
+    bool _init()
+    {
+        std::stringstream query;
+        query << "command=INIT&total_bytes=" << _size;
+        query << "&media_type=" << _encode(_settings.mediaType);
+
+        if(!_settings.mediaCategory.empty())
+        {
+            query << "&media_category=" << _encode(_settings.mediaCategory);
+        }
+
+        ofxOAuthResponse response;
+
+        if(!_send("POST", query.str(), response)) return false;
+
+        _mediaId = _findString(response.body, "media_id_string");
+
+        if(_mediaId.empty())
+        {
+            _error = "INIT did not return a media id: " + response.body;
+            return false;
+        }
+
+        return true;
+    }
+
+    bool _append(std::size_t index)
+    {
+        std::stringstream segment;
+        segment << index;
+
+        for(std::size_t attempt = 0; attempt < _settings.maxAttempts; ++attempt)
+        {
+            // the segment is sent straight from the mapping.
+            ofxOAuthMultipartForm form;
+            form.addField("command", "APPEND");
+            form.addField("media_id", _mediaId);
+            form.addField("segment_index", segment.str());
+            form.addBuffer(_settings.fieldName,
+                           _source.data() + index * _settings.segmentSize,
+                           _segmentLength(index),
+                           "blob",
+                           "application/octet-stream");
+
+            ofxOAuthRequest request;
+            request.method = "POST";
+            request.url = _settings.url;
+            request.form = &form;
+
+            // multipart bodies are not part of the signature base string.
+            request.headers.push_back(_sign("POST", _settings.url, ""));
+
+            ofxOAuthResponse response;
+
+            _transport.perform(request, response);
+
+            Outcome outcome = _getOutcome(response, true);
+
+            if(outcome == SUCCEEDED) return true;
+
+            _setError("APPEND " + segment.str(), response);
+
+            if(outcome == REJECTED)
+            {
+                Poco::Mutex::ScopedLock lock(_mutex);
+                _isRejected = true;
+                break;
+            }
+
+            if(outcome == FAILED || !_backoff(attempt, response)) break;
+        }
+
+        return false;
+    }
+
+    bool _finalize()
+    {
+        ofxOAuthResponse response;
+
+        if(!_send("POST", "command=FINALIZE&media_id=" + _encode(_mediaId), response))
+        {
+            return false;
+        }
+
+        if(!_settings.waitForProcessing) return true;
+
+        // e.g. "processing_info":{"state":"pending","check_after_secs":5}
+        Poco::Timestamp start;
+
+        for(;;)
+        {
+            std::string state = _findString(response.body, "state");
+
+            if(state.empty() || state == "succeeded") return true;
+
+            if(state == "failed")
+            {
+                _setError("Processing", response);
+                _isRejected = true;
+                return false;
+            }
+
+            long wait = atol(_findString(response.body, "check_after_secs").c_str());
+
+            if(wait <= 0) wait = 1;
+
+            if(start.elapsed() / 1000000 + wait > _settings.maxProcessingTime)
+            {
+                _setError("Processing (still " + state + ")", response);
+                return false;
+            }
+
+            Poco::Thread::sleep(wait * 1000);
+
+            if(!_send("GET", "command=STATUS&media_id=" + _encode(_mediaId), response))
+            {
+                return false;
+            }
+        }
+    }
+
+    // A form POST, or a GET with the query in the url.
+    bool _send(const std::string& method, const std::string& query, ofxOAuthResponse& response)
+    {
+        for(std::size_t attempt = 0; attempt < _settings.maxAttempts; ++attempt)
+        {
+            ofxOAuthRequest request;
+            request.method = method;
+
+            if(method == "GET")
+            {
+                request.url = _settings.url + "?" + query;
+            }
+            else
+            {
+                request.url = _settings.url;
+                request.body = query;
+                request.headers.push_back("Content-Type: application/x-www-form-urlencoded");
+            }
+
+            request.headers.push_back(_sign(method, _settings.url, query));
+
+            response = ofxOAuthResponse();
+
+            _transport.perform(request, response);
+
+            // INIT has no media id to reject yet.
+            Outcome outcome = _getOutcome(response, !_mediaId.empty());
+
+            if(outcome == SUCCEEDED) return true;
+
+            _setError(query.substr(0, query.find('&')), response);
+
+            if(outcome == REJECTED)
+            {
+                _isRejected = true;
+                break;
+            }
+
+            if(outcome == FAILED || !_backoff(attempt, response)) break;
+        }
+
+        return false;
+    }
+
+    enum Outcome
+    {
+        SUCCEEDED,
+        RETRY,    //< may go away: transport errors, 401, 429, 5xx
+        FAILED,   //< will not go away, but the media id is still good
+        REJECTED  //< the media id is unknown or has expired
+    };
+
+    static Outcome _getOutcome(const ofxOAuthResponse& response, bool hasMediaId)
+    {
+        if(!response.isComplete())
+        {
+            return response.isCancelled() ? FAILED : RETRY;
+        }
+
+        if(response.status >= 200 && response.status < 300) return SUCCEEDED;
+
+        // a 401 is signed again, with a fresh nonce and timestamp.
+        if(response.status == 401 || response.status == 429 || response.status >= 500)
+        {
+            return RETRY;
+        }
+
+        // on a request naming a media id, these are about the media id.
+        if(hasMediaId && (response.status == 400 || response.status == 404))
+        {
+            return REJECTED;
+        }
+
+        return FAILED;
+    }
+
+    // Waits before the next attempt: exponential from baseDelay, jittered,
+    // at least any Retry-After.  Returns false, without waiting, if there
+    // is no next attempt or another segment has already failed.
+    bool _backoff(std::size_t attempt, const ofxOAuthResponse& response)
+    {
+        if(attempt + 1 >= _settings.maxAttempts) return false;
+
+        long delay = _settings.baseDelay;
+
+        for(std::size_t i = 0; i < attempt && delay < _settings.maxDelay; ++i)
+        {
+            delay *= 2;
+        }
+
+        delay = std::max(0L, std::min(delay, _settings.maxDelay));
+
+        {
+            Poco::Mutex::ScopedLock lock(_mutex);
+            std::uniform_int_distribution<long> distribution(delay / 2, delay);
+            delay = distribution(_random);
+        }
+
+        delay = std::max(delay, std::min(_settings.maxDelay, ofxOAuthRetryPolicy::getRetryAfter(response)));
+
+        const long slice = 50;
+
+        while(delay > 0)
+        {
+            {
+                Poco::Mutex::ScopedLock lock(_mutex);
+                if(_failed) return false;
+            }
+
+            long step = std::min(slice, delay);
+            Poco::Thread::sleep(step);
+            delay -= step;
+        }
+
+        return true;
+    }
+
+    std::string _sign(const std::string& method, const std::string& url, const std::string& query)
+    {
+        // liboauth's nonce generation is not thread safe.
+        Poco::Mutex::ScopedLock lock(_signerMutex);
+        return _signer(method, url, query);
+    }
+
+    void _setError(const std::string& what, const ofxOAuthResponse& response)
+    {
+        std::stringstream ss;
+
+        if(response.isComplete())
+        {
+            ss << what << " failed with status " << response.status << ": " << response.body;
+        }
+        else
+        {
+            ss << what << " failed: " << response.errorMessage;
+        }
+
+        Poco::Mutex::ScopedLock lock(_mutex);
+        _error = ss.str();
+    }
+
+    // The checkpoint is a small key=value file, e.g.
+    //
+    //      media_id=710511363345354753
+    //      size=104857600
+    //      modified=1461690000
+    //      segment_size=4194304
+    //      completed=0,1,2,5
+    //
+    // It is only used if the file and segment size are unchanged.
+    bool _loadCheckpoint()
+    {
+        FILE* file = fopen(_checkpointPath.c_str(), "rb");
+
+        if(0 == file) return false;
+
+        std::string mediaId;
+        std::string completed;
+        long long size = -1;
+        long long checkpointModified = -1;
+        long long segmentSize = -1;
+
+        char line[4096];
+
+        while(fgets(line, sizeof(line), file))
+        {
+            std::string text(line);
+            text.erase(text.find_last_not_of("\r\n") + 1);
+
+            std::string::size_type equals = text.find('=');
+            if(equals == std::string::npos) continue;
+
+            std::string key = text.substr(0, equals);
+            std::string value = text.substr(equals + 1);
+
+            if(key == "media_id") mediaId = value;
+            else if(key == "size") size = atoll(value.c_str());
+            else if(key == "modified") checkpointModified = atoll(value.c_str());
+            else if(key == "segment_size") segmentSize = atoll(value.c_str());
+            else if(key == "completed") completed = value;
+        }
+
+        fclose(file);
+
+        if(mediaId.empty() ||
+           size != (long long)_size ||
+           checkpointModified != _modified ||
+           segmentSize != (long long)_settings.segmentSize)
+        {
+            return false;
+        }
+
+        _mediaId = mediaId;
+
+        std::stringstream ss(completed);
+        std::string index;
+
+        while(std::getline(ss, index, ','))
+        {
+            if(index.empty()) continue;
+
+            std::size_t i = static_cast<std::size_t>(atoll(index.c_str()));
+            if(i < _segmentCount) _completed.insert(i);
+        }
+
+        return true;
+    }
+
+    bool _saveCheckpoint()
+    {
+        std::stringstream ss;
+        ss << "media_id=" << _mediaId << "\n";
+        ss << "size=" << _size << "\n";
+        ss << "modified=" << _modified << "\n";
+        ss << "segment_size=" << _settings.segmentSize << "\n";
+        ss << "completed=";
+
+        for(std::set<std::size_t>::const_iterator iter = _completed.begin(); iter != _completed.end(); ++iter)
+        {
+            if(iter != _completed.begin()) ss << ",";
+            ss << *iter;
+        }
+
+        ss << "\n";
+
+        return ofxOAuthAtomicFile::write(_checkpointPath, ss.str());
+    }
+
+    static std::string _encode(const std::string& value)
+    {
+        static const char* hex = "0123456789ABCDEF";
+
+        std::string result;
+
+        for(std::size_t i = 0; i < value.size(); ++i)
+        {
+            unsigned char c = static_cast<unsigned char>(value[i]);
+
+            if(isalnum(c) || c == '-' || c == '.' || c == '_' || c == '~')
+            {
+                result += static_cast<char>(c);
+            }
+            else
+            {
+                result += '%';
+                result += hex[c >> 4];
+                result += hex[c & 15];
+            }
+        }
+
+        return result;
+    }
+
+    // Finds "key":"value" (or "key":value) in a flat JSON reply.
+    static std::string _findString(const std::string& json, const std::string& key)
+    {
+        std::string::size_type pos = json.find("\"" + key + "\"");
+
+        if(pos == std::string::npos) return "";
+
+        pos = json.find(':', pos + key.size() + 2);
+
+        if(pos == std::string::npos) return "";
+
+        pos = json.find_first_not_of(" \t\r\n\"", pos + 1);
+
+        if(pos == std::string::npos) return "";
+
+        std::string::size_type end = json.find_first_of("\",} \t\r\n", pos);
+
+        return json.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+    }
+
+    ofxOAuthTransport& _transport;
+    Signer _signer;
+    ProgressCallback _progressCallback;
+
+    Settings _settings;
+    std::string _checkpointPath;
+    ofxOAuthUploadSource _source;
+
+    std::string _mediaId;
+    std::size_t _size;
+    long long _modified;
+    std::size_t _segmentCount;
+    std::size_t _nextSegment;
+    std::size_t _bytesSent;
+    std::set<std::size_t> _completed;
+    bool _failed;
+    bool _isRejected; //< the media id is no longer accepted, or processing failed
+    std::string _error;
+    std::mt19937 _random; //< backoff jitter, guarded by _mutex
+
+    Poco::Mutex _mutex;
+    Poco::Mutex _signerMutex;
+
+};
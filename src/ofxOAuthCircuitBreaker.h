@@ -0,0 +1,380 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include <stddef.h>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include "Poco/Mutex.h"
+#include "Poco/Timestamp.h"
+
+
+// Stops sending requests to a host that is failing, so callers get an
+// error right away instead of each waiting out a connect or a timeout.
+//
+// A host's circuit opens after failureThreshold consecutive failures, or
+// when the error rate over its last windowSize requests (once there are
+// at least minSamples) reaches errorRateThreshold.  While open, requests
+// are refused without touching the network.  After openDuration one probe
+// request is let through (half-open): if it succeeds the circuit closes,
+// otherwise it opens for another openDuration.
+//
+// Failures are transport errors and 5xx replies.  Cancelled requests are
+// not counted either way.
+class ofxOAuthCircuitBreaker
+{
+public:
+    enum State
+    {
+        CLOSED = 0,
+        OPEN,
+        HALF_OPEN
+    };
+
+    enum Outcome
+    {
+        SUCCESS = 0,
+        FAILURE,
+        IGNORED
+    };
+
+    struct Settings
+    {
+        Settings():
+            enabled(true),
+            failureThreshold(5),
+            errorRateThreshold(0.5),
+            windowSize(20),
+            minSamples(10),
+            openDuration(30000)
+        {
+        }
+
+        bool enabled;
+        std::size_t failureThreshold; //< consecutive failures
+        double errorRateThreshold;    //< 0 - 1, over the window
+        std::size_t windowSize;       //< requests
+        std::size_t minSamples;       //< requests in the window before the rate counts
+        long openDuration;            //< milliseconds before a probe
+    };
+
+    struct Stats
+    {
+        Stats():
+            state(CLOSED),
+            requests(0),
+            failures(0),
+            rejected(0),
+            trips(0)
+        {
+        }
+
+        std::string host;
+        State state;
+        unsigned long long requests;
+        unsigned long long failures;
+        unsigned long long rejected; //< requests refused while open
+        unsigned long long trips;    //< times the circuit opened
+    };
+
+    struct Transition
+    {
+        std::string host;
+        State from;
+        State to;
+    };
+
+    // Called on the requesting thread, outside the breaker's lock.
+    typedef std::function<void(const Transition& transition)> Listener;
+
+    ofxOAuthCircuitBreaker()
+    {
+    }
+
+    virtual ~ofxOAuthCircuitBreaker()
+    {
+    }
+
+    void setSettings(const Settings& settings)
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        _settings = settings;
+    }
+
+    Settings getSettings() const
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        return _settings;
+    }
+
+    void setListener(Listener listener)
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        _listener = listener;
+    }
+
+    // Returns false if a request to host must not be sent.  A true return
+    // must be followed by record() for the same host.
+    bool allow(const std::string& host)
+    {
+        Transition transition;
+        Listener listener;
+        bool allowed = true;
+
+        {
+            Poco::Mutex::ScopedLock lock(_mutex);
+
+            if(!_settings.enabled) return true;
+
+            _Circuit& circuit = _circuits[host];
+            circuit.stats.host = host;
+
+            transition.host = host;
+            transition.from = circuit.stats.state;
+
+            if(circuit.stats.state == OPEN &&
+               circuit.openedAt.isElapsed(static_cast<Poco::Timestamp::TimeDiff>(_settings.openDuration) * 1000))
+            {
+                circuit.stats.state = HALF_OPEN;
+                circuit.isProbing = false;
+            }
+
+            if(circuit.stats.state == OPEN ||
+               (circuit.stats.state == HALF_OPEN && circuit.isProbing))
+            {
+                ++circuit.stats.rejected;
+                allowed = false;
+            }
+            else
+            {
+                if(circuit.stats.state == HALF_OPEN) circuit.isProbing = true;
+                ++circuit.stats.requests;
+            }
+
+            transition.to = circuit.stats.state;
+            listener = _listener;
+        }
+
+        if(transition.from != transition.to && listener) listener(transition);
+
+        return allowed;
+    }
+
+    void record(const std::string& host, Outcome outcome)
+    {
+        Transition transition;
+        Listener listener;
+
+        {
+            Poco::Mutex::ScopedLock lock(_mutex);
+
+            if(!_settings.enabled) return;
+
+            std::map<std::string, _Circuit>::iterator iter = _circuits.find(host);
+
+            if(iter == _circuits.end()) return;
+
+            _Circuit& circuit = iter->second;
+
+            transition.host = host;
+            transition.from = circuit.stats.state;
+
+            if(circuit.stats.state == HALF_OPEN)
+            {
+                circuit.isProbing = false;
+
+                if(outcome == SUCCESS)
+                {
+                    circuit.stats.state = CLOSED;
+                    circuit.consecutiveFailures = 0;
+                    circuit.window.clear();
+                    circuit.windowFailures = 0;
+                }
+                else if(outcome == FAILURE)
+                {
+                    ++circuit.stats.failures;
+                    _open(circuit);
+                }
+            }
+            else if(outcome != IGNORED)
+            {
+                _push(circuit, outcome == FAILURE);
+
+                if(outcome == FAILURE)
+                {
+                    ++circuit.stats.failures;
+                    ++circuit.consecutiveFailures;
+                }
+                else
+                {
+                    circuit.consecutiveFailures = 0;
+                }
+
+                if(circuit.stats.state == CLOSED && _shouldOpen(circuit)) _open(circuit);
+            }
+
+            transition.to = circuit.stats.state;
+            listener = _listener;
+        }
+
+        if(transition.from != transition.to && listener) listener(transition);
+    }
+
+    State getState(const std::string& host) const
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        std::map<std::string, _Circuit>::const_iterator iter = _circuits.find(host);
+        return iter == _circuits.end() ? CLOSED : iter->second.stats.state;
+    }
+
+    // One entry per host seen so far.
+    std::vector<Stats> getStats() const
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+
+        std::vector<Stats> stats;
+
+        std::map<std::string, _Circuit>::const_iterator iter = _circuits.begin();
+
+        for(; iter != _circuits.end(); ++iter)
+        {
+            stats.push_back(iter->second.stats);
+        }
+
+        return stats;
+    }
+
+    // Closes every circuit and forgets their history.
+    void reset()
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        _circuits.clear();
+    }
+
+    static std::string toString(State state)
+    {
+        switch(state)
+        {
+            case OPEN:
+                return "open";
+            case HALF_OPEN:
+                return "half-open";
+            default:
+                return "closed";
+        }
+    }
+
+    // "host:port" of an absolute url, the key circuits are kept under.
+    static std::string getHost(const std::string& url)
+    {
+        std::string::size_type begin = url.find("://");
+
+        begin = (begin == std::string::npos) ? 0 : begin + 3;
+
+        std::string::size_type end = url.find_first_of("/?#", begin);
+
+        std::string authority = url.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+
+        std::string::size_type at = authority.rfind('@');
+
+        return (at == std::string::npos) ? authority : authority.substr(at + 1);
+    }
+
+protected:
+    struct _Circuit
+    {
+        _Circuit():
+            consecutiveFailures(0),
+            windowFailures(0),
+            next(0),
+            isProbing(false)
+        {
+        }
+
+        Stats stats;
+        std::size_t consecutiveFailures;
+        std::vector<bool> window; //< ring of the last outcomes, true for failures
+        std::size_t windowFailures;
+        std::size_t next;
+        bool isProbing;
+        Poco::Timestamp openedAt;
+    };
+
+    void _push(_Circuit& circuit, bool isFailure)
+    {
+        if(_settings.windowSize == 0) return;
+
+        if(circuit.window.size() < _settings.windowSize)
+        {
+            circuit.window.push_back(isFailure);
+        }
+        else
+        {
+            std::size_t i = circuit.next % circuit.window.size();
+            if(circuit.window[i]) --circuit.windowFailures;
+            circuit.window[i] = isFailure;
+        }
+
+        if(isFailure) ++circuit.windowFailures;
+
+        circuit.next = (circuit.next + 1) % _settings.windowSize;
+    }
+
+    bool _shouldOpen(const _Circuit& circuit) const
+    {
+        if(_settings.failureThreshold > 0 &&
+           circuit.consecutiveFailures >= _settings.failureThreshold)
+        {
+            return true;
+        }
+
+        return circuit.window.size() >= _settings.minSamples &&
+               !circuit.window.empty() &&
+               circuit.windowFailures >= _settings.errorRateThreshold * circuit.window.size();
+    }
+
+    void _open(_Circuit& circuit)
+    {
+        circuit.stats.state = OPEN;
+        ++circuit.stats.trips;
+        circuit.openedAt.update();
+        circuit.consecutiveFailures = 0;
+        circuit.window.clear();
+        circuit.windowFailures = 0;
+        circuit.next = 0;
+    }
+
+    Settings _settings;
+    Listener _listener;
+    std::map<std::string, _Circuit> _circuits;
+
+    mutable Poco::Mutex _mutex;
+
+};
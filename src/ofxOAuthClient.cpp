@@ -0,0 +1,2710 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#include "ofxOAuthClient.h"
+
+#include <curl/curl.h>
+#include <sys/stat.h>
+
+#define OAUTH_USER_AGENT "liboauth-agent/1.0.1"
+
+
+
+ofxOAuthClient::ofxOAuthClient()
+{
+    oauthMethod = OFX_OA_HMAC;  // default
+    httpMethod  = OFX_HTTP_GET; // default
+
+    const char* v = getenv("CURLOPT_CAINFO");
+    
+    if(0 != v) _old_curlopt_cainfo = v;
+
+    // this Certificate Authority bundle is extracted 
+    // from mozilla.org.pem, which can be found here
+    //
+    // http://curl.haxx.se/ca/
+    // http://curl.haxx.se/ca/cacert.pem
+    //
+    // If it is not placed in the default (PROJECT)/data/
+    // directory, an different location can 
+    // can be set by calling:
+    
+    // std::cout << "OLD_CURLOPT_CAINFO" << getenv("CURLOPT_CAINFO") << std::endl;
+
+    // setSSLCACertificateFile("cacert.pem");
+    setSSLCACertificateFile("certdata.txt");
+
+    // std::cout << "NEW_CURLOPT_CAINFO" << getenv("CURLOPT_CAINFO") << std::endl;
+    
+    // this setter sets an environmental variable,
+    // which is accessed by liboauth whenever libcurl
+    // calls are executed.
+    
+    transport.setUserAgent(OAUTH_USER_AGENT);
+    transport.setObserver([this](const ofxOAuthRequest& request, const ofxOAuthResponse& response)
+    {
+        clock.observe(response);
+        metrics.record(request, response);
+    });
+    metrics.setCircuitBreaker(&transport.getCircuitBreaker());
+    transport.getCircuitBreaker().setListener([this](const ofxOAuthCircuitBreaker::Transition& transition)
+    {
+        ofLogNotice("ofxOAuthClient") << "Circuit for " << transition.host << " is " << ofxOAuthCircuitBreaker::toString(transition.to) << ".";
+    });
+    retryPolicy.setCorrector([this](const ofxOAuthResponse& response)
+    {
+        if(!clock.correct(response)) return false;
+
+        ofLogWarning("ofxOAuthClient") << "Timestamp refused, signing again with a clock offset of " << clock.getOffset() << " s.";
+        return true;
+    });
+#ifdef OAUTH_CURL_TIMEOUT
+    transport.setTimeouts(0, OAUTH_CURL_TIMEOUT * 1000L);
+#endif
+    requestCoalescingEnabled = true;
+    bodyHashEnabled = false;
+
+    callbackConfirmed = false;
+    
+    verificationRequested = false;
+    accessFailed = false;
+    accessFailedReported = false;
+    
+    apiName = "GENERIC"; 
+    
+    credentialsPathname = "credentials.xml";
+}
+
+
+ofxOAuthClient::~ofxOAuthClient()
+{
+    // be nice and set it back, if there was 
+    // something there when we started.
+    // if(!_old_curlopt_cainfo.empty())
+    // {
+    //     setenv("CURLOPT_CAINFO",_old_curlopt_cainfo.c_str(),true);
+    // }
+    // else
+    // {
+    //     unsetenv("CURLOPT_CAINFO");
+    // }
+
+    stopMetricsServer();
+
+    // asynchronous completions call back into the client (single-flight),
+    // so they end while it is still whole.
+    transport.stop();
+
+    // the transport, and its breaker, go before the metrics.
+    metrics.setCircuitBreaker(0);
+
+    // make sure the last save makes it to disk.
+    credentialWriter.stop();
+}
+
+
+void ofxOAuthClient::setup()
+{
+    loadCredentials();
+}
+
+//------------------------------------------------------------------------------
+void ofxOAuthClient::setup(const std::string& _apiURL,
+                           const std::string& _requestTokenUrl,
+                           const std::string& _accessTokenUrl,
+                           const std::string& _authorizeUrl,
+                           const std::string& _consumerKey,
+                           const std::string& _consumerSecret)
+{
+    setApiURL(_apiURL,false);
+    setRequestTokenURL(_requestTokenUrl);
+    setAccessTokenURL(_accessTokenUrl);
+    setAuthorizationURL(_authorizeUrl);
+    setConsumerKey(_consumerKey);
+    setConsumerSecret(_consumerSecret);
+
+    loadCredentials();
+}
+
+
+void ofxOAuthClient::setup(const std::string& _apiURL,
+                           const std::string& _consumerKey,
+                           const std::string& _consumerSecret)
+{
+    setApiURL(_apiURL);
+    setConsumerKey(_consumerKey);
+    setConsumerSecret(_consumerSecret);
+
+    loadCredentials();
+}
+
+
+void ofxOAuthClient::update()
+{
+    // continuations of asynchronous requests that asked for this thread.
+    updateExecutor.poll();
+
+    if(accessFailed)
+    {
+        if(!accessFailedReported)
+        {
+            ofLogError("ofxOAuthClient::update") << "Access failed.";
+            accessFailedReported = true;
+        }
+    }
+    else if(accessToken.empty() || accessTokenSecret.empty())
+    {
+        if(requestTokenVerifier.empty())
+        {
+            if(requestToken.empty())
+            {
+                beginVerification();
+
+                obtainRequestToken();
+            }
+            else
+            {
+                if(!verificationRequested)
+                {
+                    requestUserVerification();
+                    verificationRequested = true;
+                    ofLogVerbose("ofxOAuthClient::update") << "Waiting for user verification (need the pin number / requestTokenVerifier!)";
+                    ofLogVerbose("ofxOAuthClient::update") << "\t\tIf the server is enabled, then this will happen as soon as the user is redirected.";
+                    ofLogVerbose("ofxOAuthClient::update") << "\t\tIf the server is disabled, verification must be done via 'oob'";
+                    ofLogVerbose("ofxOAuthClient::update") << "\t\t(Out-of-band OAuth authentication). Call setRequestTokenVerifier()";
+                    ofLogVerbose("ofxOAuthClient::update") << "\t\twith a verification code to continue.";
+                }
+                else
+                {
+                    // nichts
+                }
+            }
+        }
+        else
+        {
+            if(!accessFailed)
+            {
+                verificationRequested = false;
+                endVerification();
+                obtainAccessToken();
+            }
+        } 
+    }
+    else
+    {
+        endVerification();
+    }
+}
+
+
+std::string ofxOAuthClient::get(const std::string& uri,
+                                const std::string& query,
+                                const ofxOAuthRequestOptions& options)
+{
+    std::string result = "";
+        
+    if(apiURL.empty())
+    {
+        ofLogError("ofxOAuthClient::get") << "No api URL specified.";
+        return result;
+    }
+    
+    if(consumerKey.empty())
+    {
+        ofLogError("ofxOAuthClient::get") << "No consumer key specified.";
+        return result;
+    }
+    
+    if(consumerSecret.empty())
+    {
+        ofLogError("ofxOAuthClient::get") << "No consumer secret specified.";
+        return result;
+    }
+    
+    if(accessToken.empty())
+    {
+        ofLogError("ofxOAuthClient::get") << "No access token specified.";
+        return result;
+    }
+
+    if(accessTokenSecret.empty())
+    {
+        ofLogError("ofxOAuthClient::get") << "No access token secret specified.";
+        return result;
+    }
+
+    std::string req_url;
+    std::string req_hdr;
+    std::string http_hdr;
+    
+    std::string reply;
+    
+    // oauth_sign_url2 (see oauth.h) in steps
+    int  argc   = 0;
+    char **argv = 0;
+    
+    // break apart the url parameters to they can be signed below
+    // if desired we can also pass in additional patermeters (like oath* params)
+    // here.  For instance, if ?oauth_callback=XXX is defined in this url,
+    // it will be parsed and used in the Authorization header.
+    
+    std::string url = apiURL + uri + "?" + query;
+    
+    Poco::Timestamp signStart;
+
+    argc = oauth_split_url_parameters(url.c_str(), &argv);
+    
+    // sign in server time, if our clock is known to be off.
+    _addTimestamp(&argc, &argv);
+
+    // sign the array.
+    oauth_sign_array2_process(&argc, 
+                              &argv,
+                              0, //< postargs (unused)
+                              _getOAuthMethod(), // hash type, OA_HMAC, OA_RSA, OA_PLAINTEXT
+                              _getHttpMethod().c_str(), //< HTTP method (defaults to "GET")
+                              consumerKey.c_str(), //< consumer key - posted plain text
+                              consumerSecret.c_str(), //< consumer secret - used as 1st part of secret-key
+                              accessToken.c_str(),  //< token key - posted plain text in URL
+                              accessTokenSecret.c_str()); //< token secret - used as 2st part of secret-key
+    
+    ofLogVerbose("ofxOAuthClient::get") << "-------------------";
+    ofLogVerbose("ofxOAuthClient::get") << "consumerKey          >" << consumerKey << "<";
+    ofLogVerbose("ofxOAuthClient::get") << "consumerSecret       >" << consumerSecret << "<";
+    ofLogVerbose("ofxOAuthClient::get") << "requestToken         >" << requestToken << "<";
+    ofLogVerbose("ofxOAuthClient::get") << "requestTokenVerifier >" << requestTokenVerifier << "<";
+    ofLogVerbose("ofxOAuthClient::get") << "requestTokenSecret   >" << requestTokenSecret << "<";
+    ofLogVerbose("ofxOAuthClient::get") << "accessToken          >" << accessToken << "<";
+    ofLogVerbose("ofxOAuthClient::get") << "accessTokenSecret    >" << accessTokenSecret << "<";
+    ofLogVerbose("ofxOAuthClient::get") << "-------------------";
+
+    // collect any parameters in our list that need to be placed in the request URI
+    char* p_req_url = oauth_serialize_url_sep(argc, 0, argv, const_cast<char *>("&"), 1);
+
+    if(0 != p_req_url)
+    {
+        req_url = p_req_url;
+        free(p_req_url);
+    }
+
+    // collect any of the oauth parameters for inclusion in the HTTP Authorization header.
+    char* p_req_hdr = oauth_serialize_url_sep(argc, 1, argv, const_cast<char *>(", "), 6); // const_cast<char *>() is to avoid Deprecated
+
+    if(0 != p_req_hdr)
+    {
+        req_hdr = p_req_hdr;
+        free(p_req_hdr);
+    }
+
+    // look at url parameters to be signed if you want.
+    if(ofGetLogLevel() <= OF_LOG_VERBOSE)
+        for (int i=0;i<argc; i++) ofLogVerbose("ofxOAuthClient::get") << " : " << i << ":" << argv[i];
+    
+    // free our parameter arrays that were allocated during parsing above    
+    oauth_free_array(&argc, &argv);
+
+    metrics.record(ofxOAuthMetrics::getEndpoint(url), ofxOAuthMetrics::SIGN, signStart.elapsed());
+    
+    // construct the Authorization header.  Include realm information if available.
+    if(!realm.empty())
+    {
+        // Note that (optional) 'realm' is not to be 
+        // included in the oauth signed parameters and thus only added here.
+        // see 9.1.1 in http://oauth.net/core/1.0/#anchor14
+        http_hdr = "Authorization: OAuth realm=\"" + realm + "\", " + req_hdr; 
+    }
+    else
+    {
+        http_hdr = "Authorization: OAuth " + req_hdr; 
+    }
+    
+    ofLogVerbose("ofxOAuthClient::get") << "request URL    >" << req_url << "<";
+    ofLogVerbose("ofxOAuthClient::get") << "request HEADER >" << req_hdr << "<";
+    ofLogVerbose("ofxOAuthClient::get") << "http    HEADER >" << http_hdr << "<";
+
+    ofxOAuthRequest request;
+    request.method = "GET";
+    request.url = req_url;
+    request.headers.push_back(http_hdr); // Authorization header is included here
+    options.apply(request);
+
+    // req_url holds no oauth_* parameters, so it identifies the resource
+    // independent of nonce, timestamp and signature.
+    std::string key = ofxOAuthResponseCache::makeKey(request.method, req_url, accessToken);
+
+    ofxOAuthResponse response;
+
+    // a hedged duplicate is signed again, with a fresh nonce and timestamp.
+    std::string signedURL = apiURL + uri;
+
+    ofxOAuthHedger::Signer signer = [this, signedURL, query]()
+    {
+        return getAuthorizationHeader("GET", signedURL, query);
+    };
+
+    // a caller's own timeouts or token must not decide for the others.
+    if(requestCoalescingEnabled && options.isDefault())
+    {
+        // identical gets already in flight share a single round trip.
+        bool merged = singleFlight.run(key, [&](ofxOAuthResponse& r)
+        {
+            performCachedGet(request, key, signer, r);
+        }, response);
+
+        if(merged)
+        {
+            ofLogVerbose("ofxOAuthClient::get") << "Merged with an identical request in flight.";
+        }
+    }
+    else
+    {
+        performCachedGet(request, key, signer, response);
+    }
+
+    if(!response.isComplete())
+    {
+        ofLogVerbose("ofxOAuthClient::get") << "Transfer failed: " << response.errorMessage;
+    }
+    else
+    {
+        reply = response.body;
+    }
+
+    if (reply.empty())
+    {
+        ofLogVerbose("ofxOAuthClient::get") << "HTTP get request failed.";
+    }
+    else
+    {
+        ofLogVerbose("ofxOAuthClient::get") << "HTTP-Reply: " << reply;
+        result = reply;
+    }
+    
+    return result;
+}
+
+
+bool ofxOAuthClient::get(const std::string& uri,
+                         const std::string& query,
+                         ofxOAuthJSONExtractor& extractor,
+                         ofxOAuthResponse& response,
+                         const ofxOAuthRequestOptions& options)
+{
+    ofxOAuthRequest request;
+    std::string signedQuery;
+
+    if(!_prepareRequest(OFX_HTTP_GET, uri, query, "", "", request, signedQuery))
+    {
+        return false;
+    }
+
+    options.apply(request);
+
+    std::string url = apiURL + uri;
+    uint64_t parseTime = 0;
+
+    request.onBody = [&extractor, &parseTime](const char* data, std::size_t size)
+    {
+        Poco::Timestamp parseStart;
+        extractor.feed(data, size);
+        parseTime += parseStart.elapsed();
+    };
+
+    retryPolicy.perform([&](std::size_t attempt, ofxOAuthResponse& r)
+    {
+        if(attempt > 0)
+        {
+            request.setHeader(getAuthorizationHeader("GET", url, signedQuery));
+            extractor.reset();
+        }
+
+        return transport.perform(request, r);
+    }, response, true, options.cancellationToken);
+
+    metrics.record(ofxOAuthMetrics::getEndpoint(url), ofxOAuthMetrics::PARSE, parseTime);
+
+    if(!ofxOAuthRetryPolicy::isSuccess(response))
+    {
+        ofLogVerbose("ofxOAuthClient::get") << "HTTP get request failed: " << (response.isComplete() ? response.body : response.errorMessage);
+        return false;
+    }
+
+    if(!extractor.finish())
+    {
+        ofLogError("ofxOAuthClient::get") << "Reply is not complete JSON. " << extractor.getError();
+        return false;
+    }
+
+    return true;
+}
+
+
+bool ofxOAuthClient::performCachedGet(ofxOAuthRequest& request,
+                                      const std::string& cacheKey,
+                                      ofxOAuthHedger::Signer signer,
+                                      ofxOAuthResponse& response)
+{
+    ofxOAuthResponseCache::Entry cached;
+    bool isCached = false;
+
+    if(0 != responseCache)
+    {
+        isCached = responseCache->get(cacheKey, cached);
+
+        if(isCached)
+        {
+            if(!cached.etag.empty())
+            {
+                request.headers.push_back("If-None-Match: " + cached.etag);
+            }
+
+            if(!cached.lastModified.empty())
+            {
+                request.headers.push_back("If-Modified-Since: " + cached.lastModified);
+            }
+        }
+    }
+
+    bool isComplete = retryPolicy.perform([&](std::size_t attempt, ofxOAuthResponse& r)
+    {
+        if(attempt > 0) request.setHeader(signer());
+        return hedger.perform(transport, request, signer, r);
+    }, response, true, request.cancellationToken);
+
+    if(!isComplete)
+    {
+        return false;
+    }
+
+    if(0 == responseCache)
+    {
+        return true;
+    }
+
+    if(isCached && response.status == 304)
+    {
+        ofLogVerbose("ofxOAuthClient::performCachedGet") << "Not modified, using the cached response.";
+        responseCache->recordHit(cached.body.size());
+        response.body = cached.body;
+        return true;
+    }
+
+    responseCache->recordMiss();
+
+    std::string etag = response.headers.get("ETag", "");
+    std::string lastModified = response.headers.get("Last-Modified", "");
+
+    if(response.status == 200 && (!etag.empty() || !lastModified.empty()))
+    {
+        ofxOAuthResponseCache::Entry entry;
+        entry.etag = etag;
+        entry.lastModified = lastModified;
+        entry.body = response.body;
+        responseCache->put(cacheKey, entry);
+    }
+    else if(isCached)
+    {
+        responseCache->remove(cacheKey);
+    }
+
+    return true;
+}
+
+
+std::string ofxOAuthClient::post(const std::string& uri,
+                                 const std::string& query,
+                                 const ofxOAuthRequestOptions& options)
+{
+    
+    std::string result = "";
+    
+    if(apiURL.empty())
+    {
+        ofLogError("ofxOAuthClient::post") << "No api URL specified.";
+        return result;
+    }
+    
+    if(consumerKey.empty())
+    {
+        ofLogError("ofxOAuthClient::post") << "No consumer key specified.";
+        return result;
+    }
+    
+    if(consumerSecret.empty())
+    {
+        ofLogError("ofxOAuthClient::post") << "No consumer secret specified.";
+        return result;
+    }
+    
+    if(accessToken.empty())
+    {
+        ofLogError("ofxOAuthClient::post") << "No access token specified.";
+        return result;
+    }
+    
+    if(accessTokenSecret.empty())
+    {
+        ofLogError("ofxOAuthClient::post") << "No access token secret specified.";
+        return result;
+    }
+    
+    std::string req_url;
+    std::string req_hdr;
+    std::string http_hdr;
+    
+    std::string reply;
+    
+    // oauth_sign_url2 (see oauth.h) in steps
+    int  argc   = 0;
+    char **argv = 0;
+    
+    // break apart the url parameters to they can be signed below
+    // if desired we can also pass in additional patermeters (like oath* params)
+    // here.  For instance, if ?oauth_callback=XXX is defined in this url,
+    // it will be parsed and used in the Authorization header.
+    
+    std::string url = apiURL + uri + "?" + query;
+    
+    Poco::Timestamp signStart;
+
+    argc = oauth_split_url_parameters(url.c_str(), &argv);
+    
+    // sign in server time, if our clock is known to be off.
+    _addTimestamp(&argc, &argv);
+
+    // sign the array.
+    oauth_sign_array2_process(&argc,
+                              &argv,
+                              0, //< postargs (unused)
+                              _getOAuthMethod(), // hash type, OA_HMAC, OA_RSA, OA_PLAINTEXT
+                              "POST", //< HTTP method (defaults to "GET")
+                              consumerKey.c_str(), //< consumer key - posted plain text
+                              consumerSecret.c_str(), //< consumer secret - used as 1st part of secret-key
+                              accessToken.c_str(),  //< token key - posted plain text in URL
+                              accessTokenSecret.c_str()); //< token secret - used as 2st part of secret-key
+    
+    ofLogVerbose("ofxOAuthClient::post") << "-------------------";
+    ofLogVerbose("ofxOAuthClient::post") << "consumerKey          >" << consumerKey << "<";
+    ofLogVerbose("ofxOAuthClient::post") << "consumerSecret       >" << consumerSecret << "<";
+    ofLogVerbose("ofxOAuthClient::post") << "requestToken         >" << requestToken << "<";
+    ofLogVerbose("ofxOAuthClient::post") << "requestTokenVerifier >" << requestTokenVerifier << "<";
+    ofLogVerbose("ofxOAuthClient::post") << "requestTokenSecret   >" << requestTokenSecret << "<";
+    ofLogVerbose("ofxOAuthClient::post") << "accessToken          >" << accessToken << "<";
+    ofLogVerbose("ofxOAuthClient::post") << "accessTokenSecret    >" << accessTokenSecret << "<";
+    ofLogVerbose("ofxOAuthClient::post") << "-------------------";
+    
+    // collect any parameters in our list that need to be placed as post params
+    char *post_params = oauth_serialize_url_sep(argc, 1, argv, const_cast<char *>("&"), 1);
+    
+    req_url =  apiURL + uri;
+
+    // collect any of the oauth parameters for inclusion in the HTTP Authorization header.
+    char* p_req_hdr = oauth_serialize_url_sep(argc, 1, argv, const_cast<char *>(", "), 2); // const_cast<char *>() is to avoid Deprecated
+    
+    if(0 != p_req_hdr)
+    {
+        req_hdr = p_req_hdr;
+        free(p_req_hdr);
+    }
+    
+    // look at url parameters to be signed if you want.
+    if(ofGetLogLevel() <= OF_LOG_VERBOSE)
+        for (int i=0;i<argc; i++) ofLogVerbose("ofxOAuthClient::post") << " : " << i << ":" << argv[i];
+    
+    // free our parameter arrays that were allocated during parsing above
+    oauth_free_array(&argc, &argv);
+
+    metrics.record(ofxOAuthMetrics::getEndpoint(url), ofxOAuthMetrics::SIGN, signStart.elapsed());
+    
+    // construct the Authorization header.  Include realm information if available.
+    if(!realm.empty())
+    {
+        // Note that (optional) 'realm' is not to be
+        // included in the oauth signed parameters and thus only added here.
+        // see 9.1.1 in http://oauth.net/core/1.0/#anchor14
+        http_hdr = "Authorization: OAuth realm=\"" + realm + "\", " + req_hdr;
+    }
+    else
+    {
+        http_hdr = "Authorization: OAuth " + req_hdr;
+    }
+    
+    ofLogVerbose("ofxOAuthClient::post") << "request URL    >" << req_url << "<";
+    ofLogVerbose("ofxOAuthClient::post") << "request HEADER >" << req_hdr << "<";
+    ofLogVerbose("ofxOAuthClient::post") << "http    HEADER >" << http_hdr << "<";
+    
+    // the transport verifies the server certificate, as
+    // ofx_oauth_curl_post did, unless that was explicitly turned off.
+    ofxOAuthRequest request;
+    request.method = "POST";
+    request.url = req_url;
+    request.headers.push_back("Content-Type: application/x-www-form-urlencoded");
+    request.headers.push_back(http_hdr); // Authorization header is included here
+
+    if(0 != post_params)
+    {
+        request.body = post_params; // the query string to send
+        free(post_params);
+    }
+
+    options.apply(request);
+
+    ofxOAuthResponse response;
+
+    retryPolicy.perform([&](std::size_t attempt, ofxOAuthResponse& r)
+    {
+        // every retry is signed again, with a fresh nonce and timestamp.
+        if(attempt > 0) request.setHeader(getAuthorizationHeader("POST", req_url, query));
+        return transport.perform(request, r);
+    }, response, false, options.cancellationToken);
+
+    if(!response.isComplete())
+    {
+        ofLogVerbose("ofxOAuthClient::post") << "Transfer failed: " << response.errorMessage;
+    }
+    else
+    {
+        reply = response.body;
+    }
+    
+    if (reply.empty())
+    {
+        ofLogVerbose("ofxOAuthClient::post") << "HTTP post request failed.";
+    }
+    else
+    {
+        ofLogVerbose("ofxOAuthClient::post") << "HTTP-Reply: " << reply;
+        result = reply;
+    }
+    
+    return result;
+}
+
+
+std::string ofxOAuthClient::postfile_multipartdata(const std::string& uri, const std::string& query, const std::string& filefieldname, const std::string& filepath)
+{
+    ofxOAuthMultipartForm form;
+
+    if(!form.addFile(filefieldname, filepath))
+    {
+        ofLogError("ofxOAuthClient::postfile_multipartdata") << "Unable to open file: " << filepath;
+        return "";
+    }
+
+    form.addFields(query);
+
+    return post_multipartdata(uri, form);
+}
+
+
+std::string ofxOAuthClient::postfile_multipartdata(const std::string& uri, const std::string& query, const std::string& filefieldname, const void* data, std::size_t size, const std::string& filename, const std::string& contentType)
+{
+    ofxOAuthMultipartForm form;
+    form.addBuffer(filefieldname, data, size, filename, contentType);
+    form.addFields(query);
+    return post_multipartdata(uri, form);
+}
+
+
+std::string ofxOAuthClient::post_multipartdata(const std::string& uri, ofxOAuthMultipartForm& form)
+{
+ 
+    std::string result = "";
+    
+    if(apiURL.empty())
+    {
+        ofLogError("ofxOAuthClient::post_multipartdata") << "No api URL specified.";
+        return result;
+    }
+    
+    if(consumerKey.empty())
+    {
+        ofLogError("ofxOAuthClient::post_multipartdata") << "No consumer key specified.";
+        return result;
+    }
+    
+    if(consumerSecret.empty())
+    {
+        ofLogError("ofxOAuthClient::post_multipartdata") << "No consumer secret specified.";
+        return result;
+    }
+    
+    if(accessToken.empty())
+    {
+        ofLogError("ofxOAuthClient::post_multipartdata") << "No access token specified.";
+        return result;
+    }
+    
+    if(accessTokenSecret.empty())
+    {
+        ofLogError("ofxOAuthClient::post_multipartdata") << "No access token secret specified.";
+        return result;
+    }
+    
+    std::string req_url;
+    std::string req_hdr;
+    std::string http_hdr;
+    
+    std::string reply;
+    
+    // oauth_sign_url2 (see oauth.h) in steps
+    int  argc   = 0;
+    char **argv = 0;
+    
+    // break apart the url parameters to they can be signed below
+    // if desired we can also pass in additional patermeters (like oath* params)
+    // here.  For instance, if ?oauth_callback=XXX is defined in this url,
+    // it will be parsed and used in the Authorization header.
+    
+    std::string url = apiURL + uri;
+    
+    Poco::Timestamp signStart;
+
+    argc = oauth_split_url_parameters(url.c_str(), &argv);
+    
+    // sign in server time, if our clock is known to be off.
+    _addTimestamp(&argc, &argv);
+
+    // sign the array.
+    oauth_sign_array2_process(&argc,
+                              &argv,
+                              0, //< postargs (unused)
+                              _getOAuthMethod(), // hash type, OA_HMAC, OA_RSA, OA_PLAINTEXT
+                              "POST", //< HTTP method (defaults to "GET")
+                              consumerKey.c_str(), //< consumer key - posted plain text
+                              consumerSecret.c_str(), //< consumer secret - used as 1st part of secret-key
+                              accessToken.c_str(),  //< token key - posted plain text in URL
+                              accessTokenSecret.c_str()); //< token secret - used as 2st part of secret-key
+    
+    ofLogVerbose("ofxOAuthClient::post_multipartdata") << "-------------------";
+    ofLogVerbose("ofxOAuthClient::post_multipartdata") << "consumerKey          >" << consumerKey << "<";
+    ofLogVerbose("ofxOAuthClient::post_multipartdata") << "consumerSecret       >" << consumerSecret << "<";
+    ofLogVerbose("ofxOAuthClient::post_multipartdata") << "requestToken         >" << requestToken << "<";
+    ofLogVerbose("ofxOAuthClient::post_multipartdata") << "requestTokenVerifier >" << requestTokenVerifier << "<";
+    ofLogVerbose("ofxOAuthClient::post_multipartdata") << "requestTokenSecret   >" << requestTokenSecret << "<";
+    ofLogVerbose("ofxOAuthClient::post_multipartdata") << "accessToken          >" << accessToken << "<";
+    ofLogVerbose("ofxOAuthClient::post_multipartdata") << "accessTokenSecret    >" << accessTokenSecret << "<";
+    ofLogVerbose("ofxOAuthClient::post_multipartdata") << "-------------------";
+    
+    req_url =  apiURL + uri;
+    
+    // collect any of the oauth parameters for inclusion in the HTTP Authorization header.
+    char* p_req_hdr = oauth_serialize_url_sep(argc, 1, argv, const_cast<char *>(", "), 2); // const_cast<char *>() is to avoid Deprecated
+    
+    if(0 != p_req_hdr)
+    {
+        req_hdr = p_req_hdr;
+        free(p_req_hdr);
+    }
+    
+    // look at url parameters to be signed if you want.
+    if(ofGetLogLevel() <= OF_LOG_VERBOSE)
+        for (int i=0;i<argc; i++) ofLogVerbose("ofxOAuthClient::post_multipartdata") << " : " << i << ":" << argv[i];
+    
+    // free our parameter arrays that were allocated during parsing above
+    oauth_free_array(&argc, &argv);
+
+    metrics.record(ofxOAuthMetrics::getEndpoint(url), ofxOAuthMetrics::SIGN, signStart.elapsed());
+
+    //oauth_free_array(&argcp, &argvp);
+    
+    // construct the Authorization header.  Include realm information if available.
+    if(!realm.empty())
+    {
+        // Note that (optional) 'realm' is not to be
+        // included in the oauth signed parameters and thus only added here.
+        // see 9.1.1 in http://oauth.net/core/1.0/#anchor14
+        http_hdr = "Authorization: OAuth realm=\"" + realm + "\", " + req_hdr;
+    }
+    else
+    {
+        http_hdr = "Authorization: OAuth " + req_hdr;
+    }
+    
+    ofLogVerbose("ofxOAuthClient::post_multipartdata") << "request URL    >" << req_url << "<";
+    ofLogVerbose("ofxOAuthClient::post_multipartdata") << "request HEADER >" << req_hdr << "<";
+    ofLogVerbose("ofxOAuthClient::post_multipartdata") << "http    HEADER >" << http_hdr << "<";
+    
+    // the form is streamed by the transport, as for postFileAsync().
+    ofxOAuthRequest request;
+    request.method = "POST";
+    request.url = req_url;
+    request.form = &form; // the fields and files to send
+    request.headers.push_back(http_hdr); // Authorization header is included here
+
+    ofxOAuthResponse response;
+
+    retryPolicy.perform([&](std::size_t attempt, ofxOAuthResponse& r)
+    {
+        // multipart fields are not part of the signature base string.
+        if(attempt > 0) request.setHeader(getAuthorizationHeader("POST", req_url));
+        return transport.perform(request, r);
+    }, response, false);
+
+    if(!response.isComplete())
+    {
+        ofLogVerbose("ofxOAuthClient::post_multipartdata") << "Transfer failed: " << response.errorMessage;
+    }
+    else
+    {
+        reply = response.body;
+    }
+    
+    if (reply.empty())
+    {
+        ofLogVerbose("ofxOAuthClient::post_multipartdata") << "HTTP post request failed.";
+    }
+    else
+    {
+        ofLogVerbose("ofxOAuthClient::post_multipartdata") << "HTTP-Reply: " << reply;
+        result = reply;
+    }
+    
+    return result;
+    
+}
+
+
+bool ofxOAuthClient::request(AuthHttpMethod method,
+                             const std::string& uri,
+                             const std::string& query,
+                             const std::string& body,
+                             ofxOAuthResponse& response,
+                             const std::string& contentType,
+                             const ofxOAuthRequestOptions& options)
+{
+    ofxOAuthRequest request;
+    std::string signedQuery;
+
+    if(!_prepareRequest(method, uri, query, body, contentType, request, signedQuery))
+    {
+        return false;
+    }
+
+    options.apply(request);
+
+    std::string methodName = request.method;
+    std::string url = apiURL + uri;
+
+    bool isIdempotent = method != OFX_HTTP_POST && method != OFX_HTTP_PATCH;
+
+    bool isComplete = retryPolicy.perform([&](std::size_t attempt, ofxOAuthResponse& r)
+    {
+        if(attempt > 0) request.setHeader(getAuthorizationHeader(methodName, url, signedQuery));
+        return transport.perform(request, r);
+    }, response, isIdempotent, options.cancellationToken);
+
+    if(!isComplete)
+    {
+        ofLogVerbose("ofxOAuthClient::request") << "HTTP " << methodName << " request failed: " << response.errorMessage;
+        return false;
+    }
+
+    ofLogVerbose("ofxOAuthClient::request") << "HTTP " << response.status << " " << response.body;
+
+    return true;
+}
+
+
+ofxOAuthAsyncResponse ofxOAuthClient::requestAsync(AuthHttpMethod method,
+                                                   const std::string& uri,
+                                                   const std::string& query,
+                                                   const std::string& body,
+                                                   const std::string& contentType,
+                                                   const ofxOAuthRequestOptions& options)
+{
+    ofxOAuthRequest request;
+    std::string signedQuery;
+
+    if(!_prepareRequest(method, uri, query, body, contentType, request, signedQuery))
+    {
+        return ofxOAuthAsyncResponse::failed(CURLE_FAILED_INIT, "The client is not set up to sign requests.");
+    }
+
+    options.apply(request);
+
+    std::shared_ptr<_AsyncCall> call = std::make_shared<_AsyncCall>();
+    call->request = request;
+    call->isIdempotent = method != OFX_HTTP_POST && method != OFX_HTTP_PATCH;
+
+    std::string methodName = request.method;
+    std::string url = apiURL + uri;
+
+    call->signer = [this, methodName, url, signedQuery]()
+    {
+        return getAuthorizationHeader(methodName, url, signedQuery);
+    };
+
+    return _performAsync(call);
+}
+
+
+ofxOAuthAsyncResponse ofxOAuthClient::getAsync(const std::string& uri,
+                                               const std::string& query,
+                                               const ofxOAuthRequestOptions& options)
+{
+    // a caller's own timeouts or token must not decide for the others.
+    if(!requestCoalescingEnabled || !options.isDefault())
+    {
+        return requestAsync(OFX_HTTP_GET, uri, query, "", "", options);
+    }
+
+    // shares a round trip with identical gets in flight, blocking or not.
+    return singleFlight.runAsync(_getRequestKey(uri, query), [this, uri, query]()
+    {
+        return requestAsync(OFX_HTTP_GET, uri, query);
+    });
+}
+
+
+ofxOAuthAsyncResponse ofxOAuthClient::getAsync(const std::string& uri,
+                                               const std::string& query,
+                                               std::shared_ptr<ofxOAuthJSONExtractor> extractor,
+                                               const ofxOAuthRequestOptions& options)
+{
+    ofxOAuthRequest request;
+    std::string signedQuery;
+
+    if(!_prepareRequest(OFX_HTTP_GET, uri, query, "", "", request, signedQuery))
+    {
+        return ofxOAuthAsyncResponse::failed(CURLE_FAILED_INIT, "The client is not set up to sign requests.");
+    }
+
+    options.apply(request);
+
+    // one transfer at a time feeds it, on the I/O thread.
+    request.onBody = [extractor](const char* data, std::size_t size)
+    {
+        extractor->feed(data, size);
+    };
+
+    std::shared_ptr<_AsyncCall> call = std::make_shared<_AsyncCall>();
+    call->request = request;
+
+    std::string url = apiURL + uri;
+
+    call->signer = [this, url, signedQuery]()
+    {
+        return getAuthorizationHeader("GET", url, signedQuery);
+    };
+
+    // a resent request is a new document.
+    call->onResend = [extractor]()
+    {
+        extractor->reset();
+    };
+
+    call->onDone = [extractor](ofxOAuthResponse& response)
+    {
+        if(ofxOAuthRetryPolicy::isSuccess(response) && !extractor->finish())
+        {
+            ofLogError("ofxOAuthClient::getAsync") << "Reply is not complete JSON. " << extractor->getError();
+        }
+    };
+
+    return _performAsync(call);
+}
+
+
+std::shared_ptr<ofxOAuthPaginator> ofxOAuthClient::paginate(const ofxOAuthPaginator::Settings& settings)
+{
+    return std::make_shared<ofxOAuthPaginator>(settings, [this](const std::string& uri,
+                                                                const std::string& query,
+                                                                std::shared_ptr<ofxOAuthJSONExtractor> extractor,
+                                                                std::shared_ptr<ofxOAuthCancellationToken> cancellationToken)
+    {
+        // next links may be absolute.
+        if(uri.find("://") == std::string::npos)
+        {
+            return getAsync(uri, query, extractor, cancellationToken);
+        }
+        else if(uri.compare(0, apiURL.size(), apiURL) == 0)
+        {
+            return getAsync(uri.substr(apiURL.size()), query, extractor, cancellationToken);
+        }
+
+        ofLogError("ofxOAuthClient::paginate") << "Next link is not on the api URL: " << uri;
+        return ofxOAuthAsyncResponse::failed(CURLE_URL_MALFORMAT, "Next link is not on the api URL.");
+    });
+}
+
+
+ofxOAuthAsyncResponse ofxOAuthClient::postAsync(const std::string& uri,
+                                                const std::string& query,
+                                                const ofxOAuthRequestOptions& options)
+{
+    // sent as a form-urlencoded body, like post().
+    return requestAsync(OFX_HTTP_POST, uri, query, "", "application/octet-stream", options);
+}
+
+
+ofxOAuthAsyncResponse ofxOAuthClient::postFileAsync(const std::string& uri, const std::string& query, const std::string& filefieldname, const std::string& filepath)
+{
+    std::shared_ptr<ofxOAuthMultipartForm> form = std::make_shared<ofxOAuthMultipartForm>();
+
+    if(!form->addFile(filefieldname, filepath))
+    {
+        ofLogError("ofxOAuthClient::postFileAsync") << "Unable to open file: " << filepath;
+        return ofxOAuthAsyncResponse::failed(CURLE_READ_ERROR, "Unable to open file: " + filepath);
+    }
+
+    form->addFields(query);
+
+    return _postFormAsync(uri, form);
+}
+
+
+ofxOAuthAsyncResponse ofxOAuthClient::postFileAsync(const std::string& uri, const std::string& query, const std::string& filefieldname, const void* data, std::size_t size, const std::string& filename, const std::string& contentType)
+{
+    std::shared_ptr<ofxOAuthMultipartForm> form = std::make_shared<ofxOAuthMultipartForm>();
+    form->addBuffer(filefieldname, data, size, filename, contentType);
+    form->addFields(query);
+    return _postFormAsync(uri, form);
+}
+
+
+ofxOAuthAsyncResponse ofxOAuthClient::_postFormAsync(const std::string& uri, std::shared_ptr<ofxOAuthMultipartForm> form)
+{
+    if(apiURL.empty() || accessToken.empty() || accessTokenSecret.empty())
+    {
+        ofLogError("ofxOAuthClient::postFileAsync") << "No api URL or access token specified.";
+        return ofxOAuthAsyncResponse::failed(CURLE_FAILED_INIT, "The client is not set up to sign requests.");
+    }
+
+    std::string url = apiURL + uri;
+
+    std::shared_ptr<_AsyncCall> call = std::make_shared<_AsyncCall>();
+    call->request.method = "POST";
+    call->request.url = url;
+    call->request.form = form.get();
+    call->form = form;
+    call->isIdempotent = false;
+
+    // multipart fields are not part of the signature base string.
+    call->signer = [this, url]()
+    {
+        return getAuthorizationHeader("POST", url);
+    };
+
+    call->request.headers.push_back(call->signer());
+
+    return _performAsync(call);
+}
+
+
+ofxOAuthAsyncResponse ofxOAuthClient::_performAsync(std::shared_ptr<_AsyncCall> call)
+{
+    retryPolicy.begin(call->attempts);
+    _sendAsync(call, 0);
+    return ofxOAuthAsyncResponse(call->state);
+}
+
+
+void ofxOAuthClient::_sendAsync(std::shared_ptr<_AsyncCall> call, long delay)
+{
+    transport.performAsync(call->request, [this, call](const ofxOAuthRequest& request, ofxOAuthResponse& response)
+    {
+        long wait = 0;
+
+        if(retryPolicy.next(call->attempts, response, call->isIdempotent, wait))
+        {
+            // signed again, with a fresh nonce and the corrected time.
+            call->request.setHeader(call->signer());
+            call->request.queuedAt = 0;
+
+            if(call->onResend) call->onResend();
+
+            _sendAsync(call, wait);
+            return;
+        }
+
+        if(call->onDone) call->onDone(response);
+
+        if(!response.isComplete())
+        {
+            ofLogVerbose("ofxOAuthClient::requestAsync") << "HTTP " << request.method << " request failed: " << response.errorMessage;
+        }
+
+        call->state->complete(response);
+    }, delay);
+}
+
+
+ofxOAuthQueueExecutor& ofxOAuthClient::getUpdateExecutor()
+{
+    return updateExecutor;
+}
+
+
+bool ofxOAuthClient::_prepareRequest(AuthHttpMethod method,
+                                     const std::string& uri,
+                                     const std::string& query,
+                                     const std::string& body,
+                                     const std::string& contentType,
+                                     ofxOAuthRequest& request,
+                                     std::string& signedQuery)
+{
+    if(apiURL.empty())
+    {
+        ofLogError("ofxOAuthClient::request") << "No api URL specified.";
+        return false;
+    }
+
+    if(accessToken.empty() || accessTokenSecret.empty())
+    {
+        ofLogError("ofxOAuthClient::request") << "No access token specified.";
+        return false;
+    }
+
+    std::string methodName = _getHttpMethod(method);
+    std::string url = apiURL + uri;
+    signedQuery = query;
+
+    bool hasBody = method == OFX_HTTP_POST || method == OFX_HTTP_PUT || method == OFX_HTTP_PATCH;
+    bool isFormBody = hasBody && body.empty() && !query.empty();
+
+    request.method = methodName;
+
+    if(isFormBody)
+    {
+        // form parameters are part of the signature base string.
+        request.url = url;
+        request.body = query;
+        request.headers.push_back("Content-Type: application/x-www-form-urlencoded");
+    }
+    else
+    {
+        request.url = query.empty() ? url : url + "?" + query;
+
+        if(!body.empty())
+        {
+            request.body = body;
+            request.headers.push_back("Content-Type: " + contentType);
+
+            if(bodyHashEnabled)
+            {
+                _appendBodyHash(signedQuery, ofxOAuthBodyHash::hash(body.data(), body.size()));
+            }
+        }
+    }
+
+    request.headers.push_back(getAuthorizationHeader(methodName, url, signedQuery));
+
+    ofLogVerbose("ofxOAuthClient::request") << methodName << " " << request.url;
+
+    return true;
+}
+
+
+std::string ofxOAuthClient::request(AuthHttpMethod method,
+                                    const std::string& uri,
+                                    const std::string& query,
+                                    const std::string& body,
+                                    const ofxOAuthRequestOptions& options)
+{
+    ofxOAuthResponse response;
+    request(method, uri, query, body, response, "application/octet-stream", options);
+    return response.body;
+}
+
+
+std::string ofxOAuthClient::postfile(const std::string& uri,
+                                     const std::string& query,
+                                     const std::string& filepath,
+                                     const std::string& contentType)
+{
+    if(apiURL.empty())
+    {
+        ofLogError("ofxOAuthClient::postfile") << "No api URL specified.";
+        return "";
+    }
+
+    if(accessToken.empty() || accessTokenSecret.empty())
+    {
+        ofLogError("ofxOAuthClient::postfile") << "No access token specified.";
+        return "";
+    }
+
+    ofxOAuthUploadSource source;
+
+    if(!source.openFile(filepath))
+    {
+        ofLogError("ofxOAuthClient::postfile") << "Unable to open file: " << filepath;
+        return "";
+    }
+
+    std::string url = apiURL + uri;
+    std::string signedQuery = query;
+
+    if(bodyHashEnabled)
+    {
+        // hashed from the mapping that is uploaded below, so the file is
+        // only read from disk once.  Unchanged files are not hashed again.
+        _appendBodyHash(signedQuery, bodyHashCache.get(filepath, source));
+    }
+
+    ofxOAuthRequest request;
+    request.method = "POST";
+    request.url = query.empty() ? url : url + "?" + query;
+    request.source = &source;
+    request.headers.push_back("Content-Type: " + contentType);
+    // oauth_body_hash is an oauth parameter, so it only goes in the header.
+    request.headers.push_back(getAuthorizationHeader("POST", url, signedQuery));
+
+    ofxOAuthResponse response;
+
+    if(!transport.perform(request, response))
+    {
+        ofLogVerbose("ofxOAuthClient::postfile") << "HTTP post request failed: " << response.errorMessage;
+        return "";
+    }
+
+    ofLogVerbose("ofxOAuthClient::postfile") << "HTTP-Reply: " << response.body;
+
+    return response.body;
+}
+
+
+bool ofxOAuthClient::postfile_chunked(const ofxOAuthChunkedUpload::Settings& settings,
+                                      const std::string& filepath,
+                                      std::string& mediaId)
+{
+    if(settings.url.empty())
+    {
+        ofLogError("ofxOAuthClient::postfile_chunked") << "No upload URL specified.";
+        return false;
+    }
+
+    if(accessToken.empty() || accessTokenSecret.empty())
+    {
+        ofLogError("ofxOAuthClient::postfile_chunked") << "No access token specified.";
+        return false;
+    }
+
+    ofxOAuthChunkedUpload upload(transport, [this](const std::string& method,
+                                                   const std::string& url,
+                                                   const std::string& query)
+    {
+        return getAuthorizationHeader(method, url, query);
+    });
+
+    if(!upload.upload(settings, filepath, mediaId))
+    {
+        ofLogError("ofxOAuthClient::postfile_chunked") << upload.getError();
+        return false;
+    }
+
+    ofLogVerbose("ofxOAuthClient::postfile_chunked") << "Uploaded " << upload.getSegmentCount() << " segments as media id " << mediaId;
+
+    return true;
+}
+
+
+std::string ofxOAuthClient::getAuthorizationHeader(const std::string& method,
+                                                   const std::string& url,
+                                                   const std::string& query)
+{
+    int  argc   = 0;
+    char **argv = 0;
+
+    std::string signedURL = query.empty() ? url : url + "?" + query;
+
+    Poco::Timestamp signStart;
+
+    argc = oauth_split_url_parameters(signedURL.c_str(), &argv);
+
+    // sign in server time, if our clock is known to be off.
+    _addTimestamp(&argc, &argv);
+
+    oauth_sign_array2_process(&argc,
+                              &argv,
+                              0, //< postargs (unused)
+                              _getOAuthMethod(), // hash type, OA_HMAC, OA_RSA, OA_PLAINTEXT
+                              method.c_str(), //< HTTP method
+                              consumerKey.c_str(), //< consumer key - posted plain text
+                              consumerSecret.c_str(), //< consumer secret - used as 1st part of secret-key
+                              accessToken.c_str(),  //< token key - posted plain text in URL
+                              accessTokenSecret.c_str()); //< token secret - used as 2st part of secret-key
+
+    std::string req_hdr;
+
+    // collect the oauth parameters for inclusion in the HTTP Authorization header.
+    char* p_req_hdr = oauth_serialize_url_sep(argc, 1, argv, const_cast<char *>(", "), 6);
+
+    if(0 != p_req_hdr)
+    {
+        req_hdr = p_req_hdr;
+        free(p_req_hdr);
+    }
+
+    oauth_free_array(&argc, &argv);
+
+    metrics.record(ofxOAuthMetrics::getEndpoint(url), ofxOAuthMetrics::SIGN, signStart.elapsed());
+
+    if(!realm.empty())
+    {
+        return "Authorization: OAuth realm=\"" + realm + "\", " + req_hdr;
+    }
+    else
+    {
+        return "Authorization: OAuth " + req_hdr;
+    }
+}
+
+
+std::map<std::string, std::string> ofxOAuthClient::obtainRequestToken()
+{
+    std::map<std::string, std::string> returnParams;
+
+    if(requestTokenURL.empty())
+    {
+        ofLogError("ofxOAuthClient::obtainRequestToken") << "No request token URL specified.";
+        return returnParams;
+    }
+    
+    if(consumerKey.empty())
+    {
+        ofLogError("ofxOAuthClient::obtainRequestToken") << "No consumer key specified.";
+        return returnParams;
+    }
+
+    if(consumerSecret.empty())
+    {
+        ofLogError("ofxOAuthClient::obtainRequestToken") << "No consumer secret specified.";
+        return returnParams;
+    }
+
+    std::string req_url;
+    std::string req_hdr;
+    std::string http_hdr;
+
+    std::string reply;
+
+    // oauth_sign_url2 (see oauth.h) in steps
+    int  argc   = 0;
+    char **argv = 0;
+    
+    // break apart the url parameters to they can be signed below
+    // if desired we can also pass in additional patermeters (like oath* params)
+    // here.  For instance, if ?oauth_callback=XXX is defined in this url,
+    // it will be parsed and used in the Authorization header.
+    Poco::Timestamp signStart;
+
+    argc = oauth_split_url_parameters(requestTokenURL.c_str(), &argv);
+    
+    // add the authorization callback url info if available
+    if(!getVerifierCallbackURL().empty())
+    {
+        std::string callbackParam = "oauth_callback=" + getVerifierCallbackURL();
+        oauth_add_param_to_array(&argc, &argv, callbackParam.c_str());
+    }
+
+    // NOTE BELOW:
+    /*
+     
+    FOR GOOGLE:
+    Authorization header of a GET or POST request. Use "Authorization: OAuth". All parameters listed above can go in the header, except for scope and xoauth_displayname, which must go either in the body or in the URL as a query parameter. The example below puts them in the body of the request.
+    
+     https://developers.google.com/accounts/docs/OAuth_ref#RequestToken
+     */
+    
+    if(!getApplicationDisplayName().empty())
+    {
+        std::string displayNameParam = "xoauth_displayname=" + getApplicationDisplayName();
+        oauth_add_param_to_array(&argc, &argv, displayNameParam.c_str());
+    }
+    
+    if(!getApplicationScope().empty())
+    {
+        // TODO: this will not be integrated correctly by lib oauth
+        // b/c it does not have a oauth / xoauth prefix
+        // XXXXXXXXXX
+        std::string scopeParam = "scope=" + getApplicationScope();
+        oauth_add_param_to_array(&argc, &argv, scopeParam.c_str());
+    }
+    
+    
+    // NOTE: if desired, normal oatuh parameters, such as oauth_nonce could be overriden here
+    // rathern than having them auto-calculated using the oauth_sign_array2_process method
+    //oauth_add_param_to_array(&argc, &argv, "oauth_nonce=xxxxxxxpiOuDKDAmwHKZXXhGelPc4cJq");
+
+    // sign in server time, if our clock is known to be off.
+    _addTimestamp(&argc, &argv);
+
+    // sign the array.
+    oauth_sign_array2_process(&argc, 
+                              &argv,
+                              0, //< postargs (unused)
+                              _getOAuthMethod(), // hash type, OA_HMAC, OA_RSA, OA_PLAINTEXT
+                              _getHttpMethod().c_str(), //< HTTP method (defaults to "GET")
+                              consumerKey.c_str(), //< consumer key - posted plain text
+                              consumerSecret.c_str(), //< consumer secret - used as 1st part of secret-key
+                              0,  //< token key - posted plain text in URL
+                              0); //< token secret - used as 2st part of secret-key
+    
+    ofLogVerbose("ofxOAuthClient::obtainRequestToken") << "-------------------";
+    ofLogVerbose("ofxOAuthClient::obtainRequestToken") << "consumerKey          >" << consumerKey << "<";
+    ofLogVerbose("ofxOAuthClient::obtainRequestToken") << "consumerSecret       >" << consumerSecret << "<";
+    ofLogVerbose("ofxOAuthClient::obtainRequestToken") << "requestToken         >" << requestToken << "<";
+    ofLogVerbose("ofxOAuthClient::obtainRequestToken") << "requestTokenVerifier >" << requestTokenVerifier << "<";
+    ofLogVerbose("ofxOAuthClient::obtainRequestToken") << "requestTokenSecret   >" << requestTokenSecret << "<";
+    ofLogVerbose("ofxOAuthClient::obtainRequestToken") << "accessToken          >" << accessToken << "<";
+    ofLogVerbose("ofxOAuthClient::obtainRequestToken") << "accessTokenSecret    >" << accessTokenSecret << "<";
+    ofLogVerbose("ofxOAuthClient::obtainRequestToken") << "-------------------";
+
+    // collect any parameters in our list that need to be placed in the request URI
+    char* p_req_url = oauth_serialize_url_sep(argc, 0, argv, const_cast<char *>("&"), 1);
+
+    if(0 != p_req_url)
+    {
+        req_url = p_req_url;
+        free(p_req_url);
+    }
+
+    // collect any of the oauth parameters for inclusion in the HTTP Authorization header.
+    char* p_req_hdr = oauth_serialize_url_sep(argc, 1, argv, const_cast<char *>(", "), 6); // const_cast<char *>() is to avoid Deprecated
+
+    if(0 != p_req_hdr)
+    {
+        req_hdr = p_req_hdr;
+        free(p_req_hdr);
+    }
+
+    // look at url parameters to be signed if you want.
+    if(ofGetLogLevel() <= OF_LOG_VERBOSE)
+        for (int i=0;i<argc; i++) ofLogVerbose("ofxOAuthClient::obtainRequestToken") << i << " >" << argv[i] << "<";
+
+    // free our parameter arrays that were allocated during parsing above    
+    oauth_free_array(&argc, &argv);
+
+    metrics.record(ofxOAuthMetrics::getEndpoint(requestTokenURL), ofxOAuthMetrics::SIGN, signStart.elapsed());
+    
+    // construct the Authorization header.  Include realm information if available.
+    if(!realm.empty())
+    {
+        // Note that (optional) 'realm' is not to be 
+        // included in the oauth signed parameters and thus only added here.
+        // see 9.1.1 in http://oauth.net/core/1.0/#anchor14
+        http_hdr = "Authorization: OAuth realm=\"" + realm + "\", " + req_hdr; 
+    }
+    else
+    {
+        http_hdr = "Authorization: OAuth " + req_hdr;
+    }
+
+    ofLogVerbose("ofxOAuthClient::obtainRequestToken") << "Request URL    = " << req_url;
+    ofLogVerbose("ofxOAuthClient::obtainRequestToken") << "Request HEADER = " << req_hdr;
+    ofLogVerbose("ofxOAuthClient::obtainRequestToken") << "http    HEADER = " << http_hdr;
+
+    // sent like every other request: timeouts, the circuit breaker,
+    // certificate checks, metrics and the server clock all apply.
+    ofxOAuthRequest request;
+    request.method = _getHttpMethod();
+    request.url = req_url;
+    request.headers.push_back(http_hdr); // Authorization header is included here
+
+    ofxOAuthResponse response;
+
+    if(!transport.perform(request, response))
+    {
+        ofLogVerbose("ofxOAuthClient::obtainRequestToken") << "Transfer failed: " << response.errorMessage;
+    }
+    else
+    {
+        reply = response.body;
+    }
+
+    if (reply.empty())
+    {
+        ofLogVerbose("ofxOAuthClient::obtainRequestToken") << "HTTP request for an oauth request-token failed.";
+    }
+    else
+    {
+        ofLogVerbose("ofxOAuthClient::obtainRequestToken") << "HTTP-Reply: " << reply;
+
+        Poco::Timestamp parseStart;
+
+        ofxOAuthFormDecoder decoder(reply);
+        ofxOAuthFormDecoder::Field field;
+
+        while(decoder.next(field))
+        {
+            if(field.hasValue)
+            {
+                std::string key = field.key.str();
+                std::string value = field.value.str();
+
+                returnParams[key] = value;
+
+                switch(field.id)
+                {
+                    case ofxOAuthFormDecoder::OAUTH_TOKEN:
+                        requestToken = value;
+                        break;
+                    case ofxOAuthFormDecoder::OAUTH_TOKEN_SECRET:
+                        requestTokenSecret = value;
+                        break;
+                    case ofxOAuthFormDecoder::OAUTH_CALLBACK_CONFIRMED:
+                        callbackConfirmed = (Poco::icompare(value, "true") == 0);
+                        break;
+                    case ofxOAuthFormDecoder::OAUTH_PROBLEM:
+                        ofLogError("ofxOAuthClient::obtainRequestToken") <<  "Got oauth problem: " << value;
+                        break;
+                    default:
+                        ofLogNotice("ofxOAuthClient::obtainRequestToken") << "Got an unknown parameter: " << key << "=" + value;
+                        break;
+                }
+            }
+            else
+            {
+                ofLogWarning("ofxOAuthClient::obtainRequestToken") <<  "Return parameter did not have a value: " << field.key.str() << " - skipping.";
+            }
+        }
+
+        metrics.record(ofxOAuthMetrics::getEndpoint(requestTokenURL), ofxOAuthMetrics::PARSE, parseStart.elapsed());
+    }
+    
+    if(requestTokenSecret.empty())
+    {
+        ofLogWarning("ofxOAuthClient::obtainRequestToken") << "Request token secret not returned.";
+        accessFailed = true;
+    }
+
+    if(requestToken.empty())
+    {
+        ofLogWarning("ofxOAuthClient::obtainRequestToken") << "Request token not returned.";
+        accessFailed = true;
+    }
+
+    
+    return returnParams;
+}
+
+
+std::map<std::string,std::string> ofxOAuthClient::obtainAccessToken()
+{
+    std::map<std::string,std::string> returnParams;
+    
+    if(accessTokenURL.empty())
+    {
+        ofLogError("ofxOAuthClient::obtainAccessToken") << "No access token URL specified.";
+        return returnParams;
+    }
+    
+    if(consumerKey.empty())
+    {
+        ofLogError("ofxOAuthClient::obtainAccessToken") << "No consumer key specified.";
+        return returnParams;
+    }
+    
+    if(consumerSecret.empty())
+    {
+        ofLogError("ofxOAuthClient::obtainAccessToken") << "No consumer secret specified.";
+        return returnParams;
+    }
+    
+    if(requestToken.empty())
+    {
+        ofLogError("ofxOAuthClient::obtainAccessToken") << "No request token specified.";
+        return returnParams;
+    }
+    
+    if(requestTokenSecret.empty())
+    {
+        ofLogError("ofxOAuthClient::obtainAccessToken") << "No request token secret specified.";
+        return returnParams;
+    }
+    
+    if(requestTokenVerifier.empty())
+    {
+        ofLogError("ofxOAuthClient::obtainAccessToken") << "No request token verifier specified.";
+        return returnParams;
+    }
+    
+    std::string req_url;
+    std::string req_hdr;
+    std::string http_hdr;
+    
+    std::string reply;
+    
+    // oauth_sign_url2 (see oauth.h) in steps
+    int  argc   = 0;
+    char **argv = 0;
+    
+    // break apart the url parameters to they can be signed below
+    // if desired we can also pass in additional patermeters (like oath* params)
+    // here.  For instance, if ?oauth_callback=XXX is defined in this url,
+    // it will be parsed and used in the Authorization header.
+    Poco::Timestamp signStart;
+
+    argc = oauth_split_url_parameters(getAccessTokenURL().c_str(), &argv);
+    
+    // add the verifier param
+    std::string verifierParam = "oauth_verifier=" + requestTokenVerifier;
+    oauth_add_param_to_array(&argc, &argv, verifierParam.c_str());
+
+    // NOTE: if desired, normal oauth parameters, such as oauth_nonce could be overriden here
+    // rathern than having them auto-calculated using the oauth_sign_array2_process method
+    //oauth_add_param_to_array(&argc, &argv, "oauth_nonce=xxxxxxxpiOuDKDAmwHKZXXhGelPc4cJq");
+    
+    // sign in server time, if our clock is known to be off.
+    _addTimestamp(&argc, &argv);
+
+    // sign the array.
+    oauth_sign_array2_process(&argc, 
+                              &argv,
+                              0, //< postargs (unused)
+                              _getOAuthMethod(), // hash type, OA_HMAC, OA_RSA, OA_PLAINTEXT
+                              _getHttpMethod().c_str(), //< HTTP method (defaults to "GET")
+                              consumerKey.c_str(), //< consumer key - posted plain text
+                              consumerSecret.c_str(), //< consumer secret - used as 1st part of secret-key
+                              requestToken.c_str(),  //< token key - posted plain text in URL
+                              requestTokenSecret.c_str()); //< token secret - used as 2st part of secret-key
+
+    ofLogVerbose("ofxOAuthClient::obtainAccessToken") << "-------------------";
+    ofLogVerbose("ofxOAuthClient::obtainAccessToken") << "consumerKey          >" << consumerKey << "<";
+    ofLogVerbose("ofxOAuthClient::obtainAccessToken") << "consumerSecret       >" << consumerSecret << "<";
+    ofLogVerbose("ofxOAuthClient::obtainAccessToken") << "requestToken         >" << requestToken << "<";
+    ofLogVerbose("ofxOAuthClient::obtainAccessToken") << "requestTokenVerifier >" << requestTokenVerifier << "<";
+    ofLogVerbose("ofxOAuthClient::obtainAccessToken") << "requestTokenSecret   >" << requestTokenSecret << "<";
+    ofLogVerbose("ofxOAuthClient::obtainAccessToken") << "accessToken          >" << accessToken << "<";
+    ofLogVerbose("ofxOAuthClient::obtainAccessToken") << "accessTokenSecret    >" << accessTokenSecret << "<";
+    ofLogVerbose("ofxOAuthClient::obtainAccessToken") << "-------------------";
+    
+    // collect any parameters in our list that need to be placed in the request URI
+    char* p_req_url = oauth_serialize_url_sep(argc, 0, argv, const_cast<char *>("&"), 1);
+
+    if(0 != p_req_url)
+    {
+        req_url = p_req_url;
+        free(p_req_url);
+    }
+    
+    // collect any of the oauth parameters for inclusion in the HTTP Authorization header.
+    char* p_req_hdr = oauth_serialize_url_sep(argc, 1, argv, const_cast<char *>(", "), 6); // const_cast<char *>() is to avoid Deprecated
+
+    if(0 != p_req_hdr)
+    {
+        req_hdr = p_req_hdr;
+        free(p_req_hdr);
+    }
+
+    // look at url parameters to be signed if you want.
+    if(ofGetLogLevel() <= OF_LOG_VERBOSE)
+    {
+        for(int i=0; i < argc; i++)
+        {
+            ofLogVerbose("ofxOAuthClient::obtainAccessToken") << i << " >" << argv[i] << "<";
+        }
+    }
+    
+    // free our parameter arrays that were allocated during parsing above    
+    oauth_free_array(&argc, &argv);
+
+    metrics.record(ofxOAuthMetrics::getEndpoint(getAccessTokenURL()), ofxOAuthMetrics::SIGN, signStart.elapsed());
+    
+    // construct the Authorization header.  Include realm information if available.
+    if(!realm.empty())
+    {
+        // Note that (optional) 'realm' is not to be 
+        // included in the oauth signed parameters and thus only added here.
+        // see 9.1.1 in http://oauth.net/core/1.0/#anchor14
+        http_hdr = "Authorization: OAuth realm=\"" + realm + "\", " + req_hdr; 
+    }
+    else
+    {
+        http_hdr = "Authorization: OAuth " + req_hdr; 
+    }
+    
+    ofLogVerbose("ofxOAuthClient::obtainAccessToken") << "request URL    >" << req_url << "<";
+    ofLogVerbose("ofxOAuthClient::obtainAccessToken") << "request HEADER >" << req_hdr << "<";
+    ofLogVerbose("ofxOAuthClient::obtainAccessToken") << "http    HEADER >" << http_hdr << "<";
+    
+    ofxOAuthRequest request;
+    request.method = _getHttpMethod();
+    request.url = req_url;
+    request.headers.push_back(http_hdr); // Authorization header is included here
+
+    ofxOAuthResponse response;
+
+    if(!transport.perform(request, response))
+    {
+        ofLogVerbose("ofxOAuthClient::obtainAccessToken") << "Transfer failed: " << response.errorMessage;
+    }
+    else
+    {
+        reply = response.body;
+    }
+
+    if (reply.empty())
+    {
+        ofLogVerbose("ofxOAuthClient::obtainAccessToken") << "HTTP request for an oauth request-token failed.";
+    }
+    else
+    {
+        ofLogVerbose("ofxOAuthClient::obtainAccessToken") << "HTTP-Reply >" << reply << "<";
+        
+        Poco::Timestamp parseStart;
+
+        ofxOAuthFormDecoder decoder(reply);
+        ofxOAuthFormDecoder::Field field;
+
+        while(decoder.next(field))
+        {
+            if(field.hasValue)
+            {
+                std::string key = field.key.str();
+                std::string value = field.value.str();
+
+                returnParams[key] = value;
+
+                switch(field.id)
+                {
+                    case ofxOAuthFormDecoder::OAUTH_TOKEN:
+                        accessToken = value;
+                        break;
+                    case ofxOAuthFormDecoder::OAUTH_TOKEN_SECRET:
+                        accessTokenSecret = value;
+                        break;
+                    case ofxOAuthFormDecoder::OAUTH_PROBLEM:
+                        ofLogError("ofxOAuthClient::obtainAccessToken") << "Got oauth problem: " << value;
+                        break;
+                    default:
+                        ofLogNotice("ofxOAuthClient::obtainAccessToken") << "got an unknown parameter: " << key << "=" << value;
+                        customInfo[key] = value;
+                        break;
+                }
+            }
+            else
+            {
+                ofLogWarning("ofxOAuthClient::obtainAccessToken") << "Return parameter did not have a value: "  << field.key.str() << " - skipping.";
+            }
+        }
+
+        metrics.record(ofxOAuthMetrics::getEndpoint(getAccessTokenURL()), ofxOAuthMetrics::PARSE, parseStart.elapsed());
+    }
+    
+    if(accessTokenSecret.empty())
+    {
+        ofLogWarning("ofxOAuthClient::obtainAccessToken") << "Access token secret not returned.";
+        accessFailed = true;
+    }
+    
+    if(accessToken.empty())
+    {
+        ofLogWarning("ofxOAuthClient::obtainAccessToken") << "Access token not returned.";
+        accessFailed = true;
+    }
+    
+    // save it to an xml file!
+    saveCredentials();
+    
+    return returnParams;
+}
+
+
+std::string ofxOAuthClient::requestUserVerification(bool launchBrowser)
+{
+    return requestUserVerification("",launchBrowser);
+}
+
+//--------------------------------------------------------------
+std::string ofxOAuthClient::requestUserVerification(std::string additionalAuthParams,
+                                                    bool launchBrowser)
+{
+    
+    std::string url = getAuthorizationURL();
+    
+    if(url.empty())
+    {
+        ofLogError("ofxOAuthClient::requestUserVerification") << "Authorization URL is not set.";
+        return "";
+    }
+    
+    url += "oauth_token=";
+    url += getRequestToken();
+    url += additionalAuthParams;
+
+    if(launchBrowser) this->launchBrowser(url);
+
+    return url;
+}
+
+
+void ofxOAuthClient::beginVerification()
+{
+    ofLogVerbose("ofxOAuthClient::beginVerification") << "Expecting verifiy key input via a non server method (i.e. text input.)";
+    ofLogVerbose("ofxOAuthClient::beginVerification") << "\t\tThis is done via 'oob' (Out-of-band OAuth authentication).";
+    ofLogVerbose("ofxOAuthClient::beginVerification") << "\t\tCall setRequestTokenVerifier() with a verification code to continue.";
+}
+
+
+void ofxOAuthClient::endVerification()
+{
+}
+
+
+void ofxOAuthClient::launchBrowser(const std::string& url)
+{
+    ofLogNotice("ofxOAuthClient::launchBrowser") << "Authorize this application at : " << url;
+}
+
+
+std::string ofxOAuthClient::getDataPath(const std::string& path) const
+{
+    return path;
+}
+
+
+std::string ofxOAuthClient::getApiURL()
+{
+    return apiURL;
+}
+
+
+void ofxOAuthClient::setApiURL(const std::string &v, bool autoSetEndpoints)
+{
+    apiURL = v; 
+    if(autoSetEndpoints)
+    {
+        setRequestTokenURL(apiURL + "/oauth/request_token");
+        setAccessTokenURL(apiURL + "/oauth/access_token");
+        setAuthorizationURL(apiURL + "/oauth/authorize");
+    }
+}
+
+
+std::string ofxOAuthClient::getRequestTokenURL()
+{
+    return requestTokenURL;
+}
+
+
+void ofxOAuthClient::setRequestTokenURL(const std::string& v)
+{
+    requestTokenURL = appendQuestionMark(v);
+}
+
+
+std::string ofxOAuthClient::getAccessTokenURL()
+{
+    return accessTokenURL;
+}
+
+
+void ofxOAuthClient::setAccessTokenURL(const std::string& v)
+{
+    accessTokenURL = appendQuestionMark(v);
+}
+
+
+std::string ofxOAuthClient::getAuthorizationURL()
+{
+    return authorizationURL;
+}
+
+
+void ofxOAuthClient::setAuthorizationURL(const std::string& v)
+{
+    authorizationURL = appendQuestionMark(v);
+}
+
+
+std::string ofxOAuthClient::getVerifierCallbackURL()
+{
+    return verifierCallbackURL;
+}
+
+
+void ofxOAuthClient::setVerifierCallbackURL(const std::string& v)
+{
+    verifierCallbackURL = v;
+}
+
+
+void ofxOAuthClient::setApplicationDisplayName(const std::string& v)
+{
+    applicationDisplayName = v;
+}
+
+
+std::string ofxOAuthClient::getApplicationDisplayName()
+{
+    return applicationDisplayName;
+}
+
+
+void ofxOAuthClient::setApplicationScope(const std::string& v)
+{
+    // google specific
+    applicationScope = v;
+}
+
+
+std::string ofxOAuthClient::getApplicationScope()
+{
+    return applicationScope;
+}
+
+
+std::string ofxOAuthClient::getRequestToken()
+{
+    return requestToken;
+}
+
+
+void ofxOAuthClient::setRequestToken(const std::string& v)
+{
+    requestToken = v;
+}
+
+
+std::string ofxOAuthClient::getRequestTokenSecret()
+{
+    return requestTokenSecret;
+}
+
+
+void ofxOAuthClient::setRequestTokenSecret(const std::string& v)
+{
+    requestTokenSecret = v;
+}
+
+
+std::string ofxOAuthClient::getRequestTokenVerifier()
+{
+    return requestTokenVerifier;
+}
+
+
+void ofxOAuthClient::setRequestTokenVerifier(const std::string& _requestToken,
+                                             const std::string& _requestTokenVerifier)
+{
+    if(_requestToken == getRequestToken())
+    {
+        setRequestTokenVerifier(_requestTokenVerifier);
+    }
+    else
+    {
+        ofLogError("ofxOAuthClient::getRequestToken") << "The request token didn't match the request token on record.";
+    }
+}
+
+
+void ofxOAuthClient::setRequestTokenVerifier(const std::string& v)
+{
+    requestTokenVerifier = v;
+}
+
+
+std::string ofxOAuthClient::getAccessToken()
+{
+    return accessToken;
+}
+
+
+void ofxOAuthClient::setAccessToken(const std::string& v)
+{
+    accessToken = v;
+}
+
+
+std::string ofxOAuthClient::getAccessTokenSecret()
+{
+    return accessTokenSecret;
+}
+
+
+void ofxOAuthClient::setAccessTokenSecret(const std::string& v)
+{
+    accessTokenSecret = v;
+}
+
+
+std::string ofxOAuthClient::getEncodedUserId()
+{
+    return encodedUserId;
+}
+
+
+void ofxOAuthClient::setEncodedUserId(const std::string& v)
+{
+    encodedUserId = v;
+}
+
+
+std::string ofxOAuthClient::getUserId()
+{
+    return userId;
+}
+
+
+void ofxOAuthClient::setUserId(const std::string& v)
+{
+    userId = v;
+    credentialVaultAccount = v;
+}
+
+
+std::string ofxOAuthClient::getEncodedUserPassword()
+{
+    return encodedUserPassword;
+}
+
+
+void ofxOAuthClient::setEncodedUserPassword(const std::string& v)
+{
+    encodedUserPassword = v;
+}
+
+
+std::string ofxOAuthClient::getUserPassword()
+{
+    return userPassword;
+}
+
+
+void ofxOAuthClient::setUserPassword(const std::string& v)
+{
+    userPassword = v;
+}
+
+
+std::string ofxOAuthClient::getConsumerKey() const
+{
+    return consumerKey;
+}
+
+
+void ofxOAuthClient::setConsumerKey(const std::string& v)
+{
+    consumerKey = v;
+}
+
+std::string ofxOAuthClient::getConsumerSecret() const
+{
+    return consumerSecret;
+}
+
+
+void ofxOAuthClient::setConsumerSecret(const std::string& v)
+{
+    consumerSecret = v;
+}
+
+
+void ofxOAuthClient::setApiName(const std::string& v)
+{
+    apiName = v;
+}
+
+
+std::string ofxOAuthClient::getApiName() const
+{
+    return apiName;
+}
+
+std::string ofxOAuthClient::getRealm() const
+{
+    return realm;
+}
+
+
+void ofxOAuthClient::setRealm(const std::string& v)
+{
+    realm = v;
+}
+
+
+bool ofxOAuthClient::isAuthorized()
+{
+    return !accessToken.empty() && !accessTokenSecret.empty();
+}
+
+
+void ofxOAuthClient::saveCredentials()
+{
+    // the writer serializes and writes on its own thread, so we only hand
+    // it a copy of the current state here.
+    ofxOAuthCredentials credentials;
+
+    credentials.apiName = apiName;
+    credentials.apiURL = apiURL;
+
+    credentials.consumerKey = consumerKey;
+    credentials.consumerSecret = consumerSecret;
+
+    credentials.accessToken = accessToken;
+    credentials.accessTokenSecret = accessTokenSecret;
+
+    credentials.screenName = screenName;
+    credentials.userId = userId;
+    credentials.encodedUserId = encodedUserId;
+    credentials.userPassword = userPassword;
+    credentials.encodedUserPassword = encodedUserPassword;
+
+    std::string pathname = getDataPath(credentialsPathname);
+
+    if(!credentialsPassphrase.empty())
+    {
+        // the vault is updated in memory now and sealed on the writer
+        // thread, so back to back saves only encrypt and write once.
+        if(openCredentialVault() && credentialVault->put(credentialVaultAccount, credentials))
+        {
+            std::shared_ptr<ofxOAuthCredentialVault> vault = credentialVault;
+            credentialWriter.save(pathname, [vault]()
+            {
+                return vault->seal();
+            });
+        }
+        else
+        {
+            ofLogError("ofxOAuthClient::saveCredentials") << "Unable to add credentials to the vault : " << pathname;
+        }
+    }
+    else
+    {
+        credentialWriter.save(pathname, credentials);
+    }
+
+    if(0 != credentialStore)
+    {
+        // providers like twitter return the user id with the access token.
+        if(credentials.userId.empty() && customInfo.count("user_id"))
+        {
+            credentials.userId = customInfo["user_id"];
+        }
+
+        if(credentials.screenName.empty() && customInfo.count("screen_name"))
+        {
+            credentials.screenName = customInfo["screen_name"];
+        }
+
+        if(!credentialStore->put(credentials))
+        {
+            ofLogError("ofxOAuthClient::saveCredentials") << "Unable to add credentials to the credential store for user id : " << credentials.userId;
+        }
+    }
+}
+
+
+void ofxOAuthClient::loadCredentials()
+{
+    ofxOAuthCredentials credentials;
+
+    // a credential store, if set, takes precedence for a known user.
+    if(0 != credentialStore && !userId.empty() && credentialStore->get(userId, credentials))
+    {
+        if(!credentials.apiName.empty()) apiName = credentials.apiName;
+
+        accessToken         = credentials.accessToken;
+        accessTokenSecret   = credentials.accessTokenSecret;
+        screenName          = credentials.screenName;
+        return;
+    }
+
+    bool loaded = false;
+
+    if(!credentialsPassphrase.empty())
+    {
+        // decrypted once; later calls are served from memory.
+        loaded = openCredentialVault() && credentialVault->get(credentialVaultAccount, credentials);
+    }
+    else
+    {
+        loaded = ofxOAuthCredentialsXML::load(getDataPath(credentialsPathname), credentials);
+    }
+
+    if(loaded)
+    {
+        if(!consumerKey.empty() &&
+           (credentials.consumerKey != consumerKey ||
+            credentials.consumerSecret != consumerSecret))
+        {
+            ofLogError("ofxOAuthClient::loadCredentials") << "Found a credential file, but did not match the consumer secret / key provided.  Please delete your credentials file: " + getDataPath(credentialsPathname) + " and try again.";
+            return;
+        }
+
+
+        if(credentials.accessToken.empty() ||
+           credentials.accessTokenSecret.empty())
+        {
+            ofLogError("ofxOAuthClient::loadCredentials") << "Found a credential file, but access token / secret were empty.  Please delete your credentials file: " + getDataPath(credentialsPathname) + " and try again.";
+            return;
+        }
+
+        // the token endpoints set up by the app are kept.
+        if (!credentials.apiURL.empty())
+        {
+            setApiURL(credentials.apiURL, false);
+        }
+
+        apiName             = credentials.apiName;
+
+        accessToken         = credentials.accessToken;
+        accessTokenSecret   = credentials.accessTokenSecret;
+
+        screenName          = credentials.screenName;
+        
+        userId              = credentials.userId;
+        encodedUserId       = credentials.encodedUserId;
+
+        userPassword        = credentials.userPassword;
+        encodedUserPassword = credentials.encodedUserPassword;
+    }
+    else
+    {
+        ofLogNotice("ofxOAuthClient::loadCredentials") << "Unable to locate credentials file: " << getDataPath(credentialsPathname);
+    }
+    
+}
+
+
+void ofxOAuthClient::setCredentialsPathname(const std::string& credentials)
+{
+    credentialsPathname = credentials;
+    credentialVault.reset(); // reopened from the new location on demand
+}
+
+
+std::string ofxOAuthClient::getCredentialsPathname()
+{
+    return credentialsPathname;
+}
+
+
+void ofxOAuthClient::setCredentialStore(std::shared_ptr<ofxOAuthCredentialStore> store)
+{
+    credentialStore = store;
+}
+
+
+std::shared_ptr<ofxOAuthCredentialStore> ofxOAuthClient::getCredentialStore() const
+{
+    return credentialStore;
+}
+
+
+void ofxOAuthClient::setResponseCacheEnabled(bool enabled)
+{
+    if(enabled && 0 == responseCache)
+    {
+        responseCache = std::shared_ptr<ofxOAuthResponseCache>(new ofxOAuthResponseCache());
+    }
+    else if(!enabled)
+    {
+        responseCache.reset();
+    }
+}
+
+
+bool ofxOAuthClient::isResponseCacheEnabled() const
+{
+    return 0 != responseCache;
+}
+
+
+std::shared_ptr<ofxOAuthResponseCache> ofxOAuthClient::getResponseCache() const
+{
+    return responseCache;
+}
+
+
+void ofxOAuthClient::setRequestCoalescingEnabled(bool enabled)
+{
+    requestCoalescingEnabled = enabled;
+}
+
+
+bool ofxOAuthClient::isRequestCoalescingEnabled() const
+{
+    return requestCoalescingEnabled;
+}
+
+
+ofxOAuthSingleFlight::Stats ofxOAuthClient::getRequestCoalescingStats() const
+{
+    return singleFlight.getStats();
+}
+
+
+void ofxOAuthClient::setRetrySettings(const ofxOAuthRetryPolicy::Settings& settings)
+{
+    retryPolicy.setSettings(settings);
+}
+
+
+ofxOAuthRetryPolicy::Settings ofxOAuthClient::getRetrySettings() const
+{
+    return retryPolicy.getSettings();
+}
+
+
+ofxOAuthRetryPolicy::Stats ofxOAuthClient::getRetryStats() const
+{
+    return retryPolicy.getStats();
+}
+
+
+ofxOAuthMetrics& ofxOAuthClient::getMetrics()
+{
+    return metrics;
+}
+
+
+const ofxOAuthMetrics& ofxOAuthClient::getMetrics() const
+{
+    return metrics;
+}
+
+
+std::vector<ofxOAuthMetrics::EndpointSnapshot> ofxOAuthClient::getMetricsSnapshot() const
+{
+    return metrics.getSnapshot();
+}
+
+
+bool ofxOAuthClient::startMetricsServer(int port)
+{
+    stopMetricsServer();
+
+    metricsServer = std::make_shared<ofxOAuthMetricsServer>(metrics, port);
+
+    if(!metricsServer->start())
+    {
+        metricsServer.reset();
+        return false;
+    }
+
+    return true;
+}
+
+
+void ofxOAuthClient::stopMetricsServer()
+{
+    if(metricsServer)
+    {
+        metricsServer->stop();
+        metricsServer.reset();
+    }
+}
+
+
+void ofxOAuthClient::setCircuitBreakerSettings(const ofxOAuthCircuitBreaker::Settings& settings)
+{
+    transport.getCircuitBreaker().setSettings(settings);
+}
+
+
+ofxOAuthCircuitBreaker::Settings ofxOAuthClient::getCircuitBreakerSettings() const
+{
+    return transport.getCircuitBreaker().getSettings();
+}
+
+
+std::vector<ofxOAuthCircuitBreaker::Stats> ofxOAuthClient::getCircuitBreakerStats() const
+{
+    return transport.getCircuitBreaker().getStats();
+}
+
+
+long ofxOAuthClient::getClockOffset() const
+{
+    return clock.getOffset();
+}
+
+
+unsigned long long ofxOAuthClient::getClockRejectionCount() const
+{
+    return clock.getRejectionCount();
+}
+
+
+void ofxOAuthClient::setHedgingSettings(const ofxOAuthHedger::Settings& settings)
+{
+    hedger.setSettings(settings);
+}
+
+
+ofxOAuthHedger::Settings ofxOAuthClient::getHedgingSettings() const
+{
+    return hedger.getSettings();
+}
+
+
+ofxOAuthHedger::Stats ofxOAuthClient::getHedgingStats() const
+{
+    return hedger.getStats();
+}
+
+
+void ofxOAuthClient::setRequestTimeouts(long connectTimeoutMillis, long timeoutMillis)
+{
+    transport.setTimeouts(connectTimeoutMillis, timeoutMillis);
+}
+
+
+void ofxOAuthClient::setCompressionEnabled(bool enabled)
+{
+    transport.setCompressionEnabled(enabled);
+}
+
+
+bool ofxOAuthClient::isCompressionEnabled() const
+{
+    return transport.isCompressionEnabled();
+}
+
+
+void ofxOAuthClient::setSSLVerificationEnabled(bool enabled)
+{
+    transport.setSSLVerificationEnabled(enabled);
+}
+
+
+bool ofxOAuthClient::isSSLVerificationEnabled() const
+{
+    return transport.isSSLVerificationEnabled();
+}
+
+
+void ofxOAuthClient::setBodyHashEnabled(bool enabled)
+{
+    bodyHashEnabled = enabled;
+}
+
+
+bool ofxOAuthClient::isBodyHashEnabled() const
+{
+    return bodyHashEnabled;
+}
+
+
+void ofxOAuthClient::setCredentialsPassphrase(const std::string& passphrase)
+{
+    credentialsPassphrase = passphrase;
+    credentialVault.reset();
+}
+
+
+bool ofxOAuthClient::openCredentialVault()
+{
+    if(0 != credentialVault && credentialVault->isOpen())
+    {
+        return true;
+    }
+
+    std::string pathname = getDataPath(credentialsPathname);
+
+    std::shared_ptr<ofxOAuthCredentialVault> vault(new ofxOAuthCredentialVault());
+
+    ofxOAuthCredentials credentials;
+
+    // a credentials.xml saved before the passphrase was set.
+    if(!ofxOAuthCredentialVault::isVault(pathname) &&
+       ofxOAuthCredentialsXML::load(pathname, credentials))
+    {
+        // the file's user id is kept; the account is the one
+        // saveCredentials() writes to.
+        if(!vault->create(pathname, credentialsPassphrase) || !vault->put(credentialVaultAccount, credentials))
+        {
+            ofLogError("ofxOAuthClient::openCredentialVault") << "Unable to import the plaintext credentials file : " << pathname;
+            return false;
+        }
+
+        ofLogNotice("ofxOAuthClient::openCredentialVault") << "Imported the plaintext credentials file, it will be saved encrypted : " << pathname;
+
+        credentialWriter.save(pathname, [vault]()
+        {
+            return vault->seal();
+        });
+    }
+    else if(!vault->open(pathname, credentialsPassphrase))
+    {
+        ofLogError("ofxOAuthClient::openCredentialVault") << "Unable to open the credential vault (wrong passphrase or corrupt file) : " << pathname;
+        return false;
+    }
+
+    if(!vault->isLocked())
+    {
+        ofLogWarning("ofxOAuthClient::openCredentialVault") << "Unable to lock the credential vault into memory, it may be swapped to disk.";
+    }
+
+    credentialVault = vault;
+
+    return true;
+}
+
+
+void ofxOAuthClient::resetErrors()
+{
+    accessFailed = false;
+    accessFailedReported = false;
+}
+
+
+ofxOAuthClient::AuthMethod ofxOAuthClient::getOAuthMethod()
+{
+    return oauthMethod;
+}
+
+
+void ofxOAuthClient::setOAuthMethod(AuthMethod _oauthMethod)
+{
+    oauthMethod = _oauthMethod;
+}
+
+
+void ofxOAuthClient::setSSLCACertificateFile(const std::string& pathname)
+{
+    SSLCACertificateFile = getDataPath(pathname);
+
+    struct stat statbuf;
+
+    if(stat(SSLCACertificateFile.c_str(), &statbuf) == 0)
+    {
+        transport.setSSLCACertificateFile(SSLCACertificateFile);
+    }
+    else
+    {
+        // curl cannot verify against a missing bundle; use its default.
+        ofLogWarning("ofxOAuthClient::setSSLCACertificateFile") << "No CA bundle at " << SSLCACertificateFile << ", using the system default.";
+        transport.setSSLCACertificateFile("");
+    }
+
+    // setenv("CURLOPT_CAINFO", ofToDataPath(SSLCACertificateFile,true).c_str(), true);
+    ofLogVerbose("ofxOAuthClient::setSSLCACertificateFile") << "Set CACERT to : " << SSLCACertificateFile;
+}
+
+
+OAuthMethod ofxOAuthClient::_getOAuthMethod()
+{
+    switch (oauthMethod)
+    {
+        case OFX_OA_HMAC:
+            return OA_HMAC;
+        case OFX_OA_RSA:
+            return OA_RSA;
+        case OFX_OA_PLAINTEXT:
+            return OA_PLAINTEXT;
+        default:
+            ofLogError("ofxOAuthClient::_getOAuthMethod") << "Unknown OAuthMethod, defaulting to OA_HMAC. oauthMethod=" << oauthMethod;
+            return OA_HMAC;
+    }
+}
+
+
+std::string ofxOAuthClient::_getHttpMethod()
+{
+    return _getHttpMethod(httpMethod);
+}
+
+
+std::string ofxOAuthClient::_getHttpMethod(AuthHttpMethod method) const
+{
+    switch (method)
+    {
+        case OFX_HTTP_GET:
+            return "GET";
+        case OFX_HTTP_POST:
+            return "POST";
+        case OFX_HTTP_PUT:
+            return "PUT";
+        case OFX_HTTP_DELETE:
+            return "DELETE";
+        case OFX_HTTP_PATCH:
+            return "PATCH";
+        case OFX_HTTP_HEAD:
+            return "HEAD";
+        default:
+            ofLogError("ofxOAuthClient::_getHttpMethod") << "Unknown HttpMethod, defaulting to GET. httpMethod=" << method;
+            return "GET";
+    }
+}
+
+
+void ofxOAuthClient::_appendBodyHash(std::string& query, const std::string& bodyHash) const
+{
+    std::string::size_type equals = bodyHash.find('=');
+
+    if(equals == std::string::npos) return;
+
+    char* value = oauth_url_escape(bodyHash.substr(equals + 1).c_str());
+
+    if(0 != value)
+    {
+        if(!query.empty()) query += "&";
+        query += bodyHash.substr(0, equals + 1) + value;
+        free(value);
+    }
+}
+
+
+std::string ofxOAuthClient::_getRequestKey(const std::string& uri, const std::string& query) const
+{
+    std::string url = apiURL + uri + "?" + query;
+
+    int  argc   = 0;
+    char **argv = 0;
+
+    argc = oauth_split_url_parameters(url.c_str(), &argv);
+
+    if(argc > 1)
+    {
+        qsort(&argv[1], argc - 1, sizeof(char *), oauth_cmpstringp);
+    }
+
+    std::string req_url;
+
+    char* p_req_url = oauth_serialize_url_sep(argc, 0, argv, const_cast<char *>("&"), 1);
+
+    if(0 != p_req_url)
+    {
+        req_url = p_req_url;
+        free(p_req_url);
+    }
+
+    oauth_free_array(&argc, &argv);
+
+    return ofxOAuthResponseCache::makeKey("GET", req_url, accessToken);
+}
+
+
+void ofxOAuthClient::_addTimestamp(int* argc, char*** argv) const
+{
+    if(0 == clock.getOffset()) return;
+
+    // liboauth only generates the parameters that are missing.
+    std::string timestampParam = "oauth_timestamp=" + std::to_string((long long)clock.now());
+    oauth_add_param_to_array(argc, argv, timestampParam.c_str());
+}
+
+
+std::string ofxOAuthClient::appendQuestionMark(const std::string& url) const
+{
+    std::string u = url;
+    if(!u.empty() && u.substr(u.size()-1,u.size()-1) != "?") u += "?"; // need that
+    return u;
+}
@@ -0,0 +1,594 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <oauth.h>
+#include "Poco/String.h"
+#include "ofxOAuthAsyncResponse.h"
+#include "ofxOAuthBodyHash.h"
+#include "ofxOAuthChunkedUpload.h"
+#include "ofxOAuthCircuitBreaker.h"
+#include "ofxOAuthClock.h"
+#include "ofxOAuthCredentialStore.h"
+#include "ofxOAuthCredentialVault.h"
+#include "ofxOAuthCredentialWriter.h"
+#include "ofxOAuthCredentialsXML.h"
+#include "ofxOAuthExecutor.h"
+#include "ofxOAuthFormDecoder.h"
+#include "ofxOAuthHedger.h"
+#include "ofxOAuthJSONExtractor.h"
+#include "ofxOAuthLog.h"
+#include "ofxOAuthMetrics.h"
+#include "ofxOAuthMetricsServer.h"
+#include "ofxOAuthMultipartForm.h"
+#include "ofxOAuthPaginator.h"
+#include "ofxOAuthResponseCache.h"
+#include "ofxOAuthRetryPolicy.h"
+#include "ofxOAuthSingleFlight.h"
+#include "ofxOAuthTransport.h"
+#include "ofxOAuthUploadSource.h"
+
+
+// The signing, transport, credential and token flow core of ofxOAuth.  It
+// does not depend on openFrameworks, so it can run in a headless process
+// (build with OFX_OAUTH_HEADLESS defined, see ofxOAuthLog.h).  ofxOAuth
+// adapts it to an app: it drives update() from the frame loop, launches the
+// browser, runs the verifier callback server and resolves data paths.
+//
+// Without an app, drive the token flow by calling update() until
+// isAuthorized(), or step through it directly:
+//
+//      client.obtainRequestToken();
+//      std::string url = client.requestUserVerification(false);
+//      // ... the user approves at url and reports the verifier ...
+//      client.setRequestTokenVerifier(verifier);
+//      client.obtainAccessToken();
+//
+class ofxOAuthClient
+{
+public:
+    enum AuthMethod
+    {
+        OFX_OA_HMAC=0,
+        OFX_OA_RSA,
+        OFX_OA_PLAINTEXT
+    };
+
+    enum AuthHttpMethod
+    {
+        OFX_HTTP_GET,
+        OFX_HTTP_POST,
+        OFX_HTTP_PUT,
+        OFX_HTTP_DELETE,
+        OFX_HTTP_PATCH,
+        OFX_HTTP_HEAD
+    };
+
+    ofxOAuthClient();
+
+    virtual ~ofxOAuthClient();
+
+    void setup();
+
+    void setup(const std::string& apiURL,
+               const std::string& consumerKey,
+               const std::string& consumerSecret);
+    
+    void setup(const std::string& apiURL,
+               const std::string& requestTokenUrl,
+               const std::string& accessTokenUrl,
+               const std::string& authorizeUrl,
+               const std::string& consumerKey,
+               const std::string& consumerSecret);
+
+    // Advances the token flow by one step: obtains a request token, asks
+    // for user verification, then trades the verifier for an access token.
+    // Also runs the continuations queued on getUpdateExecutor().
+    void update();
+    
+    bool isAuthorized();
+
+    // Every request method takes optional per-call timeouts and a
+    // cancellation token, see ofxOAuthRequestOptions.  Calls with any of
+    // them set are not coalesced.
+    std::string get(const std::string& uri,
+                    const std::string& queryParams = "",
+                    const ofxOAuthRequestOptions& options = ofxOAuthRequestOptions());
+
+    // A get() whose reply is scanned by extractor as it arrives instead of
+    // being kept, see ofxOAuthJSONExtractor.  Error replies (4xx / 5xx)
+    // are kept in response.body.  Returns true for a successful reply
+    // holding complete JSON.  Retried like get(), but not hedged, coalesced
+    // or cached.
+    bool get(const std::string& uri,
+             const std::string& queryParams,
+             ofxOAuthJSONExtractor& extractor,
+             ofxOAuthResponse& response,
+             const ofxOAuthRequestOptions& options = ofxOAuthRequestOptions());
+
+    std::string post(const std::string& uri,
+                     const std::string& queryParams = "",
+                     const ofxOAuthRequestOptions& options = ofxOAuthRequestOptions());
+    
+    std::string postfile_multipartdata(const std::string& uri,
+                     const std::string& queryParams = "",
+                     const std::string& filefieldname = "",
+                     const std::string& filepath = "");
+
+    // Posts a file straight from memory (e.g. an encoded frame), without
+    // writing it to disk first.  The data is not copied.
+    std::string postfile_multipartdata(const std::string& uri,
+                     const std::string& queryParams,
+                     const std::string& filefieldname,
+                     const void* data,
+                     std::size_t size,
+                     const std::string& filename,
+                     const std::string& contentType = "");
+
+    // Posts any number of fields and files (from disk or memory) in one
+    // multipart request.
+    std::string post_multipartdata(const std::string& uri,
+                     ofxOAuthMultipartForm& form);
+
+    // Performs a signed request with any method.  A cancellation token, if
+    // given in options, aborts the transfer when cancelled from another
+    // thread.  The query is sent (and
+    // signed) in the url, except for a POST, PUT or PATCH without a body,
+    // where it is sent as a form-urlencoded body.  A non-empty body is sent
+    // as is.  A HEAD request never downloads a body.
+    bool request(AuthHttpMethod method,
+                 const std::string& uri,
+                 const std::string& queryParams,
+                 const std::string& body,
+                 ofxOAuthResponse& response,
+                 const std::string& contentType = "application/octet-stream",
+                 const ofxOAuthRequestOptions& options = ofxOAuthRequestOptions());
+
+    // As above, returning the response body (empty on failure).
+    std::string request(AuthHttpMethod method,
+                        const std::string& uri,
+                        const std::string& queryParams = "",
+                        const std::string& body = "",
+                        const ofxOAuthRequestOptions& options = ofxOAuthRequestOptions());
+
+    // Signs the request on the calling thread and returns at once; the
+    // transfer runs on the transport's I/O thread, shared by every
+    // asynchronous request.  Take the response with then() or co_await,
+    // see ofxOAuthAsyncResponse.  Failures are corrected and retried as
+    // for request(), with the backoff waited out on the I/O thread rather
+    // than a thread of the caller's; hedging and the response cache apply
+    // to the blocking calls only.  getAsync() coalesces like get().
+    ofxOAuthAsyncResponse requestAsync(AuthHttpMethod method,
+                                       const std::string& uri,
+                                       const std::string& queryParams = "",
+                                       const std::string& body = "",
+                                       const std::string& contentType = "application/octet-stream",
+                                       const ofxOAuthRequestOptions& options = ofxOAuthRequestOptions());
+
+    // Asynchronous get(), post() and postfile_multipartdata(), sent as
+    // those are.  Each returns at once; every call shares the one I/O
+    // thread and its connections, however many are in flight.
+    ofxOAuthAsyncResponse getAsync(const std::string& uri,
+                                   const std::string& queryParams = "",
+                                   const ofxOAuthRequestOptions& options = ofxOAuthRequestOptions());
+
+    // getAsync() through an extractor.  Its values are complete when the
+    // response arrives; its listener hears of each one as soon as it is.
+    ofxOAuthAsyncResponse getAsync(const std::string& uri,
+                                   const std::string& queryParams,
+                                   std::shared_ptr<ofxOAuthJSONExtractor> extractor,
+                                   const ofxOAuthRequestOptions& options = ofxOAuthRequestOptions());
+
+    // Pages through settings.uri with getAsync(), prefetching ahead of the
+    // caller, see ofxOAuthPaginator.  The client must outlive it.
+    std::shared_ptr<ofxOAuthPaginator> paginate(const ofxOAuthPaginator::Settings& settings);
+
+    ofxOAuthAsyncResponse postAsync(const std::string& uri,
+                                    const std::string& queryParams = "",
+                                    const ofxOAuthRequestOptions& options = ofxOAuthRequestOptions());
+
+    ofxOAuthAsyncResponse postFileAsync(const std::string& uri,
+                                        const std::string& queryParams = "",
+                                        const std::string& filefieldname = "",
+                                        const std::string& filepath = "");
+
+    // The data is not copied and must outlive the request.
+    ofxOAuthAsyncResponse postFileAsync(const std::string& uri,
+                                        const std::string& queryParams,
+                                        const std::string& filefieldname,
+                                        const void* data,
+                                        std::size_t size,
+                                        const std::string& filename,
+                                        const std::string& contentType = "");
+
+    // Runs continuations inside update(), i.e. on the openFrameworks main
+    // thread for ofxOAuth.  Pass it to then() or resumeOn().
+    ofxOAuthQueueExecutor& getUpdateExecutor();
+
+    // Posts a file as the raw request body, streamed from a memory mapping.
+    // Query parameters are sent (and signed) in the url.  If body hashing is
+    // enabled, an oauth_body_hash is computed from the same mapping.
+    std::string postfile(const std::string& uri,
+                         const std::string& queryParams,
+                         const std::string& filepath,
+                         const std::string& contentType = "application/octet-stream");
+
+    // Connect and total deadlines, in milliseconds, for every request made
+    // through the transport.  0 means no limit.  If OAUTH_CURL_TIMEOUT is
+    // defined it is used as the default total deadline (in seconds).
+    void setRequestTimeouts(long connectTimeoutMillis, long timeoutMillis);
+
+    // Ask for gzip or deflate encoded responses, inflated as they arrive.
+    // On by default.  getMetrics() counts body bytes both as received and
+    // as decoded.
+    void setCompressionEnabled(bool enabled);
+    bool isCompressionEnabled() const;
+
+    // Include an oauth_body_hash in requests with a raw (non-form) body, for
+    // providers that require it.  Off by default.
+    void setBodyHashEnabled(bool enabled);
+    bool isBodyHashEnabled() const;
+
+    // Uploads a large file through a chunked INIT / APPEND / FINALIZE flow,
+    // several segments at a time.  Progress is checkpointed, so calling this
+    // again after a failure resumes the upload.  Returns once the media is
+    // processed, if the server processes it.  settings.url is absolute.
+    bool postfile_chunked(const ofxOAuthChunkedUpload::Settings& settings,
+                          const std::string& filepath,
+                          std::string& mediaId);
+
+    // Signs a request with the access token and returns the complete
+    // "Authorization: OAuth ..." header.  query holds any form-urlencoded
+    // parameters that are part of the signature base string.
+    std::string getAuthorizationHeader(const std::string& method,
+                                       const std::string& url,
+                                       const std::string& query = "");
+    
+    // getters and setters
+    std::string getApiURL();
+    void setApiURL(const std::string& v, bool autoSetEndpoints = true);
+    
+    std::string getRequestTokenURL();
+    void setRequestTokenURL(const std::string& v);
+    std::string getAccessTokenURL();
+    void setAccessTokenURL(const std::string& v);
+    std::string getAuthorizationURL();
+    void setAuthorizationURL(const std::string& v);
+    std::string getVerifierCallbackURL();
+    void setVerifierCallbackURL(const std::string& v);
+
+    void setApplicationDisplayName(const std::string& v); // xoauth_displayname
+    std::string getApplicationDisplayName();
+    
+    void setApplicationScope(const std::string& v); // google specific
+    std::string getApplicationScope();
+    
+    
+    // request token / secret
+    std::string getRequestToken();
+    void setRequestToken(const std::string& v);
+    std::string getRequestTokenSecret();
+    void setRequestTokenSecret(const std::string& v);
+    std::string getRequestTokenVerifier();
+    void setRequestTokenVerifier(const std::string& requestToken,
+                                 const std::string& requestTokenVerifier);
+    void setRequestTokenVerifier(const std::string& requestTokenVerifier);
+
+    // request access token / secret
+    std::string getAccessToken();
+    void setAccessToken(const std::string& v);
+    std::string getAccessTokenSecret();
+    void setAccessTokenSecret(const std::string& v);
+
+    std::string getScreenName();
+    void setScreenName(const std::string& v);
+    
+    std::string getEncodedUserId();
+    void setEncodedUserId(const std::string& v);
+
+    std::string getUserId();
+    void setUserId(const std::string& v);
+    
+    std::string getEncodedUserPassword();
+    void setEncodedUserPassword(const std::string& v);
+
+    std::string getUserPassword();
+    void setUserPassword(const std::string& v);
+    
+    // request consumer token / secret
+    std::string getConsumerKey() const;
+    void setConsumerKey(const std::string& v);
+    std::string getConsumerSecret() const;
+    void setConsumerSecret(const std::string& v);
+    
+    void setApiName(const std::string& v);
+    std::string getApiName() const;
+
+    std::map<std::string, std::string> getCustomInfo() const;
+
+    // token verifier
+    std::string getRealm() const;
+    void setRealm(const std::string& v);
+    
+    
+    void setSSLCACertificateFile(const std::string& pathname);
+
+    // Certificates are verified (against the CA file above) by default.
+    // Turning this off makes every request open to interception; only do
+    // it to test against a server with a self-signed certificate.
+    void setSSLVerificationEnabled(bool enabled);
+    bool isSSLVerificationEnabled() const;
+
+    // Opt-in cache for get().  Responses with an ETag or Last-Modified
+    // header are kept and revalidated, and 304s are served from the cache.
+    // Use getResponseCache() to size it, add a disk tier or read stats.
+    void setResponseCacheEnabled(bool enabled);
+    bool isResponseCacheEnabled() const;
+    std::shared_ptr<ofxOAuthResponseCache> getResponseCache() const;
+
+    // Identical get() and getAsync() calls (same url and token) made while
+    // one is in flight share its request.  Enabled by default.
+    void setRequestCoalescingEnabled(bool enabled);
+    bool isRequestCoalescingEnabled() const;
+    ofxOAuthSingleFlight::Stats getRequestCoalescingStats() const;
+
+    // Retry failed get(), post(), post_multipartdata() and request() calls
+    // with jittered backoff.  Off by default (1 attempt); see
+    // ofxOAuthRetryPolicy::Settings.
+    void setRetrySettings(const ofxOAuthRetryPolicy::Settings& settings);
+    ofxOAuthRetryPolicy::Settings getRetrySettings() const;
+    ofxOAuthRetryPolicy::Stats getRetryStats() const;
+
+    // Hedge slow get() calls with a freshly signed duplicate.  Off by
+    // default; see ofxOAuthHedger::Settings.
+    void setHedgingSettings(const ofxOAuthHedger::Settings& settings);
+    ofxOAuthHedger::Settings getHedgingSettings() const;
+    ofxOAuthHedger::Stats getHedgingStats() const;
+
+    // Request counts and per-stage latency histograms, per endpoint.  The
+    // metrics server serves them as Prometheus text on 127.0.0.1:port.
+    // Set an endpoint normalizer (see ofxOAuthMetrics) before requesting.
+    ofxOAuthMetrics& getMetrics();
+    const ofxOAuthMetrics& getMetrics() const;
+    std::vector<ofxOAuthMetrics::EndpointSnapshot> getMetricsSnapshot() const;
+    bool startMetricsServer(int port = 9464);
+    void stopMetricsServer();
+
+    // Fail fast on hosts that keep failing instead of waiting out their
+    // timeouts.  On by default; see ofxOAuthCircuitBreaker::Settings.
+    void setCircuitBreakerSettings(const ofxOAuthCircuitBreaker::Settings& settings);
+    ofxOAuthCircuitBreaker::Settings getCircuitBreakerSettings() const;
+    std::vector<ofxOAuthCircuitBreaker::Stats> getCircuitBreakerStats() const;
+
+    // Server time minus local time in seconds, learned from the Date header
+    // of responses and used for oauth_timestamp.  With retries enabled, a
+    // refused timestamp is retried once in corrected time; either way the
+    // requests that follow are signed in corrected time.
+    long getClockOffset() const;
+    unsigned long long getClockRejectionCount() const;
+    
+    
+    void setCredentialsPathname(const std::string& credentials);
+    std::string getCredentialsPathname();
+
+    // Optionally keep credentials in a shared store keyed by user id.  When
+    // set, setup() loads the tokens for getUserId() from the store, and new
+    // access tokens are added to it.
+    void setCredentialStore(std::shared_ptr<ofxOAuthCredentialStore> store);
+    std::shared_ptr<ofxOAuthCredentialStore> getCredentialStore() const;
+
+    // When a passphrase is set, the credentials file is encrypted at rest.
+    // It is decrypted once into locked memory and written back encrypted.
+    // An existing plaintext credentials file is imported and re-saved
+    // encrypted.
+    void setCredentialsPassphrase(const std::string& passphrase);
+    
+    void resetErrors();
+
+    // The steps of the token flow that update() drives, for callers that
+    // drive it themselves.  requestUserVerification() returns the url the
+    // user approves the request token at.
+    std::map<std::string,std::string> obtainRequestToken();
+    std::map<std::string,std::string> obtainAccessToken();
+
+    std::string requestUserVerification(bool launchBrowser = true);
+    std::string requestUserVerification(std::string additionalAuthParams,
+                                        bool launchBrowser = true);
+    
+protected:
+    
+    void saveCredentials();
+    void loadCredentials();
+
+    AuthMethod getOAuthMethod();
+    void setOAuthMethod(AuthMethod v);
+
+    // Hooks for the environment the client runs in.  update() calls
+    // beginVerification() before obtaining a request token, to set up
+    // whatever will receive the verifier, and endVerification() once it is
+    // no longer needed.  By default the verifier is expected out of band,
+    // through setRequestTokenVerifier().
+    virtual void beginVerification();
+    virtual void endVerification();
+
+    // Shows the authorization page to the user.  By default the url is
+    // logged, to be opened by hand.
+    virtual void launchBrowser(const std::string& url);
+
+    // Resolves a relative credentials or certificate path.  By default the
+    // path is used as is.
+    virtual std::string getDataPath(const std::string& path) const;
+
+    
+    std::string credentialsPathname;
+
+    // saves credentials in the background, see saveCredentials().
+    ofxOAuthCredentialWriter credentialWriter;
+
+    std::shared_ptr<ofxOAuthCredentialStore> credentialStore;
+
+    std::string credentialsPassphrase;
+    std::shared_ptr<ofxOAuthCredentialVault> credentialVault;
+    // the vault account in use: the default one unless setUserId() picked
+    // another.  A user id loaded from the vault does not change it.
+    std::string credentialVaultAccount;
+    bool openCredentialVault();
+    
+    // URLS
+    std::string apiURL;
+    
+    std::string requestTokenURL;
+    std::string accessTokenURL;
+    std::string authorizationURL;
+    std::string verifierCallbackURL;
+
+    std::string applicationDisplayName;
+    std::string applicationScope;
+    
+    bool callbackConfirmed;
+    bool verificationRequested;
+    bool accessFailed;
+    bool accessFailedReported;
+    
+    // keys, secrets and verifiers
+    
+    std::string consumerKey;    // provided by the api for each app
+    std::string consumerSecret; // provided by the api for each app
+    
+    std::string requestToken;         // initially acquired via obtainRequestToken()
+    std::string requestTokenSecret;   // initially acquired via obtainRequestToken()
+    std::string requestTokenVerifier;      // acquired via web server callback or manual entry by user
+
+    // the following
+    std::string apiName;
+    std::string accessToken;          // after requestToken, requestTokenSecret and requestVerifier,
+    std::string accessTokenSecret;
+    std::string encodedUserId;
+
+    std::string screenName;
+    std::string userId;
+    std::string encodedUserPassword;
+    std::string userPassword;
+
+
+    // for dta such as screenName, userId, encodedUserPassword, userPassword, etc.
+    std::map<std::string, std::string> customInfo;
+
+    // other stuff
+    
+    std::string realm;
+    AuthMethod oauthMethod;
+    AuthHttpMethod httpMethod;
+    // where is our ssl cert bundles stored?
+    std::string SSLCACertificateFile;
+
+    // fed by the transport, so they are declared (and outlive it) before it
+    ofxOAuthClock clock;
+    ofxOAuthMetrics metrics;
+    ofxOAuthQueueExecutor updateExecutor;
+    std::shared_ptr<ofxOAuthMetricsServer> metricsServer;
+
+    // performs the signed requests
+    ofxOAuthTransport transport;
+    std::shared_ptr<ofxOAuthResponseCache> responseCache;
+    bool requestCoalescingEnabled;
+    ofxOAuthSingleFlight singleFlight;
+    bool bodyHashEnabled;
+    ofxOAuthBodyHashCache bodyHashCache;
+    ofxOAuthHedger hedger;
+    ofxOAuthRetryPolicy retryPolicy;
+
+    // performs a get, revalidating against and updating the response cache
+    bool performCachedGet(ofxOAuthRequest& request,
+                          const std::string& cacheKey,
+                          ofxOAuthHedger::Signer signer,
+                          ofxOAuthResponse& response);
+
+    std::string appendQuestionMark(const std::string& url) const;
+
+private:
+    OAuthMethod _getOAuthMethod();
+    std::string _getHttpMethod();
+    std::string _getHttpMethod(AuthHttpMethod method) const;
+
+    // an asynchronous request on its way through the retry policy
+    struct _AsyncCall
+    {
+        _AsyncCall():
+            isIdempotent(true),
+            state(std::make_shared<ofxOAuthAsyncResponse::State>())
+        {
+        }
+
+        ofxOAuthRequest request;
+        ofxOAuthHedger::Signer signer; //< signs it again for a resend
+        bool isIdempotent;
+        std::shared_ptr<ofxOAuthMultipartForm> form; //< kept alive until done
+        std::function<void()> onResend; //< before each resend
+        std::function<void(ofxOAuthResponse&)> onDone; //< before completing
+        ofxOAuthRetryPolicy::Attempts attempts;
+        std::shared_ptr<ofxOAuthAsyncResponse::State> state;
+    };
+
+    // queues a prepared request on the transport's I/O thread; failures
+    // are corrected and retried from its completion, on that thread
+    ofxOAuthAsyncResponse _performAsync(std::shared_ptr<_AsyncCall> call);
+
+    // queues one attempt, after delay milliseconds
+    void _sendAsync(std::shared_ptr<_AsyncCall> call, long delay);
+
+    // signs a multipart post and queues it
+    ofxOAuthAsyncResponse _postFormAsync(const std::string& uri,
+                                         std::shared_ptr<ofxOAuthMultipartForm> form);
+
+    // builds and signs the request for request() and requestAsync();
+    // signedQuery is the query that was signed, for signing it again
+    bool _prepareRequest(AuthHttpMethod method,
+                         const std::string& uri,
+                         const std::string& query,
+                         const std::string& body,
+                         const std::string& contentType,
+                         ofxOAuthRequest& request,
+                         std::string& signedQuery);
+
+    // appends the escaped oauth_body_hash parameter to a query to be signed
+    void _appendBodyHash(std::string& query, const std::string& bodyHash) const;
+
+    // the key get() and getAsync() coalesce and cache on: the url with its
+    // parameters sorted, as signing leaves them, and the access token
+    std::string _getRequestKey(const std::string& uri, const std::string& query) const;
+
+    // adds oauth_timestamp in server time to an array about to be signed,
+    // unless our clock agrees with the server's
+    void _addTimestamp(int* argc, char*** argv) const;
+
+    std::string _old_curlopt_cainfo; 
+    
+};
@@ -0,0 +1,194 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+#include "Poco/Mutex.h"
+#include "ofxOAuthTransport.h"
+
+
+// Tracks the offset between the local clock and the server's, as seen in
+// the Date header of every response, so that oauth_timestamp can be
+// generated in server time.  A host whose clock has drifted would
+// otherwise have every signed request refused.
+//
+// The offset is smoothed (exponentially weighted) because Date only has a
+// one second resolution and includes the response's travel time.  When the
+// server does refuse a timestamp, correct() snaps the offset to that
+// response's Date so the request can be signed again right away.
+class ofxOAuthClock
+{
+public:
+    ofxOAuthClock(double smoothing = 0.2):
+        _offset(0),
+        _hasOffset(false),
+        _rejectionCount(0),
+        _smoothing(smoothing)
+    {
+    }
+
+    virtual ~ofxOAuthClock()
+    {
+    }
+
+    // Feeds the Date header of a response.  Refused timestamps are left to
+    // correct(), so that it can tell whether signing again would help.
+    // Returns false if the response had no usable Date.
+    bool observe(const ofxOAuthResponse& response)
+    {
+        if(!response.isComplete() || isSkewRejection(response)) return false;
+
+        time_t server = 0;
+
+        if(!parseDate(response.headers.get("Date", ""), server)) return false;
+
+        double sample = difftime(server, time(0));
+
+        Poco::Mutex::ScopedLock lock(_mutex);
+
+        _offset = _hasOffset ? (1 - _smoothing) * _offset + _smoothing * sample : sample;
+        _hasOffset = true;
+
+        return true;
+    }
+
+    // If the response refused our timestamp, adopts the offset from its
+    // Date header.  Returns true if the offset changed, i.e. if signing the
+    // request again is worthwhile.
+    bool correct(const ofxOAuthResponse& response)
+    {
+        if(!isSkewRejection(response)) return false;
+
+        time_t server = 0;
+
+        bool hasDate = parseDate(response.headers.get("Date", ""), server);
+
+        double sample = difftime(server, time(0));
+
+        Poco::Mutex::ScopedLock lock(_mutex);
+
+        ++_rejectionCount;
+
+        if(!hasDate) return false;
+
+        bool changed = !_hasOffset || _round(sample) != _round(_offset);
+
+        _offset = sample;
+        _hasOffset = true;
+
+        return changed;
+    }
+
+    // Server time minus local time, in whole seconds.
+    long getOffset() const
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        return _round(_offset);
+    }
+
+    // The number of requests the server refused for their timestamp.
+    unsigned long long getRejectionCount() const
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        return _rejectionCount;
+    }
+
+    // The current time on the server's clock.
+    time_t now() const
+    {
+        return time(0) + getOffset();
+    }
+
+    // Recognizes the OAuth problem reporting extension's timestamp_refused,
+    // and Twitter's "Timestamp out of bounds" (error 135).
+    static bool isSkewRejection(const ofxOAuthResponse& response)
+    {
+        if(!response.isComplete() || response.status < 400) return false;
+
+        const std::string& body = response.body;
+        std::string authenticate = response.headers.get("WWW-Authenticate", "");
+
+        return body.find("timestamp_refused") != std::string::npos ||
+               authenticate.find("timestamp_refused") != std::string::npos ||
+               body.find("Timestamp out of bounds") != std::string::npos ||
+               body.find("\"code\":135") != std::string::npos;
+    }
+
+    // Parses an RFC 1123 date, e.g. "Sun, 06 Nov 1994 08:49:37 GMT".
+    static bool parseDate(const std::string& date, time_t& result)
+    {
+        char month[4] = { 0 };
+        int day = 0;
+        int year = 0;
+        int hour = 0;
+        int minute = 0;
+        int second = 0;
+
+        if(6 != sscanf(date.c_str(), "%*[^,], %d %3s %d %d:%d:%d", &day, month, &year, &hour, &minute, &second))
+        {
+            return false;
+        }
+
+        static const char* months = "JanFebMarAprMayJunJulAugSepOctNovDec";
+
+        const char* found = strstr(months, month);
+
+        if(0 == found || strlen(month) != 3 || (found - months) % 3 != 0) return false;
+
+        int m = static_cast<int>(found - months) / 3 + 1;
+
+        // days since the epoch, for the proleptic Gregorian calendar.
+        int y = year - (m <= 2 ? 1 : 0);
+        long era = (y >= 0 ? y : y - 399) / 400;
+        long yearOfEra = y - era * 400;
+        long dayOfYear = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+        long dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+        long days = era * 146097 + dayOfEra - 719468;
+
+        result = static_cast<time_t>(days * 86400L + hour * 3600L + minute * 60L + second);
+
+        return true;
+    }
+
+private:
+    static long _round(double value)
+    {
+        return static_cast<long>(value < 0 ? value - 0.5 : value + 0.5);
+    }
+
+    double _offset;
+    bool _hasOffset;
+    unsigned long long _rejectionCount;
+    double _smoothing;
+
+    mutable Poco::Mutex _mutex;
+
+};
@@ -0,0 +1,707 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+#pragma once
+
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <string>
+#if !defined(_WIN32)
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "Poco/Mutex.h"
+#include "ofxOAuthCredentials.h"
+
+
+// A compact, memory-mapped credential store keyed by user id, for apps that
+// keep many token pairs.  The file is an open-addressing hash table of fixed
+// size records, so opening it is a single mmap() (no parsing) and lookups and
+// updates touch one or two records.
+//
+//      ofxOAuthCredentialStore store;
+//      store.open(ofToDataPath("credentials.db", true));
+//      store.put(credentials);               // keyed by credentials.userId
+//      store.get("12345", credentials);
+//
+// Several processes can share the file: every call holds flock() on it, and
+// a process that finds the store was grown into a new file by another one
+// maps the new file.  An update is written to a free record and switched in
+// by its state word, so a crash leaves the old token pair or the new one,
+// never half of each.
+//
+// Consumer key / secret are per application and are not stored per record.
+class ofxOAuthCredentialStore
+{
+public:
+    enum
+    {
+        MAX_USER_ID_LENGTH      = 63,
+        MAX_SCREEN_NAME_LENGTH  = 63,
+        MAX_API_NAME_LENGTH     = 47,
+        MAX_TOKEN_LENGTH        = 159,
+        MAX_SECRET_LENGTH       = 159,
+        DEFAULT_CAPACITY        = 1024,
+        MAX_CAPACITY            = 1 << 24
+    };
+
+    ofxOAuthCredentialStore():
+        _fd(-1),
+        _header(0),
+        _records(0),
+        _mappedSize(0),
+        _device(0),
+        _inode(0),
+        _initialCapacity(DEFAULT_CAPACITY)
+    {
+    }
+
+    virtual ~ofxOAuthCredentialStore()
+    {
+        close();
+    }
+
+    // Opens (or creates) the store at the absolute path.  Fails if the file
+    // is not a valid store or initialCapacity is above MAX_CAPACITY.
+    bool open(const std::string& path, uint32_t initialCapacity = DEFAULT_CAPACITY)
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+
+        _close();
+
+        _path = path;
+        _initialCapacity = initialCapacity;
+
+        return _openFile();
+    }
+
+    void close()
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        _close();
+    }
+
+    bool isOpen() const
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        return 0 != _header;
+    }
+
+    std::size_t size() const
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        _FileLock fileLock(*this, FILE_SHARED);
+        return fileLock.isLocked() ? _header->count : 0;
+    }
+
+    std::size_t capacity() const
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        _FileLock fileLock(*this, FILE_SHARED);
+        return fileLock.isLocked() ? _header->capacity : 0;
+    }
+
+    bool get(const std::string& userId, ofxOAuthCredentials& credentials) const
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        _FileLock fileLock(*this, FILE_SHARED);
+
+        const Record* record = fileLock.isLocked() ? _find(userId) : 0;
+
+        if(0 == record) return false;
+
+        credentials.userId = record->userId;
+        credentials.screenName = record->screenName;
+        credentials.apiName = record->apiName;
+        credentials.accessToken = record->accessToken;
+        credentials.accessTokenSecret = record->accessTokenSecret;
+
+        return true;
+    }
+
+    bool has(const std::string& userId) const
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        _FileLock fileLock(*this, FILE_SHARED);
+        return fileLock.isLocked() && 0 != _find(userId);
+    }
+
+    // Inserts or updates the record for credentials.userId.  Returns false
+    // if the store is closed, full or a field is too long.
+    bool put(const ofxOAuthCredentials& credentials)
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+
+        if(credentials.userId.empty() ||
+           credentials.userId.size() > MAX_USER_ID_LENGTH ||
+           credentials.screenName.size() > MAX_SCREEN_NAME_LENGTH ||
+           credentials.apiName.size() > MAX_API_NAME_LENGTH ||
+           credentials.accessToken.size() > MAX_TOKEN_LENGTH ||
+           credentials.accessTokenSecret.size() > MAX_SECRET_LENGTH)
+        {
+            return false;
+        }
+
+        _FileLock fileLock(*this, FILE_EXCLUSIVE);
+
+        if(!fileLock.isLocked()) return false;
+
+        // keep the load factor under 3/4 so probe sequences stay short.
+        if((uint64_t(_header->count) + _header->deleted + 1) * 4 > uint64_t(_header->capacity) * 3)
+        {
+            if(!_grow()) return false;
+        }
+
+        uint32_t hash = _hash(credentials.userId);
+        Record* slot = _freeSlot(hash);
+
+        // the counts in the header can be wrong after a crash; growing
+        // recounts them.
+        if(0 == slot && (!_grow() || 0 == (slot = _freeSlot(hash)))) return false;
+
+        Record* existing = const_cast<Record*>(_find(credentials.userId));
+
+        if(slot->state == RECORD_DELETED) --_header->deleted;
+
+        _fill(*slot, hash, credentials);
+
+        if(0 == existing)
+        {
+            std::atomic_thread_fence(std::memory_order_release);
+            slot->state = RECORD_USED;
+            ++_header->count;
+            return true;
+        }
+
+        // switch from the old record to the new one.  Until pendingSlot is
+        // cleared, a crash is finished by _recover().
+        _header->pendingSlot = static_cast<uint32_t>(existing - _records) + 1;
+        std::atomic_thread_fence(std::memory_order_release);
+        slot->state = RECORD_USED;
+        std::atomic_thread_fence(std::memory_order_release);
+        _erase(*existing);
+        std::atomic_thread_fence(std::memory_order_release);
+        _header->pendingSlot = 0;
+
+        return true;
+    }
+
+    bool remove(const std::string& userId)
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        _FileLock fileLock(*this, FILE_EXCLUSIVE);
+
+        Record* record = fileLock.isLocked() ? const_cast<Record*>(_find(userId)) : 0;
+
+        if(0 == record) return false;
+
+        _erase(*record);
+        --_header->count;
+
+        return true;
+    }
+
+    // Flush modified pages to disk.  The kernel will do this eventually
+    // anyway; call this when durability matters.
+    bool sync()
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+#if defined(_WIN32)
+        return false;
+#else
+        return 0 != _header && 0 == msync(_header, _mappedSize, MS_SYNC);
+#endif
+    }
+
+    const std::string& getPath() const
+    {
+        return _path;
+    }
+
+protected:
+    enum
+    {
+        MAGIC           = 0x414f4678, // "xFOA"
+        VERSION         = 1,
+        RECORD_EMPTY    = 0,
+        RECORD_USED     = 1,
+        RECORD_DELETED  = 2,
+        FILE_SHARED     = 0,
+        FILE_EXCLUSIVE  = 1
+    };
+
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t recordSize;
+        uint32_t capacity; //< always a power of two
+        uint32_t count;
+        uint32_t deleted;
+        uint32_t pendingSlot; //< 1 + the record an update is replacing, or 0
+        uint32_t reserved[9];
+    };
+
+    struct Record
+    {
+        uint32_t state;
+        uint32_t hash;
+        char userId[MAX_USER_ID_LENGTH + 1];
+        char screenName[MAX_SCREEN_NAME_LENGTH + 1];
+        char apiName[MAX_API_NAME_LENGTH + 1];
+        char accessToken[MAX_TOKEN_LENGTH + 1];
+        char accessTokenSecret[MAX_SECRET_LENGTH + 1];
+    };
+
+    // Holds the file lock for the length of a call.
+    class _FileLock
+    {
+    public:
+        _FileLock(const ofxOAuthCredentialStore& store, int mode):
+            _store(const_cast<ofxOAuthCredentialStore&>(store)),
+            _isLocked(_store._lockFile(mode))
+        {
+        }
+
+        ~_FileLock()
+        {
+            if(_isLocked) _store._unlockFile();
+        }
+
+        bool isLocked() const
+        {
+            return _isLocked;
+        }
+
+    private:
+        ofxOAuthCredentialStore& _store;
+        bool _isLocked;
+
+    };
+
+    static uint32_t _hash(const std::string& key)
+    {
+        // FNV-1a
+        uint32_t hash = 2166136261u;
+
+        for(std::size_t i = 0; i < key.size(); ++i)
+        {
+            hash ^= static_cast<unsigned char>(key[i]);
+            hash *= 16777619u;
+        }
+
+        return hash;
+    }
+
+    // The power of two capacity for v records, or 0 if that is above
+    // MAX_CAPACITY.
+    static uint32_t _roundUp(uint32_t v)
+    {
+        if(v > MAX_CAPACITY) return 0;
+
+        uint32_t capacity = 16;
+        while(capacity < v) capacity <<= 1;
+        return capacity;
+    }
+
+    static void _copy(char* dst, std::size_t dstSize, const std::string& src)
+    {
+        memset(dst, 0, dstSize);
+        memcpy(dst, src.data(), src.size());
+    }
+
+    // Fills a free record; it is not found until its state says so.
+    static void _fill(Record& record, uint32_t hash, const ofxOAuthCredentials& credentials)
+    {
+        record.hash = hash;
+        _copy(record.userId, sizeof(record.userId), credentials.userId);
+        _copy(record.screenName, sizeof(record.screenName), credentials.screenName);
+        _copy(record.apiName, sizeof(record.apiName), credentials.apiName);
+        _copy(record.accessToken, sizeof(record.accessToken), credentials.accessToken);
+        _copy(record.accessTokenSecret, sizeof(record.accessTokenSecret), credentials.accessTokenSecret);
+    }
+
+    // Marks the record deleted, then wipes it.
+    void _erase(Record& record)
+    {
+        record.state = RECORD_DELETED;
+        std::atomic_thread_fence(std::memory_order_release);
+        memset(reinterpret_cast<char*>(&record) + sizeof(record.state), 0, sizeof(Record) - sizeof(record.state));
+        ++_header->deleted;
+    }
+
+    bool _isValid() const
+    {
+        if(_mappedSize < sizeof(Header)) return false;
+
+        return _header->magic == MAGIC &&
+               _header->version == VERSION &&
+               _header->recordSize == sizeof(Record) &&
+               _header->capacity > 0 &&
+               _header->capacity <= MAX_CAPACITY &&
+               (_header->capacity & (_header->capacity - 1)) == 0 &&
+               uint64_t(_header->count) + _header->deleted <= _header->capacity &&
+               _header->pendingSlot <= _header->capacity &&
+               _mappedSize >= sizeof(Header) + std::size_t(_header->capacity) * sizeof(Record);
+    }
+
+    // The used record for userId other than except, if there is one.
+    const Record* _find(const std::string& userId, const Record* except = 0) const
+    {
+        if(0 == _header || userId.empty()) return 0;
+
+        uint32_t hash = _hash(userId);
+        uint32_t mask = _header->capacity - 1;
+
+        for(uint32_t i = 0; i < _header->capacity; ++i)
+        {
+            const Record& record = _records[(hash + i) & mask];
+
+            if(record.state == RECORD_EMPTY) return 0;
+
+            if(record.state == RECORD_USED &&
+               &record != except &&
+               record.hash == hash &&
+               userId == record.userId)
+            {
+                return &record;
+            }
+        }
+
+        return 0;
+    }
+
+    // The first record on the probe sequence that is not in use, or 0 if
+    // there is none.
+    Record* _freeSlot(uint32_t hash)
+    {
+        uint32_t mask = _header->capacity - 1;
+
+        for(uint32_t i = 0; i < _header->capacity; ++i)
+        {
+            Record& record = _records[(hash + i) & mask];
+            if(record.state != RECORD_USED) return &record;
+        }
+
+        return 0;
+    }
+
+    // Finishes an update that was cut short: if its new record made it in,
+    // the old one goes.
+    void _recover()
+    {
+        if(0 == _header->pendingSlot) return;
+
+        Record& old = _records[_header->pendingSlot - 1];
+
+        if(old.state == RECORD_USED && 0 != _find(old.userId, &old))
+        {
+            _erase(old);
+        }
+
+        _header->pendingSlot = 0;
+    }
+
+#if !defined(_WIN32)
+    // True if the path still names the file that is mapped.  Another
+    // process that grows the store renames a new file over it.
+    bool _isCurrent() const
+    {
+        struct stat statbuf;
+
+        return 0 == stat(_path.c_str(), &statbuf) &&
+               uint64_t(statbuf.st_dev) == _device &&
+               uint64_t(statbuf.st_ino) == _inode;
+    }
+
+    static bool _flock(int fd, int operation)
+    {
+        int result;
+
+        do
+        {
+            result = flock(fd, operation);
+        }
+        while(result != 0 && errno == EINTR);
+
+        return 0 == result;
+    }
+
+    bool _lockFile(int mode)
+    {
+        while(_fd >= 0)
+        {
+            if(!_flock(_fd, mode == FILE_EXCLUSIVE ? LOCK_EX : LOCK_SH)) return false;
+
+            if(_isCurrent())
+            {
+                if(mode == FILE_EXCLUSIVE) _recover();
+                return true;
+            }
+
+            // replaced by another process; closing drops the lock.
+            _close();
+
+            if(!_openFile()) return false;
+        }
+
+        return false;
+    }
+
+    void _unlockFile()
+    {
+        if(_fd >= 0) _flock(_fd, LOCK_UN);
+    }
+
+    bool _openFile()
+    {
+        for(;;)
+        {
+            _fd = ::open(_path.c_str(), O_RDWR | O_CREAT, 0600);
+
+            if(_fd < 0) return false;
+
+            struct stat statbuf;
+
+            if(!_flock(_fd, LOCK_EX) || fstat(_fd, &statbuf) != 0)
+            {
+                _close();
+                return false;
+            }
+
+            _device = uint64_t(statbuf.st_dev);
+            _inode = uint64_t(statbuf.st_ino);
+
+            // grown by another process between open() and flock().
+            if(!_isCurrent())
+            {
+                _close();
+                continue;
+            }
+
+            bool success = false;
+
+            if(statbuf.st_size == 0)
+            {
+                uint32_t capacity = _roundUp(_initialCapacity);
+                success = 0 != capacity && _initialize(_fd, capacity);
+            }
+            else
+            {
+                success = _map(_fd, static_cast<std::size_t>(statbuf.st_size)) && _isValid();
+            }
+
+            if(!success)
+            {
+                _close();
+                return false;
+            }
+
+            _recover();
+            _flock(_fd, LOCK_UN);
+
+            return true;
+        }
+    }
+
+    bool _map(int fd, std::size_t size)
+    {
+        void* p = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+        if(p == MAP_FAILED) return false;
+
+        _header = static_cast<Header*>(p);
+        _records = reinterpret_cast<Record*>(static_cast<char*>(p) + sizeof(Header));
+        _mappedSize = size;
+
+        return true;
+    }
+
+    bool _initialize(int fd, uint32_t capacity)
+    {
+        std::size_t size = sizeof(Header) + std::size_t(capacity) * sizeof(Record);
+
+        // ftruncate zero fills, so every record starts out RECORD_EMPTY.
+        if(ftruncate(fd, size) != 0 || !_map(fd, size)) return false;
+
+        _header->magic = MAGIC;
+        _header->version = VERSION;
+        _header->recordSize = sizeof(Record);
+        _header->capacity = capacity;
+        _header->count = 0;
+        _header->deleted = 0;
+        _header->pendingSlot = 0;
+
+        return true;
+    }
+
+    // Rehash into a new file, twice the size if the live records need it,
+    // then atomically swap it in.  Called with the file locked; the new
+    // file is locked before it is visible, and other processes notice the
+    // swap once they get the lock on the old one.
+    bool _grow()
+    {
+        Header* oldHeader = _header;
+        Record* oldRecords = _records;
+        std::size_t oldMappedSize = _mappedSize;
+        uint32_t oldCapacity = oldHeader->capacity;
+
+        // count what is really there; the header may be off after a crash.
+        uint32_t count = 0;
+
+        for(uint32_t i = 0; i < oldCapacity; ++i)
+        {
+            if(oldRecords[i].state == RECORD_USED) ++count;
+        }
+
+        uint32_t capacity = oldCapacity;
+
+        // only grow if live records need it; tombstones alone just get dropped.
+        if((uint64_t(count) + 1) * 2 > oldCapacity) capacity <<= 1;
+
+        if(capacity > MAX_CAPACITY) return false;
+
+        std::string tmpPath = _path + ".tmp";
+
+        int fd = ::open(tmpPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+
+        if(fd < 0) return false;
+
+        if(!_flock(fd, LOCK_EX) || !_initialize(fd, capacity))
+        {
+            if(_header != oldHeader) munmap(_header, _mappedSize);
+            ::close(fd);
+            unlink(tmpPath.c_str());
+            _header = oldHeader;
+            _records = oldRecords;
+            _mappedSize = oldMappedSize;
+            return false;
+        }
+
+        uint32_t mask = capacity - 1;
+
+        for(uint32_t i = 0; i < oldCapacity; ++i)
+        {
+            const Record& record = oldRecords[i];
+
+            if(record.state == RECORD_USED)
+            {
+                for(uint32_t j = 0; ; ++j)
+                {
+                    Record& slot = _records[(record.hash + j) & mask];
+
+                    if(slot.state == RECORD_EMPTY)
+                    {
+                        slot = record;
+                        break;
+                    }
+                }
+
+                ++_header->count;
+            }
+        }
+
+        msync(_header, _mappedSize, MS_SYNC);
+
+        struct stat statbuf;
+
+        if(fstat(fd, &statbuf) != 0 || rename(tmpPath.c_str(), _path.c_str()) != 0)
+        {
+            munmap(_header, _mappedSize);
+            ::close(fd);
+            unlink(tmpPath.c_str());
+            _header = oldHeader;
+            _records = oldRecords;
+            _mappedSize = oldMappedSize;
+            return false;
+        }
+
+        munmap(oldHeader, oldMappedSize);
+        ::close(_fd); // releases the lock on the old file
+        _fd = fd;
+        _device = uint64_t(statbuf.st_dev);
+        _inode = uint64_t(statbuf.st_ino);
+
+        return true;
+    }
+#else
+    bool _lockFile(int)
+    {
+        return false;
+    }
+
+    void _unlockFile()
+    {
+    }
+
+    bool _openFile()
+    {
+        return false;
+    }
+
+    bool _grow()
+    {
+        return false;
+    }
+#endif
+
+    void _close()
+    {
+#if !defined(_WIN32)
+        if(_header)
+        {
+            msync(_header, _mappedSize, MS_SYNC);
+            munmap(_header, _mappedSize);
+        }
+
+        if(_fd >= 0)
+        {
+            ::close(_fd);
+        }
+#endif
+        _fd = -1;
+        _header = 0;
+        _records = 0;
+        _mappedSize = 0;
+    }
+
+    std::string _path;
+
+    int _fd;
+    Header* _header;
+    Record* _records;
+    std::size_t _mappedSize;
+    uint64_t _device;
+    uint64_t _inode;
+    uint32_t _initialCapacity;
+
+    mutable Poco::Mutex _mutex;
+
+};
@@ -0,0 +1,533 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include "Poco/Mutex.h"
+#include "ofxOAuthCredentials.h"
+#include "ofxOAuthSecureBuffer.h"
+
+
+// An encrypted credential file with a decrypted working set held in locked
+// memory.  The file is read and decrypted once in open(); after that get()
+// and put() only touch memory.  seal() produces the encrypted file contents
+// and is meant to be handed to ofxOAuthCredentialWriter, which batches
+// writes.
+//
+// File layout: magic (8) | salt (16) | iv (12) | tag (16) | ciphertext.
+// Files written before the record held every ofxOAuthCredentials field
+// (magic OFXOAV01) are still read.
+// The key is derived from a passphrase with PBKDF2-HMAC-SHA256 and the
+// contents are sealed with AES-256-GCM.
+//
+// Accounts are keyed by user id, or by an account name given to put().  The
+// empty name is the default account, which is what ofxOAuth uses unless
+// setUserId() is called.
+class ofxOAuthCredentialVault
+{
+public:
+    enum
+    {
+        MAX_USER_ID_LENGTH      = 63,
+        MAX_API_NAME_LENGTH     = 47,
+        MAX_KEY_LENGTH          = 127,
+        MAX_TOKEN_LENGTH        = 159,
+        MAX_SCREEN_NAME_LENGTH  = 63,
+        MAX_API_URL_LENGTH      = 255,
+        MAX_PASSWORD_LENGTH     = 127,
+        MAX_ENCODED_LENGTH      = 255,
+        KDF_ITERATIONS          = 100000
+    };
+
+    ofxOAuthCredentialVault():
+        _count(0),
+        _capacity(0),
+        _isOpen(false),
+        _isDirty(false)
+    {
+        memset(_salt, 0, sizeof(_salt));
+    }
+
+    virtual ~ofxOAuthCredentialVault()
+    {
+        close();
+    }
+
+    // Reads and decrypts the vault at the absolute path.  A missing file is
+    // an empty vault.  Returns false if the file is corrupt or the
+    // passphrase is wrong.
+    bool open(const std::string& path, const std::string& passphrase)
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+
+        _close();
+
+        std::string sealed;
+
+        std::ifstream file(path.c_str(), std::ios::binary);
+
+        if(file)
+        {
+            sealed.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+
+        if(sealed.empty() ? !_create(passphrase) : !_unseal(sealed, passphrase))
+        {
+            _close();
+            return false;
+        }
+
+        _path = path;
+        _isOpen = true;
+        return true;
+    }
+
+    // Starts an empty vault for the absolute path without reading it, e.g.
+    // to replace a plaintext credentials.xml.  The file is only written
+    // when seal()'s result is.
+    bool create(const std::string& path, const std::string& passphrase)
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+
+        _close();
+
+        if(!_create(passphrase))
+        {
+            _close();
+            return false;
+        }
+
+        _path = path;
+        _isOpen = true;
+        return true;
+    }
+
+    // True if the file at the absolute path starts like a vault.  A missing
+    // or empty file is not one.
+    static bool isVault(const std::string& path)
+    {
+        std::ifstream file(path.c_str(), std::ios::binary);
+
+        char magic[MAGIC_SIZE];
+
+        return file.read(magic, MAGIC_SIZE) &&
+               (0 == memcmp(magic, _magic(), MAGIC_SIZE) || 0 == memcmp(magic, _magicV1(), MAGIC_SIZE));
+    }
+
+    void close()
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        _close();
+    }
+
+    bool isOpen() const
+    {
+        return _isOpen;
+    }
+
+    bool isDirty() const
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        return _isDirty;
+    }
+
+    // True if the working set could be locked into memory.
+    bool isLocked() const
+    {
+        return _records.isLocked() && _key.isLocked();
+    }
+
+    const std::string& getPath() const
+    {
+        return _path;
+    }
+
+    bool get(const std::string& account, ofxOAuthCredentials& credentials) const
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+
+        const Record* record = _find(account);
+
+        if(0 == record) return false;
+
+        credentials.userId = record->userId;
+        credentials.apiName = record->apiName;
+        credentials.consumerKey = record->consumerKey;
+        credentials.consumerSecret = record->consumerSecret;
+        credentials.accessToken = record->accessToken;
+        credentials.accessTokenSecret = record->accessTokenSecret;
+        credentials.screenName = record->screenName;
+        credentials.apiURL = record->apiURL;
+        credentials.encodedUserId = record->encodedUserId;
+        credentials.userPassword = record->userPassword;
+        credentials.encodedUserPassword = record->encodedUserPassword;
+
+        return true;
+    }
+
+    // Stores the credentials under their user id.
+    bool put(const ofxOAuthCredentials& credentials)
+    {
+        return put(credentials.userId, credentials);
+    }
+
+    // Stores the credentials under an account name of their own, e.g. the
+    // default account for credentials that carry a user id.
+    bool put(const std::string& account, const ofxOAuthCredentials& credentials)
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+
+        if(!_isOpen ||
+           account.size() > MAX_USER_ID_LENGTH ||
+           credentials.userId.size() > MAX_USER_ID_LENGTH ||
+           credentials.apiName.size() > MAX_API_NAME_LENGTH ||
+           credentials.consumerKey.size() > MAX_KEY_LENGTH ||
+           credentials.consumerSecret.size() > MAX_KEY_LENGTH ||
+           credentials.accessToken.size() > MAX_TOKEN_LENGTH ||
+           credentials.accessTokenSecret.size() > MAX_TOKEN_LENGTH ||
+           credentials.screenName.size() > MAX_SCREEN_NAME_LENGTH ||
+           credentials.apiURL.size() > MAX_API_URL_LENGTH ||
+           credentials.encodedUserId.size() > MAX_ENCODED_LENGTH ||
+           credentials.userPassword.size() > MAX_PASSWORD_LENGTH ||
+           credentials.encodedUserPassword.size() > MAX_ENCODED_LENGTH)
+        {
+            return false;
+        }
+
+        Record* record = const_cast<Record*>(_find(account));
+
+        if(0 == record)
+        {
+            if(_count == _capacity && !_reserve(_capacity * 2)) return false;
+            record = _recordAt(_count++);
+        }
+
+        _copy(record->account, sizeof(record->account), account);
+        _copy(record->userId, sizeof(record->userId), credentials.userId);
+        _copy(record->apiName, sizeof(record->apiName), credentials.apiName);
+        _copy(record->consumerKey, sizeof(record->consumerKey), credentials.consumerKey);
+        _copy(record->consumerSecret, sizeof(record->consumerSecret), credentials.consumerSecret);
+        _copy(record->accessToken, sizeof(record->accessToken), credentials.accessToken);
+        _copy(record->accessTokenSecret, sizeof(record->accessTokenSecret), credentials.accessTokenSecret);
+        _copy(record->screenName, sizeof(record->screenName), credentials.screenName);
+        _copy(record->apiURL, sizeof(record->apiURL), credentials.apiURL);
+        _copy(record->encodedUserId, sizeof(record->encodedUserId), credentials.encodedUserId);
+        _copy(record->userPassword, sizeof(record->userPassword), credentials.userPassword);
+        _copy(record->encodedUserPassword, sizeof(record->encodedUserPassword), credentials.encodedUserPassword);
+
+        _isDirty = true;
+
+        return true;
+    }
+
+    bool remove(const std::string& account)
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+
+        Record* record = const_cast<Record*>(_find(account));
+
+        if(0 == record) return false;
+
+        Record* last = _recordAt(_count - 1);
+
+        if(record != last) memcpy(record, last, sizeof(Record));
+
+        ofxOAuthSecureBuffer::wipe(last, sizeof(Record));
+        --_count;
+        _isDirty = true;
+
+        return true;
+    }
+
+    // Encrypts the working set with a fresh iv.  Returns the complete file
+    // contents, or an empty string on failure.
+    std::string seal()
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+
+        if(!_isOpen) return "";
+
+        unsigned char iv[IV_SIZE];
+        unsigned char tag[TAG_SIZE];
+
+        if(1 != RAND_bytes(iv, sizeof(iv))) return "";
+
+        // the plaintext is the record count followed by the records.
+        uint32_t count = _count;
+        std::size_t plainSize = sizeof(count) + _count * sizeof(Record);
+
+        std::string sealed;
+        sealed.reserve(HEADER_SIZE + plainSize);
+        sealed.append(_magic(), MAGIC_SIZE);
+        sealed.append(reinterpret_cast<const char*>(_salt), SALT_SIZE);
+        sealed.append(reinterpret_cast<const char*>(iv), IV_SIZE);
+        sealed.append(TAG_SIZE, '\0'); // filled in below
+        sealed.resize(HEADER_SIZE + plainSize);
+
+        unsigned char* out = reinterpret_cast<unsigned char*>(&sealed[HEADER_SIZE]);
+
+        EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+
+        int length = 0;
+        int total = 0;
+
+        bool success = 0 != ctx &&
+            1 == EVP_EncryptInit_ex(ctx, EVP_aes_256_gcm(), 0, 0, 0) &&
+            1 == EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_IVLEN, IV_SIZE, 0) &&
+            1 == EVP_EncryptInit_ex(ctx, 0, 0, _key.data(), iv) &&
+            1 == EVP_EncryptUpdate(ctx, out, &length, reinterpret_cast<const unsigned char*>(&count), sizeof(count));
+
+        total += length;
+
+        success = success &&
+            (0 == _count || 1 == EVP_EncryptUpdate(ctx, out + total, &length, _records.data(), _count * sizeof(Record)));
+
+        if(_count > 0) total += length;
+
+        success = success &&
+            1 == EVP_EncryptFinal_ex(ctx, out + total, &length) &&
+            1 == EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, TAG_SIZE, tag);
+
+        if(ctx) EVP_CIPHER_CTX_free(ctx);
+
+        if(!success) return "";
+
+        memcpy(&sealed[MAGIC_SIZE + SALT_SIZE + IV_SIZE], tag, TAG_SIZE);
+
+        _isDirty = false;
+
+        return sealed;
+    }
+
+protected:
+    enum
+    {
+        MAGIC_SIZE  = 8,
+        SALT_SIZE   = 16,
+        IV_SIZE     = 12,
+        TAG_SIZE    = 16,
+        KEY_SIZE    = 32,
+        HEADER_SIZE = MAGIC_SIZE + SALT_SIZE + IV_SIZE + TAG_SIZE
+    };
+
+    static const char* _magic()
+    {
+        return "OFXOAV02";
+    }
+
+    // records end after screenName, and are keyed by userId.
+    static const char* _magicV1()
+    {
+        return "OFXOAV01";
+    }
+
+    struct Record
+    {
+        char userId[MAX_USER_ID_LENGTH + 1];
+        char apiName[MAX_API_NAME_LENGTH + 1];
+        char consumerKey[MAX_KEY_LENGTH + 1];
+        char consumerSecret[MAX_KEY_LENGTH + 1];
+        char accessToken[MAX_TOKEN_LENGTH + 1];
+        char accessTokenSecret[MAX_TOKEN_LENGTH + 1];
+        char screenName[MAX_SCREEN_NAME_LENGTH + 1];
+        char apiURL[MAX_API_URL_LENGTH + 1];
+        char encodedUserId[MAX_ENCODED_LENGTH + 1];
+        char userPassword[MAX_PASSWORD_LENGTH + 1];
+        char encodedUserPassword[MAX_ENCODED_LENGTH + 1];
+        char account[MAX_USER_ID_LENGTH + 1];
+    };
+
+    static void _copy(char* dst, std::size_t dstSize, const std::string& src)
+    {
+        memset(dst, 0, dstSize);
+        memcpy(dst, src.data(), src.size());
+    }
+
+    Record* _recordAt(std::size_t i)
+    {
+        return reinterpret_cast<Record*>(_records.data()) + i;
+    }
+
+    const Record* _find(const std::string& account) const
+    {
+        const Record* records = reinterpret_cast<const Record*>(_records.data());
+
+        for(std::size_t i = 0; i < _count; ++i)
+        {
+            if(account == records[i].account) return &records[i];
+        }
+
+        return 0;
+    }
+
+    // Grow the locked working set, copying the live records across.
+    bool _reserve(std::size_t capacity)
+    {
+        if(capacity <= _capacity) return true;
+
+        ofxOAuthSecureBuffer records;
+
+        if(!records.allocate(capacity * sizeof(Record))) return false;
+
+        if(_count > 0) memcpy(records.data(), _records.data(), _count * sizeof(Record));
+
+        _records.swap(records);
+        _capacity = _records.size() / sizeof(Record);
+
+        return true; // the old buffer is wiped as it goes out of scope
+    }
+
+    bool _create(const std::string& passphrase)
+    {
+        return 1 == RAND_bytes(_salt, sizeof(_salt)) &&
+               _deriveKey(passphrase) &&
+               _reserve(4);
+    }
+
+    bool _deriveKey(const std::string& passphrase)
+    {
+        if(!_key.allocate(KEY_SIZE)) return false;
+
+        return 1 == PKCS5_PBKDF2_HMAC(passphrase.data(),
+                                      static_cast<int>(passphrase.size()),
+                                      _salt,
+                                      SALT_SIZE,
+                                      KDF_ITERATIONS,
+                                      EVP_sha256(),
+                                      KEY_SIZE,
+                                      _key.data());
+    }
+
+    bool _unseal(const std::string& sealed, const std::string& passphrase)
+    {
+        if(sealed.size() < HEADER_SIZE + sizeof(uint32_t)) return false;
+
+        std::size_t recordSize = sizeof(Record);
+
+        if(0 == memcmp(sealed.data(), _magicV1(), MAGIC_SIZE))
+        {
+            recordSize = offsetof(Record, apiURL);
+        }
+        else if(0 != memcmp(sealed.data(), _magic(), MAGIC_SIZE))
+        {
+            return false;
+        }
+
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(sealed.data());
+
+        memcpy(_salt, p + MAGIC_SIZE, SALT_SIZE);
+
+        const unsigned char* iv = p + MAGIC_SIZE + SALT_SIZE;
+        unsigned char tag[TAG_SIZE];
+        memcpy(tag, iv + IV_SIZE, TAG_SIZE);
+
+        const unsigned char* in = p + HEADER_SIZE;
+        std::size_t inSize = sealed.size() - HEADER_SIZE;
+
+        if((inSize - sizeof(uint32_t)) % recordSize != 0) return false;
+
+        std::size_t count = (inSize - sizeof(uint32_t)) / recordSize;
+
+        if(!_deriveKey(passphrase)) return false;
+
+        // decrypt straight into locked memory; the plaintext never touches
+        // the regular heap.
+        ofxOAuthSecureBuffer plain;
+
+        if(!plain.allocate(inSize)) return false;
+
+        EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+
+        int length = 0;
+
+        bool success = 0 != ctx &&
+            1 == EVP_DecryptInit_ex(ctx, EVP_aes_256_gcm(), 0, 0, 0) &&
+            1 == EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_IVLEN, IV_SIZE, 0) &&
+            1 == EVP_DecryptInit_ex(ctx, 0, 0, _key.data(), iv) &&
+            1 == EVP_DecryptUpdate(ctx, plain.data(), &length, in, static_cast<int>(inSize)) &&
+            1 == EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, TAG_SIZE, tag) &&
+            1 == EVP_DecryptFinal_ex(ctx, plain.data() + length, &length); // verifies the tag
+
+        if(ctx) EVP_CIPHER_CTX_free(ctx);
+
+        uint32_t storedCount = 0;
+
+        if(success) memcpy(&storedCount, plain.data(), sizeof(storedCount));
+
+        if(!success || storedCount != count || !_reserve(count > 4 ? count : 4))
+        {
+            return false;
+        }
+
+        // older, shorter records leave the newer fields zeroed.
+        for(std::size_t i = 0; i < count; ++i)
+        {
+            Record* record = _recordAt(i);
+            memcpy(record, plain.data() + sizeof(uint32_t) + i * recordSize, recordSize);
+            if(recordSize < sizeof(Record)) memcpy(record->account, record->userId, sizeof(record->account));
+        }
+
+        _count = count;
+
+        return true;
+    }
+
+    void _close()
+    {
+        _records.release();
+        _key.release();
+        ofxOAuthSecureBuffer::wipe(_salt, sizeof(_salt));
+        _count = 0;
+        _capacity = 0;
+        _isOpen = false;
+        _isDirty = false;
+        _path.clear();
+    }
+
+    std::string _path;
+
+    ofxOAuthSecureBuffer _key;
+    ofxOAuthSecureBuffer _records;
+    unsigned char _salt[SALT_SIZE];
+
+    std::size_t _count;
+    std::size_t _capacity;
+
+    bool _isOpen;
+    bool _isDirty;
+
+    mutable Poco::Mutex _mutex;
+
+};
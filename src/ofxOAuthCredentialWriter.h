@@ -0,0 +1,190 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include <functional>
+#include <string>
+#include "Poco/Condition.h"
+#include "Poco/Mutex.h"
+#include "Poco/Runnable.h"
+#include "Poco/ScopedUnlock.h"
+#include "Poco/Thread.h"
+#include "ofxOAuthAtomicFile.h"
+#include "ofxOAuthCredentials.h"
+#include "ofxOAuthCredentialsXML.h"
+#include "ofxOAuthLog.h"
+
+
+// Persists credentials on a background thread.  save() only copies the
+// snapshot (or serializer) and returns; if several saves arrive before the
+// writer gets to them, only the most recent one is written.  Files are
+// written with ofxOAuthAtomicFile, so a crash mid-write leaves the previous
+// file intact.
+class ofxOAuthCredentialWriter: public Poco::Runnable
+{
+public:
+    ofxOAuthCredentialWriter():
+        _hasPending(false),
+        _isWriting(false),
+        _isStopping(false)
+    {
+    }
+
+    virtual ~ofxOAuthCredentialWriter()
+    {
+        stop();
+    }
+
+    typedef std::function<std::string()> Serializer;
+
+    // Queue a snapshot to be written to the absolute path.  Never blocks
+    // on disk I/O, unless the writer has been stopped.
+    void save(const std::string& path, const ofxOAuthCredentials& credentials)
+    {
+        save(path, [credentials]()
+        {
+            return ofxOAuthCredentialsXML::toString(credentials);
+        });
+    }
+
+    // Queue arbitrary file contents.  The serializer is called on the
+    // writer thread, so it must be safe to call from there.
+    void save(const std::string& path, Serializer serializer)
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+
+        if(_isStopping)
+        {
+            // the writer thread is gone, or finishing what it has; write
+            // on the calling thread, after it, rather than drop the save.
+            while(_hasPending || _isWriting)
+            {
+                _condition.wait(_mutex);
+            }
+
+            ofLogNotice("ofxOAuthCredentialWriter::save") << "The writer is stopped, saving on the calling thread : " << path;
+
+            std::string data = serializer();
+
+            if(data.empty() || !ofxOAuthAtomicFile::write(path, data))
+            {
+                ofLogError("ofxOAuthCredentialWriter::save") << "Failed to save : " << path;
+            }
+
+            return;
+        }
+
+        _pendingPath = path;
+        _pending = serializer;
+        _hasPending = true;
+
+        if(!_thread.isRunning() && !_isStopping)
+        {
+            _thread.setName("ofxOAuthCredentialWriter");
+            _thread.start(*this);
+        }
+
+        _condition.broadcast();
+    }
+
+    // Block until everything queued so far has been written.
+    void flush()
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+
+        while((_hasPending || _isWriting) && _thread.isRunning())
+        {
+            _condition.wait(_mutex);
+        }
+    }
+
+    // Write anything still pending and stop the writer thread.  Later
+    // saves are written on the calling thread.
+    void stop()
+    {
+        {
+            Poco::Mutex::ScopedLock lock(_mutex);
+            _isStopping = true;
+            _condition.broadcast();
+        }
+
+        if(_thread.isRunning())
+        {
+            _thread.join();
+        }
+    }
+
+    void run()
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+
+        for(;;)
+        {
+            while(!_hasPending && !_isStopping)
+            {
+                _condition.wait(_mutex);
+            }
+
+            if(!_hasPending) break; // stopping with nothing left to do
+
+            std::string path = _pendingPath;
+            Serializer serializer = _pending;
+            _pending = Serializer();
+            _hasPending = false;
+            _isWriting = true;
+
+            {
+                Poco::ScopedUnlock<Poco::Mutex> unlock(_mutex);
+
+                // an empty result means the serializer failed; keep the old file.
+                std::string data = serializer();
+
+                if(data.empty() || !ofxOAuthAtomicFile::write(path, data))
+                {
+                    ofLogError("ofxOAuthCredentialWriter::run") << "Failed to save : " << path;
+                }
+            }
+
+            _isWriting = false;
+            _condition.broadcast();
+        }
+    }
+
+protected:
+    Poco::Thread _thread;
+    Poco::Mutex _mutex;
+    Poco::Condition _condition;
+
+    std::string _pendingPath;
+    Serializer _pending;
+
+    bool _hasPending;
+    bool _isWriting;
+    bool _isStopping;
+
+};
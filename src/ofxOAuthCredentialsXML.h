@@ -0,0 +1,192 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include "Poco/AutoPtr.h"
+#include "Poco/DOM/DOMParser.h"
+#include "Poco/DOM/Document.h"
+#include "Poco/DOM/Element.h"
+#include "Poco/Exception.h"
+#include "ofxOAuthCredentials.h"
+#include "ofxOAuthCredentialStore.h"
+#include "ofxOAuthLog.h"
+
+
+// Reads and writes the credentials.xml format.
+//
+//        <oauth>
+//          <api_name></api_name>
+//          <api_url></api_url>
+//          <consumer_key></consumer_key>
+//          <consumer_secret></consumer_secret>
+//          <access_token></access_token>
+//          <access_secret></access_secret>
+//          <screen_name></screen_name>
+//          <user_id></user_id>
+//          <user_id_encoded></user_id_encoded>
+//          <user_password></user_password>
+//          <user_password_encoded></user_password_encoded>
+//        </oauth>
+//
+// It is read with Poco's DOM parser rather than ofxXmlSettings, so it works
+// without openFrameworks.  Paths are used as given.
+class ofxOAuthCredentialsXML
+{
+public:
+    // Writes every field load() reads, so a load followed by a save keeps
+    // them all.
+    static std::string toString(const ofxOAuthCredentials& credentials)
+    {
+        std::string text = "<oauth>\n";
+
+        text += _element("api_name", credentials.apiName);
+        text += _element("api_url", credentials.apiURL);
+
+        text += _element("consumer_key", credentials.consumerKey);
+        text += _element("consumer_secret", credentials.consumerSecret);
+
+        text += _element("access_token", credentials.accessToken);
+        text += _element("access_secret", credentials.accessTokenSecret);
+
+        text += _element("screen_name", credentials.screenName);
+
+        text += _element("user_id", credentials.userId);
+        text += _element("user_id_encoded", credentials.encodedUserId);
+
+        text += _element("user_password", credentials.userPassword);
+        text += _element("user_password_encoded", credentials.encodedUserPassword);
+
+        text += "</oauth>\n";
+        return text;
+    }
+
+    // Reads every field once.  Returns false if the file could not be read.
+    static bool load(const std::string& pathname, ofxOAuthCredentials& credentials)
+    {
+        std::ifstream file(pathname.c_str(), std::ios::in | std::ios::binary);
+
+        if(!file) return false;
+
+        std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        try
+        {
+            Poco::XML::DOMParser parser;
+            Poco::AutoPtr<Poco::XML::Document> document = parser.parseString(text);
+
+            Poco::XML::Element* oauth = document->documentElement();
+
+            if(0 == oauth || oauth->nodeName() != "oauth") return false;
+
+            credentials.apiName             = _value(oauth, "api_name");
+            credentials.apiURL              = _value(oauth, "api_url");
+
+            credentials.consumerKey         = _value(oauth, "consumer_key");
+            credentials.consumerSecret      = _value(oauth, "consumer_secret");
+
+            credentials.accessToken         = _value(oauth, "access_token");
+            credentials.accessTokenSecret   = _value(oauth, "access_secret");
+
+            credentials.screenName          = _value(oauth, "screen_name");
+
+            credentials.userId              = _value(oauth, "user_id");
+            credentials.encodedUserId       = _value(oauth, "user_id_encoded");
+
+            credentials.userPassword        = _value(oauth, "user_password");
+            credentials.encodedUserPassword = _value(oauth, "user_password_encoded");
+        }
+        catch(const Poco::Exception& exc)
+        {
+            ofLogError("ofxOAuthCredentialsXML::load") << "Unable to parse : " << pathname << " : " << exc.displayText();
+            return false;
+        }
+
+        return true;
+    }
+
+    // Copies a credentials.xml file into a credential store.  Older files do
+    // not record a user id, so one can be supplied.
+    static bool importInto(ofxOAuthCredentialStore& store,
+                           const std::string& pathname,
+                           const std::string& userId = "")
+    {
+        ofxOAuthCredentials credentials;
+
+        if(!load(pathname, credentials))
+        {
+            ofLogError("ofxOAuthCredentialsXML::importInto") << "Unable to read : " << pathname;
+            return false;
+        }
+
+        if(!userId.empty()) credentials.userId = userId;
+
+        if(credentials.userId.empty())
+        {
+            ofLogError("ofxOAuthCredentialsXML::importInto") << "No user id in : " << pathname;
+            return false;
+        }
+
+        if(!store.put(credentials))
+        {
+            ofLogError("ofxOAuthCredentialsXML::importInto") << "Unable to store credentials for user id : " << credentials.userId;
+            return false;
+        }
+
+        return true;
+    }
+
+private:
+    static std::string _value(Poco::XML::Element* parent, const std::string& name)
+    {
+        Poco::XML::Element* element = parent->getChildElement(name);
+        return element ? element->innerText() : "";
+    }
+
+    static std::string _element(const std::string& name, const std::string& value)
+    {
+        std::string escaped;
+
+        for(std::size_t i = 0; i < value.size(); ++i)
+        {
+            switch(value[i])
+            {
+                case '&': escaped += "&amp;"; break;
+                case '<': escaped += "&lt;"; break;
+                case '>': escaped += "&gt;"; break;
+                case '"': escaped += "&quot;"; break;
+                default: escaped += value[i]; break;
+            }
+        }
+
+        return "    <" + name + ">" + escaped + "</" + name + ">\n";
+    }
+
+};
@@ -0,0 +1,114 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include "Poco/Mutex.h"
+#include "ofxOAuthLog.h"
+
+
+// Where the continuation of an asynchronous request runs.
+class ofxOAuthExecutor
+{
+public:
+    typedef std::function<void()> Task;
+
+    virtual ~ofxOAuthExecutor()
+    {
+    }
+
+    // Runs task, now or later, on the executor's thread.  May be called
+    // from any thread.
+    virtual void post(Task task) = 0;
+};
+
+
+// Runs tasks right away on the posting thread.  For a request's
+// continuation that is the transport's I/O thread, so it must not block.
+class ofxOAuthInlineExecutor: public ofxOAuthExecutor
+{
+public:
+    void post(Task task)
+    {
+        task();
+    }
+};
+
+
+// Queues tasks until a thread calls poll(), e.g. the openFrameworks main
+// thread from its update.  ofxOAuthClient::update() polls the client's own
+// queue, see ofxOAuthClient::getUpdateExecutor().
+class ofxOAuthQueueExecutor: public ofxOAuthExecutor
+{
+public:
+    void post(Task task)
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        _tasks.push_back(task);
+    }
+
+    // Runs the tasks queued so far; tasks they queue wait for the next
+    // poll.  Returns the number that ran.
+    std::size_t poll()
+    {
+        std::deque<Task> tasks;
+
+        {
+            Poco::Mutex::ScopedLock lock(_mutex);
+            tasks.swap(_tasks);
+        }
+
+        for(std::size_t i = 0; i < tasks.size(); ++i)
+        {
+            try
+            {
+                tasks[i]();
+            }
+            catch(const std::exception& exc)
+            {
+                ofLogError("ofxOAuthQueueExecutor::poll") << "Task failed: " << exc.what();
+            }
+        }
+
+        return tasks.size();
+    }
+
+    std::size_t size() const
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        return _tasks.size();
+    }
+
+protected:
+    std::deque<Task> _tasks;
+    mutable Poco::Mutex _mutex;
+
+};
@@ -0,0 +1,239 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+#pragma once
+
+
+#include <cstddef>
+#include <string>
+
+
+// Decodes application/x-www-form-urlencoded text (i.e. a=b&c=d) in a single
+// pass.  Decoding is done in place, so the buffer passed in is modified and
+// the returned fields point into it.  No memory is allocated while iterating.
+//
+//      std::string reply = ...;
+//      ofxOAuthFormDecoder decoder(reply);
+//      ofxOAuthFormDecoder::Field field;
+//      while(decoder.next(field))
+//      {
+//          if(field.id == ofxOAuthFormDecoder::OAUTH_TOKEN) ...
+//      }
+//
+class ofxOAuthFormDecoder
+{
+public:
+    // Keys that the OAuth token endpoints and verifier callback return.
+    enum Key
+    {
+        UNKNOWN_KEY = 0,
+        OAUTH_TOKEN,
+        OAUTH_TOKEN_SECRET,
+        OAUTH_CALLBACK_CONFIRMED,
+        OAUTH_VERIFIER,
+        OAUTH_PROBLEM
+    };
+
+    // A view into the decoded buffer.
+    struct Range
+    {
+        Range(): data(0), size(0)
+        {
+        }
+
+        std::string str() const
+        {
+            return std::string(data, size);
+        }
+
+        bool empty() const
+        {
+            return 0 == size;
+        }
+
+        const char* data;
+        std::size_t size;
+    };
+
+    struct Field
+    {
+        Field(): id(UNKNOWN_KEY), hasValue(false)
+        {
+        }
+
+        Range key;
+        Range value;
+        Key id;
+        bool hasValue; //< false if the pair had no '=' at all.
+    };
+
+    ofxOAuthFormDecoder(char* buffer, std::size_t size):
+        _cursor(buffer),
+        _end(buffer + size)
+    {
+    }
+
+    explicit ofxOAuthFormDecoder(std::string& buffer):
+        _cursor(buffer.empty() ? 0 : &buffer[0]),
+        _end(buffer.empty() ? 0 : &buffer[0] + buffer.size())
+    {
+    }
+
+    // Advances to the next key/value pair.  Empty pairs (e.g. "a=b&&c=d")
+    // are skipped.  Only the first '=' separates the key from the value, so
+    // values may themselves contain '='.
+    bool next(Field& field)
+    {
+        while(_cursor < _end)
+        {
+            char* begin = _cursor;
+            char* separator = 0;
+            char* p = begin;
+
+            while(p < _end && *p != '&')
+            {
+                if(0 == separator && *p == '=') separator = p;
+                ++p;
+            }
+
+            _cursor = (p < _end) ? p + 1 : _end;
+
+            if(p == begin) continue; // empty pair
+
+            char* keyEnd = separator ? separator : p;
+
+            field.key.data = begin;
+            field.key.size = percentDecode(begin, keyEnd - begin);
+            field.id = lookup(field.key.data, field.key.size);
+            field.hasValue = (0 != separator);
+
+            if(separator)
+            {
+                field.value.data = separator + 1;
+                field.value.size = percentDecode(separator + 1, p - (separator + 1));
+            }
+            else
+            {
+                field.value.data = p;
+                field.value.size = 0;
+            }
+
+            return true;
+        }
+
+        return false;
+    }
+
+    // Percent-decodes (and translates '+' to ' ') in place.  Returns the
+    // decoded size, which is never larger than the input size.  Malformed
+    // escapes are copied through unchanged.
+    static std::size_t percentDecode(char* data, std::size_t size)
+    {
+        const char* in = data;
+        const char* end = data + size;
+        char* out = data;
+
+        while(in < end)
+        {
+            if(*in == '%' && (end - in) > 2)
+            {
+                int hi = hexValue(in[1]);
+                int lo = hexValue(in[2]);
+
+                if(hi >= 0 && lo >= 0)
+                {
+                    *out++ = static_cast<char>((hi << 4) | lo);
+                    in += 3;
+                    continue;
+                }
+            }
+
+            *out++ = (*in == '+') ? ' ' : *in;
+            ++in;
+        }
+
+        return out - data;
+    }
+
+    // Maps a key to a known OAuth key.  The known keys all have distinct
+    // lengths, so the length alone is a perfect hash and a single
+    // case-insensitive comparison confirms the match.
+    static Key lookup(const char* key, std::size_t size)
+    {
+        const char* candidate = 0;
+        Key id = UNKNOWN_KEY;
+
+        switch(size)
+        {
+            case 11:
+                candidate = "oauth_token";
+                id = OAUTH_TOKEN;
+                break;
+            case 13:
+                candidate = "oauth_problem";
+                id = OAUTH_PROBLEM;
+                break;
+            case 14:
+                candidate = "oauth_verifier";
+                id = OAUTH_VERIFIER;
+                break;
+            case 18:
+                candidate = "oauth_token_secret";
+                id = OAUTH_TOKEN_SECRET;
+                break;
+            case 24:
+                candidate = "oauth_callback_confirmed";
+                id = OAUTH_CALLBACK_CONFIRMED;
+                break;
+            default:
+                return UNKNOWN_KEY;
+        }
+
+        for(std::size_t i = 0; i < size; ++i)
+        {
+            if(toLower(key[i]) != candidate[i]) return UNKNOWN_KEY;
+        }
+
+        return id;
+    }
+
+private:
+    static int hexValue(char c)
+    {
+        if(c >= '0' && c <= '9') return c - '0';
+        if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    static char toLower(char c)
+    {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+    }
+
+    char* _cursor;
+    char* _end;
+
+};
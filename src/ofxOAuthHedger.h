@@ -0,0 +1,387 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "Poco/Condition.h"
+#include "Poco/Event.h"
+#include "Poco/Mutex.h"
+#include "Poco/Timestamp.h"
+#include "ofxOAuthCancellationToken.h"
+#include "ofxOAuthTransport.h"
+
+
+// Hedges idempotent requests to cut tail latency.  The request is started
+// as usual; if it has not received its first byte after a delay taken from
+// a percentile of recent first-byte latencies, a duplicate, freshly signed
+// (new nonce and timestamp) request is sent too.  The first complete
+// response wins and the other request is cancelled.  Both run on the
+// transport's I/O thread, next to the asynchronous requests; only the
+// caller's thread waits.
+//
+// Hedging starts once enough latency samples have been collected, and the
+// share of hedged requests is capped so that an outage does not double the
+// load on the server.
+class ofxOAuthHedger
+{
+public:
+    // Returns a freshly signed "Authorization: ..." header.
+    typedef std::function<std::string()> Signer;
+
+    struct Settings
+    {
+        Settings():
+            enabled(false),
+            percentile(0.95),
+            minDelay(5),
+            maxDelay(5000),
+            minSamples(20),
+            maxHedgeRatio(0.1)
+        {
+        }
+
+        bool enabled;
+        double percentile;      //< of first-byte latency, 0..1
+        long minDelay;          //< milliseconds
+        long maxDelay;          //< milliseconds
+        std::size_t minSamples; //< samples needed before hedging starts
+        double maxHedgeRatio;   //< hedged requests / requests, at most
+    };
+
+    struct Stats
+    {
+        Stats():
+            requests(0),
+            hedged(0),
+            hedgeWins(0),
+            latencySaved(0)
+        {
+        }
+
+        double getHedgeRate() const
+        {
+            return requests > 0 ? double(hedged) / requests : 0;
+        }
+
+        unsigned long long requests;
+        unsigned long long hedged;    //< duplicates sent
+        unsigned long long hedgeWins; //< duplicates that answered first
+        double latencySaved;          //< estimated, in milliseconds
+    };
+
+    ofxOAuthHedger():
+        _outstanding(0),
+        _nextFirstByteSample(0),
+        _nextLatencySample(0)
+    {
+    }
+
+    virtual ~ofxOAuthHedger()
+    {
+        // losers are cancelled, but may still be unwinding on the I/O
+        // thread, where their completions refer to this.
+        Poco::Mutex::ScopedLock lock(_mutex);
+
+        while(_outstanding > 0)
+        {
+            _idle.wait(_mutex);
+        }
+    }
+
+    void setSettings(const Settings& settings)
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        _settings = settings;
+    }
+
+    Settings getSettings() const
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        return _settings;
+    }
+
+    Stats getStats() const
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        return _stats;
+    }
+
+    // Blocks until a response is available.  Returns response.isComplete().
+    bool perform(ofxOAuthTransport& transport,
+                 const ofxOAuthRequest& request,
+                 Signer signer,
+                 ofxOAuthResponse& response)
+    {
+        long delay = 0;
+        bool canHedge = false;
+
+        {
+            Poco::Mutex::ScopedLock lock(_mutex);
+
+            if(!_settings.enabled)
+            {
+                return transport.perform(request, response);
+            }
+
+            ++_stats.requests;
+
+            delay = _delay();
+
+            canHedge = delay > 0 &&
+                       _stats.hedged < _settings.maxHedgeRatio * _stats.requests;
+        }
+
+        std::shared_ptr<Race> race(new Race());
+
+        Poco::Timestamp start;
+
+        _start(transport, request, race, 0);
+
+        bool hedged = false;
+
+        if(canHedge && !race->firstByteOrDone.tryWait(delay))
+        {
+            ofxOAuthRequest duplicate = request;
+            duplicate.setHeader(signer());
+
+            hedged = true;
+
+            _start(transport, duplicate, race, 1);
+        }
+
+        race->done.wait();
+
+        double elapsed = start.elapsed() / 1000.0;
+
+        std::size_t winner = 0;
+        double firstByte = 0;
+
+        {
+            // a loser may still be writing its own slot.
+            Poco::Mutex::ScopedLock lock(race->mutex);
+            winner = race->winner;
+            firstByte = race->firstByte[0];
+            response = race->responses[winner];
+        }
+
+        Poco::Mutex::ScopedLock lock(_mutex);
+
+        if(winner == 0 || !hedged)
+        {
+            if(firstByte > 0) _addSample(_firstByteSamples, _nextFirstByteSample, firstByte);
+            if(response.isComplete()) _addSample(_latencySamples, _nextLatencySample, elapsed);
+        }
+
+        if(hedged)
+        {
+            ++_stats.hedged;
+
+            if(winner == 1)
+            {
+                ++_stats.hedgeWins;
+
+                // the primary was cut short, so estimate what it would
+                // have taken from the recent requests slower than this one.
+                double expected = _meanAbove(_latencySamples, elapsed);
+                if(expected > elapsed) _stats.latencySaved += expected - elapsed;
+            }
+        }
+
+        return response.isComplete();
+    }
+
+protected:
+    // Shared by the attempts of one request; outlives the caller if a
+    // cancelled loser is still unwinding.
+    struct Race
+    {
+        Race():
+            firstByteOrDone(false),
+            done(false),
+            winner(0),
+            started(0),
+            finished(0)
+        {
+            firstByte[0] = firstByte[1] = 0;
+            tokens[0].reset(new ofxOAuthCancellationToken());
+            tokens[1].reset(new ofxOAuthCancellationToken());
+        }
+
+        Poco::Event firstByteOrDone;
+        Poco::Event done;
+
+        Poco::Mutex mutex;
+        ofxOAuthResponse responses[2];
+        double firstByte[2]; //< milliseconds, 0 if none
+        std::shared_ptr<ofxOAuthCancellationToken> tokens[2];
+        std::size_t winner;
+        std::size_t started;
+        std::size_t finished;
+    };
+
+    // Queues one attempt on the transport's I/O thread.
+    void _start(ofxOAuthTransport& transport,
+                const ofxOAuthRequest& request,
+                std::shared_ptr<Race> race,
+                std::size_t index)
+    {
+        {
+            Poco::Mutex::ScopedLock lock(race->mutex);
+            ++race->started;
+        }
+
+        {
+            Poco::Mutex::ScopedLock lock(_mutex);
+            ++_outstanding;
+        }
+
+        ofxOAuthRequest attempt = request;
+
+        // queued from now, the duplicate too.
+        attempt.queuedAt = 0;
+        attempt.cancellationToken = race->tokens[index];
+
+        Poco::Timestamp start;
+
+        attempt.onFirstByte = [race, index, start]()
+        {
+            {
+                Poco::Mutex::ScopedLock lock(race->mutex);
+                race->firstByte[index] = start.elapsed() / 1000.0;
+            }
+
+            race->firstByteOrDone.set();
+        };
+
+        transport.performAsync(attempt, [this, race, index](const ofxOAuthRequest&, ofxOAuthResponse& response)
+        {
+            _finish(race, index, response);
+        });
+    }
+
+    // Runs as an attempt completes: the first complete response, or the
+    // last response of all, ends the race.
+    void _finish(std::shared_ptr<Race> race,
+                 std::size_t index,
+                 const ofxOAuthResponse& response)
+    {
+        {
+            Poco::Mutex::ScopedLock lock(race->mutex);
+
+            bool isFirstComplete = response.isComplete() && !race->responses[race->winner].isComplete();
+            bool isLast = ++race->finished == race->started;
+
+            race->responses[index] = response;
+
+            if(isFirstComplete || isLast)
+            {
+                if(isFirstComplete) race->winner = index;
+
+                // cancel whoever is still running.
+                race->tokens[0]->cancel();
+                race->tokens[1]->cancel();
+
+                race->firstByteOrDone.set();
+                race->done.set();
+            }
+        }
+
+        Poco::Mutex::ScopedLock lock(_mutex);
+        --_outstanding;
+        _idle.broadcast();
+    }
+
+    // The hedge delay in milliseconds, or 0 if there are too few samples.
+    long _delay() const
+    {
+        if(_firstByteSamples.size() < _settings.minSamples || _firstByteSamples.empty())
+        {
+            return 0;
+        }
+
+        std::vector<double> samples(_firstByteSamples);
+
+        std::size_t n = static_cast<std::size_t>(_settings.percentile * (samples.size() - 1));
+
+        std::nth_element(samples.begin(), samples.begin() + n, samples.end());
+
+        long delay = static_cast<long>(samples[n] + 0.5);
+
+        return std::max(_settings.minDelay, std::min(_settings.maxDelay, delay));
+    }
+
+    static void _addSample(std::vector<double>& samples, std::size_t& next, double value)
+    {
+        if(samples.size() < MAX_SAMPLES)
+        {
+            samples.push_back(value);
+        }
+        else
+        {
+            samples[next++ % MAX_SAMPLES] = value;
+        }
+    }
+
+    static double _meanAbove(const std::vector<double>& samples, double value)
+    {
+        double sum = 0;
+        std::size_t count = 0;
+
+        for(std::size_t i = 0; i < samples.size(); ++i)
+        {
+            if(samples[i] > value)
+            {
+                sum += samples[i];
+                ++count;
+            }
+        }
+
+        return count > 0 ? sum / count : 0;
+    }
+
+    enum
+    {
+        MAX_SAMPLES = 512
+    };
+
+    Settings _settings;
+    Stats _stats;
+
+    std::size_t _outstanding;
+    std::vector<double> _firstByteSamples; //< milliseconds
+    std::vector<double> _latencySamples;   //< milliseconds
+    std::size_t _nextFirstByteSample;
+    std::size_t _nextLatencySample;
+
+    mutable Poco::Mutex _mutex;
+    Poco::Condition _idle; //< signalled as attempts finish
+
+};
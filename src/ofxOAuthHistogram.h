@@ -0,0 +1,182 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+
+
+// A fixed-size, HDR-style histogram of non-negative integer values (e.g.
+// microseconds).  Values below 32 are counted exactly; above that each
+// power of two is split into 32 buckets, so a bucket is never more than
+// about 3% wide.  Values of 2^36 and up land in the last bucket.
+//
+// record() is lock-free and wait-free apart from the max update, so it is
+// cheap enough to call on every request from any thread.
+class ofxOAuthHistogram
+{
+public:
+    enum
+    {
+        SUB_BUCKET_BITS = 5,
+        SUB_BUCKETS = 1 << SUB_BUCKET_BITS,
+        MAX_BIT = 35,
+        BUCKETS = SUB_BUCKETS + (MAX_BIT - SUB_BUCKET_BITS + 1) * SUB_BUCKETS
+    };
+
+    // A consistent-enough copy to compute percentiles from.
+    struct Snapshot
+    {
+        Snapshot(): count(0), sum(0), max(0)
+        {
+        }
+
+        // The value at or below which p (0 - 1) of the values fall, reported
+        // as the highest value of its bucket.
+        uint64_t getPercentile(double p) const
+        {
+            if(count == 0) return 0;
+
+            uint64_t rank = static_cast<uint64_t>(p * count + 0.5);
+            if(rank < 1) rank = 1;
+            if(rank > count) rank = count;
+
+            uint64_t seen = 0;
+
+            for(std::size_t i = 0; i < counts.size(); ++i)
+            {
+                seen += counts[i];
+
+                if(seen >= rank)
+                {
+                    uint64_t value = getHighestValue(i);
+                    return value < max ? value : max;
+                }
+            }
+
+            return max;
+        }
+
+        double getMean() const
+        {
+            return count > 0 ? double(sum) / count : 0;
+        }
+
+        std::vector<uint64_t> counts;
+        uint64_t count;
+        uint64_t sum;
+        uint64_t max;
+    };
+
+    ofxOAuthHistogram()
+    {
+        reset();
+    }
+
+    void record(uint64_t value)
+    {
+        _counts[getIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        _count.fetch_add(1, std::memory_order_relaxed);
+        _sum.fetch_add(value, std::memory_order_relaxed);
+
+        uint64_t max = _max.load(std::memory_order_relaxed);
+
+        while(value > max && !_max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    Snapshot getSnapshot() const
+    {
+        Snapshot snapshot;
+        snapshot.counts.resize(BUCKETS);
+
+        for(std::size_t i = 0; i < BUCKETS; ++i)
+        {
+            snapshot.counts[i] = _counts[i].load(std::memory_order_relaxed);
+            snapshot.count += snapshot.counts[i];
+        }
+
+        snapshot.sum = _sum.load(std::memory_order_relaxed);
+        snapshot.max = _max.load(std::memory_order_relaxed);
+
+        return snapshot;
+    }
+
+    uint64_t getCount() const
+    {
+        return _count.load(std::memory_order_relaxed);
+    }
+
+    void reset()
+    {
+        for(std::size_t i = 0; i < BUCKETS; ++i)
+        {
+            _counts[i].store(0, std::memory_order_relaxed);
+        }
+
+        _count.store(0, std::memory_order_relaxed);
+        _sum.store(0, std::memory_order_relaxed);
+        _max.store(0, std::memory_order_relaxed);
+    }
+
+    static std::size_t getIndex(uint64_t value)
+    {
+        if(value < SUB_BUCKETS) return static_cast<std::size_t>(value);
+
+        int bit = 63;
+        while(0 == (value >> bit)) --bit;
+
+        if(bit > MAX_BIT) return BUCKETS - 1;
+
+        int shift = bit - SUB_BUCKET_BITS;
+
+        return SUB_BUCKETS + shift * SUB_BUCKETS + static_cast<std::size_t>((value >> shift) & (SUB_BUCKETS - 1));
+    }
+
+    static uint64_t getHighestValue(std::size_t index)
+    {
+        if(index < SUB_BUCKETS) return index;
+
+        std::size_t shift = (index - SUB_BUCKETS) / SUB_BUCKETS;
+        uint64_t sub = (index - SUB_BUCKETS) % SUB_BUCKETS;
+
+        return ((SUB_BUCKETS + sub + 1) << shift) - 1;
+    }
+
+protected:
+    ofxOAuthHistogram(const ofxOAuthHistogram&);
+    ofxOAuthHistogram& operator=(const ofxOAuthHistogram&);
+
+    std::atomic<uint64_t> _counts[BUCKETS];
+    std::atomic<uint64_t> _count;
+    std::atomic<uint64_t> _sum;
+    std::atomic<uint64_t> _max;
+
+};
@@ -0,0 +1,867 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+
+// Pulls a few values out of a JSON document as it streams in, without
+// building a DOM or keeping the document.  Values are addressed with JSON
+// pointers (RFC 6901), where a "*" token matches any member or element:
+//
+//      ofxOAuthJSONExtractor extractor;
+//      extractor.add("/id_str");
+//      extractor.add("/user/screen_name");
+//      extractor.add("/entities/hashtags/*/text");
+//
+//      client.get("/1.1/statuses/show.json", "id=210462857140252672", extractor, response);
+//
+//      std::string name = extractor.get("/user/screen_name");
+//      std::vector<std::string> tags = extractor.getAll("/entities/hashtags/*/text");
+//
+// Strings are returned unescaped; numbers, literals, objects and arrays as
+// their JSON text.  Only matched values are copied; subtrees no pointer
+// reaches into are skipped by searching for the next structural character
+// (memchr for string ends), not parsed token by token, so they are not
+// fully validated either.
+class ofxOAuthJSONExtractor
+{
+public:
+    // Called as soon as a value is complete, with the pointer it matched
+    // (as added) and the value.
+    typedef std::function<void(const std::string& pointer, const std::string& value)> Listener;
+
+    ofxOAuthJSONExtractor()
+    {
+        reset();
+    }
+
+    explicit ofxOAuthJSONExtractor(const std::vector<std::string>& pointers)
+    {
+        for(std::size_t i = 0; i < pointers.size(); ++i)
+        {
+            add(pointers[i]);
+        }
+
+        reset();
+    }
+
+    virtual ~ofxOAuthJSONExtractor()
+    {
+    }
+
+    // Adds a pointer to extract.  "" is the whole document.
+    void add(const std::string& pointer)
+    {
+        _Pointer parsed;
+        parsed.text = pointer;
+
+        std::string::size_type begin = 0;
+
+        if(!pointer.empty() && pointer[0] == '/')
+        {
+            while(begin != std::string::npos)
+            {
+                std::string::size_type end = pointer.find('/', begin + 1);
+                std::string token = pointer.substr(begin + 1, end == std::string::npos ? std::string::npos : end - begin - 1);
+                parsed.tokens.push_back(_parseToken(token));
+                begin = end;
+            }
+        }
+
+        _pointers.push_back(parsed);
+        _values.push_back(std::vector<std::string>());
+    }
+
+    void setListener(Listener listener)
+    {
+        _listener = listener;
+    }
+
+    // Forgets extracted values and parser state, keeping the pointers, so
+    // a new document can be fed.
+    void reset()
+    {
+        _state = VALUE;
+        _frames.clear();
+        _captures.clear();
+        _string.clear();
+        _isKey = false;
+        _escape = 0;
+        _codeUnit = 0;
+        _highSurrogate = 0;
+        _skipDepth = 0;
+        _skipInString = false;
+        _skipEscape = false;
+        _position = 0;
+        _error.clear();
+
+        for(std::size_t i = 0; i < _values.size(); ++i)
+        {
+            _values[i].clear();
+        }
+    }
+
+    // Scans the next chunk of the document.  Returns false once the input
+    // is found not to be JSON.
+    bool feed(const char* data, std::size_t size)
+    {
+        if(_state == ERROR) return false;
+
+        std::size_t i = 0;
+
+        while(i < size && _state != ERROR)
+        {
+            switch(_state)
+            {
+                case VALUE:
+                    i = _skipSpace(data, size, i);
+                    if(i < size) i = _beginValue(data, i);
+                    break;
+                case ARRAY_FIRST:
+                    i = _skipSpace(data, size, i);
+                    if(i < size)
+                    {
+                        if(data[i] == ']') i = _close(data, i, true);
+                        else _state = VALUE;
+                    }
+                    break;
+                case OBJECT_FIRST:
+                case OBJECT_KEY:
+                    i = _skipSpace(data, size, i);
+                    if(i < size)
+                    {
+                        if(data[i] == '"')
+                        {
+                            _string.clear();
+                            _isKey = true;
+                            _state = STRING;
+                            ++i;
+                        }
+                        else if(data[i] == '}' && _state == OBJECT_FIRST)
+                        {
+                            i = _close(data, i, false);
+                        }
+                        else
+                        {
+                            _fail(i, "expected a member name");
+                        }
+                    }
+                    break;
+                case COLON:
+                    i = _skipSpace(data, size, i);
+                    if(i < size)
+                    {
+                        if(data[i] == ':')
+                        {
+                            _state = VALUE;
+                            ++i;
+                        }
+                        else
+                        {
+                            _fail(i, "expected ':'");
+                        }
+                    }
+                    break;
+                case AFTER_VALUE:
+                    i = _skipSpace(data, size, i);
+                    if(i < size) i = _afterValue(data, i);
+                    break;
+                case STRING:
+                    i = _scanString(data, size, i);
+                    break;
+                case LITERAL:
+                    i = _scanLiteral(data, size, i);
+                    break;
+                case SKIP:
+                    i = _skip(data, size, i);
+                    break;
+                case DONE:
+                    i = _skipSpace(data, size, i);
+                    if(i < size) _fail(i, "unexpected data after the document");
+                    break;
+                case ERROR:
+                    break;
+            }
+        }
+
+        // raw values still open continue in the next chunk.
+        for(std::size_t j = 0; j < _captures.size(); ++j)
+        {
+            if(_captures[j].isRaw)
+            {
+                _captures[j].value.append(data + _captures[j].chunkStart, size - _captures[j].chunkStart);
+                _captures[j].chunkStart = 0;
+            }
+        }
+
+        _position += size;
+
+        return _state != ERROR;
+    }
+
+    bool feed(const std::string& data)
+    {
+        return feed(data.data(), data.size());
+    }
+
+    // Ends the document; only needed when it may be a bare number.
+    // Returns isComplete().
+    bool finish()
+    {
+        if(_state == LITERAL && _frames.empty())
+        {
+            _endLiteral(0, 0);
+        }
+
+        return isComplete();
+    }
+
+    // True once the top level value has been read.
+    bool isComplete() const
+    {
+        return _state == DONE;
+    }
+
+    bool hasError() const
+    {
+        return _state == ERROR;
+    }
+
+    const std::string& getError() const
+    {
+        return _error;
+    }
+
+    bool has(const std::string& pointer) const
+    {
+        const std::vector<std::string>* values = _find(pointer);
+        return 0 != values && !values->empty();
+    }
+
+    // The first value the pointer matched.
+    std::string get(const std::string& pointer, const std::string& defaultValue = "") const
+    {
+        const std::vector<std::string>* values = _find(pointer);
+        return (0 != values && !values->empty()) ? values->front() : defaultValue;
+    }
+
+    // Every value the pointer matched, in document order.
+    std::vector<std::string> getAll(const std::string& pointer) const
+    {
+        const std::vector<std::string>* values = _find(pointer);
+        return 0 != values ? *values : std::vector<std::string>();
+    }
+
+    // A sink for ofxOAuthRequest::onBody.  The extractor must outlive the
+    // transfer.
+    std::function<void(const char* data, std::size_t size)> getSink()
+    {
+        return [this](const char* data, std::size_t size)
+        {
+            feed(data, size);
+        };
+    }
+
+protected:
+    enum State
+    {
+        VALUE,
+        ARRAY_FIRST,  //< after '['
+        OBJECT_FIRST, //< after '{'
+        OBJECT_KEY,   //< after ',' in an object
+        COLON,
+        AFTER_VALUE,
+        STRING,
+        LITERAL,
+        SKIP,         //< inside a subtree nothing is extracted from
+        DONE,
+        ERROR
+    };
+
+    struct _Token
+    {
+        std::string key;
+        long index; //< -1 if the token is not an array index
+        bool isWildcard;
+    };
+
+    struct _Pointer
+    {
+        std::string text;
+        std::vector<_Token> tokens;
+    };
+
+    struct _Frame
+    {
+        bool isArray;
+        std::string key;
+        std::size_t index;
+    };
+
+    struct _Capture
+    {
+        std::vector<std::size_t> targets; //< indices into _pointers
+        std::size_t depth;                //< _frames.size() where the value starts
+        bool isRaw;                       //< copied as JSON text (not a string)
+        std::size_t chunkStart;           //< where the raw text resumes in this chunk
+        std::string value;
+    };
+
+    static _Token _parseToken(const std::string& escaped)
+    {
+        _Token token;
+        token.isWildcard = escaped == "*";
+        token.index = -1;
+
+        // ~1 is '/', ~0 is '~'.
+        for(std::size_t i = 0; i < escaped.size(); ++i)
+        {
+            if(escaped[i] == '~' && i + 1 < escaped.size() && (escaped[i + 1] == '0' || escaped[i + 1] == '1'))
+            {
+                token.key += escaped[i + 1] == '0' ? '~' : '/';
+                ++i;
+            }
+            else
+            {
+                token.key += escaped[i];
+            }
+        }
+
+        if(!token.key.empty() &&
+           token.key.size() < 10 &&
+           token.key.find_first_not_of("0123456789") == std::string::npos &&
+           (token.key == "0" || token.key[0] != '0'))
+        {
+            token.index = atol(token.key.c_str());
+        }
+
+        return token;
+    }
+
+    static bool _isSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    static std::size_t _skipSpace(const char* data, std::size_t size, std::size_t i)
+    {
+        while(i < size && _isSpace(data[i])) ++i;
+        return i;
+    }
+
+    // Does the pointer's token at depth match the child frame selects?
+    static bool _matches(const _Token& token, const _Frame& frame)
+    {
+        if(token.isWildcard) return true;
+        if(frame.isArray) return token.index >= 0 && static_cast<std::size_t>(token.index) == frame.index;
+        return token.key == frame.key;
+    }
+
+    // The pointers that address the value about to start, and whether any
+    // reaches below it.
+    void _match(std::vector<std::size_t>& targets, bool& isReachedBelow) const
+    {
+        isReachedBelow = false;
+
+        for(std::size_t p = 0; p < _pointers.size(); ++p)
+        {
+            const std::vector<_Token>& tokens = _pointers[p].tokens;
+
+            if(tokens.size() < _frames.size()) continue;
+
+            bool isPrefix = true;
+
+            for(std::size_t d = 0; d < _frames.size() && isPrefix; ++d)
+            {
+                isPrefix = _matches(tokens[d], _frames[d]);
+            }
+
+            if(!isPrefix) continue;
+
+            if(tokens.size() == _frames.size()) targets.push_back(p);
+            else isReachedBelow = true;
+        }
+    }
+
+    std::size_t _beginValue(const char* data, std::size_t i)
+    {
+        char c = data[i];
+
+        std::vector<std::size_t> targets;
+        bool isReachedBelow = false;
+        _match(targets, isReachedBelow);
+
+        if(c == '{' || c == '[')
+        {
+            if(!targets.empty()) _beginCapture(targets, true, i);
+
+            if(!isReachedBelow)
+            {
+                _state = SKIP;
+                _skipDepth = 1;
+                _skipInString = false;
+                _skipEscape = false;
+                return i + 1;
+            }
+
+            _Frame frame;
+            frame.isArray = c == '[';
+            frame.index = 0;
+            _frames.push_back(frame);
+
+            _state = frame.isArray ? ARRAY_FIRST : OBJECT_FIRST;
+            return i + 1;
+        }
+
+        if(c == '"')
+        {
+            if(!targets.empty()) _beginCapture(targets, false, i);
+
+            _string.clear();
+            _isKey = false;
+            _state = STRING;
+            return i + 1;
+        }
+
+        if(c == '-' || (c >= '0' && c <= '9') || c == 't' || c == 'f' || c == 'n')
+        {
+            if(!targets.empty()) _beginCapture(targets, true, i);
+
+            _state = LITERAL;
+            return i;
+        }
+
+        _fail(i, "expected a value");
+        return i;
+    }
+
+    void _beginCapture(const std::vector<std::size_t>& targets, bool isRaw, std::size_t i)
+    {
+        _Capture capture;
+        capture.targets = targets;
+        capture.depth = _frames.size();
+        capture.isRaw = isRaw;
+        capture.chunkStart = i;
+        _captures.push_back(capture);
+    }
+
+    // The value that started at the current depth ended at end (exclusive)
+    // in data.
+    void _endValue(const char* data, std::size_t end)
+    {
+        while(!_captures.empty() && _captures.back().depth == _frames.size())
+        {
+            _Capture& capture = _captures.back();
+
+            if(capture.isRaw && end > capture.chunkStart)
+            {
+                capture.value.append(data + capture.chunkStart, end - capture.chunkStart);
+            }
+            else if(!capture.isRaw)
+            {
+                capture.value.swap(_string);
+            }
+
+            for(std::size_t t = 0; t < capture.targets.size(); ++t)
+            {
+                std::size_t p = capture.targets[t];
+
+                _values[p].push_back(capture.value);
+
+                if(_listener) _listener(_pointers[p].text, capture.value);
+            }
+
+            _captures.pop_back();
+        }
+
+        _state = _frames.empty() ? DONE : AFTER_VALUE;
+    }
+
+    std::size_t _close(const char* data, std::size_t i, bool isArray)
+    {
+        if(_frames.empty() || _frames.back().isArray != isArray)
+        {
+            _fail(i, "mismatched bracket");
+            return i;
+        }
+
+        _frames.pop_back();
+        _endValue(data, i + 1);
+        return i + 1;
+    }
+
+    std::size_t _afterValue(const char* data, std::size_t i)
+    {
+        char c = data[i];
+
+        if(c == ',')
+        {
+            _Frame& frame = _frames.back();
+
+            if(frame.isArray)
+            {
+                ++frame.index;
+                _state = VALUE;
+            }
+            else
+            {
+                _state = OBJECT_KEY;
+            }
+
+            return i + 1;
+        }
+
+        if(c == ']' || c == '}')
+        {
+            return _close(data, i, c == ']');
+        }
+
+        _fail(i, "expected ',' or a closing bracket");
+        return i;
+    }
+
+    // Keys are always needed; string values only if captured.
+    bool _isStringNeeded() const
+    {
+        return _isKey || (!_captures.empty() && !_captures.back().isRaw && _captures.back().depth == _frames.size());
+    }
+
+    std::size_t _scanString(const char* data, std::size_t size, std::size_t i)
+    {
+        bool isNeeded = _isStringNeeded();
+
+        while(i < size)
+        {
+            if(_escape == 1)
+            {
+                char c = data[i++];
+                _escape = 0;
+
+                switch(c)
+                {
+                    case '"': _append('"', isNeeded); break;
+                    case '\\': _append('\\', isNeeded); break;
+                    case '/': _append('/', isNeeded); break;
+                    case 'b': _append('\b', isNeeded); break;
+                    case 'f': _append('\f', isNeeded); break;
+                    case 'n': _append('\n', isNeeded); break;
+                    case 'r': _append('\r', isNeeded); break;
+                    case 't': _append('\t', isNeeded); break;
+                    case 'u':
+                        _escape = 2;
+                        _codeUnit = 0;
+                        break;
+                    default:
+                        _fail(i - 1, "invalid escape");
+                        return i;
+                }
+
+                continue;
+            }
+
+            if(_escape >= 2)
+            {
+                int digit = _hexValue(data[i++]);
+
+                if(digit < 0)
+                {
+                    _fail(i - 1, "invalid \\u escape");
+                    return i;
+                }
+
+                _codeUnit = (_codeUnit << 4) | static_cast<uint32_t>(digit);
+
+                if(++_escape == 6)
+                {
+                    _escape = 0;
+                    if(isNeeded) _appendCodeUnit(_codeUnit);
+                }
+
+                continue;
+            }
+
+            // the bulk of a string: find its end or the next escape.
+            const char* begin = data + i;
+            const char* quote = static_cast<const char*>(memchr(begin, '"', size - i));
+            const char* limit = 0 != quote ? quote : data + size;
+            const char* backslash = static_cast<const char*>(memchr(begin, '\\', limit - begin));
+            const char* stop = 0 != backslash ? backslash : limit;
+
+            if(isNeeded && stop > begin)
+            {
+                _flushSurrogate();
+                _string.append(begin, stop - begin);
+            }
+
+            i = stop - data;
+
+            if(0 != backslash)
+            {
+                _escape = 1;
+                ++i;
+            }
+            else if(0 != quote)
+            {
+                ++i;
+                _flushSurrogate();
+                _endString(data, i);
+                return i;
+            }
+        }
+
+        return i;
+    }
+
+    void _endString(const char* data, std::size_t end)
+    {
+        if(_isKey)
+        {
+            _frames.back().key.swap(_string);
+            _string.clear();
+            _isKey = false;
+            _state = COLON;
+        }
+        else
+        {
+            _endValue(data, end);
+        }
+    }
+
+    void _append(char c, bool isNeeded)
+    {
+        if(!isNeeded) return;
+        _flushSurrogate();
+        _string += c;
+    }
+
+    // Appends a UTF-16 code unit as UTF-8, pairing surrogates.
+    void _appendCodeUnit(uint32_t unit)
+    {
+        if(unit >= 0xD800 && unit <= 0xDBFF)
+        {
+            _flushSurrogate();
+            _highSurrogate = unit;
+            return;
+        }
+
+        uint32_t codePoint = unit;
+
+        if(unit >= 0xDC00 && unit <= 0xDFFF)
+        {
+            if(_highSurrogate == 0)
+            {
+                codePoint = 0xFFFD;
+            }
+            else
+            {
+                codePoint = 0x10000 + ((_highSurrogate - 0xD800) << 10) + (unit - 0xDC00);
+                _highSurrogate = 0;
+            }
+        }
+        else
+        {
+            _flushSurrogate();
+        }
+
+        _appendUTF8(codePoint);
+    }
+
+    // A high surrogate without its low half.
+    void _flushSurrogate()
+    {
+        if(_highSurrogate != 0)
+        {
+            _highSurrogate = 0;
+            _appendUTF8(0xFFFD);
+        }
+    }
+
+    void _appendUTF8(uint32_t codePoint)
+    {
+        if(codePoint < 0x80)
+        {
+            _string += static_cast<char>(codePoint);
+        }
+        else if(codePoint < 0x800)
+        {
+            _string += static_cast<char>(0xC0 | (codePoint >> 6));
+            _string += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+        else if(codePoint < 0x10000)
+        {
+            _string += static_cast<char>(0xE0 | (codePoint >> 12));
+            _string += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            _string += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+        else
+        {
+            _string += static_cast<char>(0xF0 | (codePoint >> 18));
+            _string += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+            _string += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            _string += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+    }
+
+    static int _hexValue(char c)
+    {
+        if(c >= '0' && c <= '9') return c - '0';
+        if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    static bool _isLiteralChar(char c)
+    {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || c == '-' || c == '+' || c == '.' || c == 'E';
+    }
+
+    std::size_t _scanLiteral(const char* data, std::size_t size, std::size_t i)
+    {
+        while(i < size && _isLiteralChar(data[i])) ++i;
+
+        if(i < size) _endLiteral(data, i);
+
+        return i;
+    }
+
+    void _endLiteral(const char* data, std::size_t end)
+    {
+        // only the first character was checked; a malformed number or
+        // literal inside it is let through.
+        _endValue(data, end);
+    }
+
+    // Skips a subtree no pointer reaches into, counting brackets outside
+    // of strings.
+    std::size_t _skip(const char* data, std::size_t size, std::size_t i)
+    {
+        while(i < size)
+        {
+            if(_skipEscape)
+            {
+                _skipEscape = false;
+                ++i;
+                continue;
+            }
+
+            if(_skipInString)
+            {
+                const char* begin = data + i;
+                const char* quote = static_cast<const char*>(memchr(begin, '"', size - i));
+                const char* limit = 0 != quote ? quote : data + size;
+                const char* backslash = static_cast<const char*>(memchr(begin, '\\', limit - begin));
+
+                if(0 != backslash)
+                {
+                    _skipEscape = true;
+                    i = backslash - data + 1;
+                }
+                else if(0 != quote)
+                {
+                    _skipInString = false;
+                    i = quote - data + 1;
+                }
+                else
+                {
+                    i = size;
+                }
+
+                continue;
+            }
+
+            char c = data[i++];
+
+            if(c == '"')
+            {
+                _skipInString = true;
+            }
+            else if(c == '{' || c == '[')
+            {
+                ++_skipDepth;
+            }
+            else if(c == '}' || c == ']')
+            {
+                if(--_skipDepth == 0)
+                {
+                    _endValue(data, i);
+                    return i;
+                }
+            }
+        }
+
+        return i;
+    }
+
+    void _fail(std::size_t i, const std::string& reason)
+    {
+        char offset[32];
+        snprintf(offset, sizeof(offset), "%llu", static_cast<unsigned long long>(_position + i));
+        _error = "Invalid JSON at byte " + std::string(offset) + ": " + reason + ".";
+        _state = ERROR;
+    }
+
+    const std::vector<std::string>* _find(const std::string& pointer) const
+    {
+        for(std::size_t i = 0; i < _pointers.size(); ++i)
+        {
+            if(_pointers[i].text == pointer) return &_values[i];
+        }
+
+        return 0;
+    }
+
+    std::vector<_Pointer> _pointers;
+    std::vector<std::vector<std::string> > _values;
+    Listener _listener;
+
+    State _state;
+    std::vector<_Frame> _frames;
+    std::vector<_Capture> _captures;
+
+    std::string _string; //< the key or captured string being read
+    bool _isKey;
+    int _escape;         //< 0, 1 after a backslash, 2 to 5 in \uXXXX
+    uint32_t _codeUnit;
+    uint32_t _highSurrogate;
+
+    std::size_t _skipDepth;
+    bool _skipInString;
+    bool _skipEscape;
+
+    uint64_t _position;  //< bytes fed before the current chunk
+    std::string _error;
+
+};
@@ -0,0 +1,161 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#if defined(OFX_OAUTH_HEADLESS)
+
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "Poco/Mutex.h"
+
+
+// A headless stand-in for ofLog, so the core compiles without
+// openFrameworks.  It has the same names and stream interface, and writes
+// to stderr in ofLog's format.  In an app, ofLog itself is used.
+enum ofLogLevel
+{
+    OF_LOG_VERBOSE,
+    OF_LOG_NOTICE,
+    OF_LOG_WARNING,
+    OF_LOG_ERROR,
+    OF_LOG_FATAL_ERROR,
+    OF_LOG_SILENT
+};
+
+
+class ofxOAuthLogMessage
+{
+public:
+    ofxOAuthLogMessage(ofLogLevel level, const std::string& module):
+        _level(level),
+        _module(module)
+    {
+    }
+
+    virtual ~ofxOAuthLogMessage()
+    {
+        if(_level < getLevel()) return;
+
+        static const char* names[] = { "verbose", "notice", "warning", "error", "fatal" };
+
+        Poco::Mutex::ScopedLock lock(getMutex());
+
+        std::cerr << "[" << names[_level] << "] ";
+        if(!_module.empty()) std::cerr << _module << ": ";
+        std::cerr << _message.str() << std::endl;
+    }
+
+    template<typename T> ofxOAuthLogMessage& operator << (const T& value)
+    {
+        _message << value;
+        return *this;
+    }
+
+    ofxOAuthLogMessage& operator << (std::ostream& (*manipulator)(std::ostream&))
+    {
+        _message << manipulator;
+        return *this;
+    }
+
+    static ofLogLevel& getLevel()
+    {
+        static ofLogLevel level = OF_LOG_NOTICE;
+        return level;
+    }
+
+    static Poco::Mutex& getMutex()
+    {
+        static Poco::Mutex mutex;
+        return mutex;
+    }
+
+private:
+    ofLogLevel _level;
+    std::string _module;
+    std::ostringstream _message;
+
+};
+
+
+class ofLogVerbose: public ofxOAuthLogMessage
+{
+public:
+    ofLogVerbose(const std::string& module = ""): ofxOAuthLogMessage(OF_LOG_VERBOSE, module)
+    {
+    }
+};
+
+
+class ofLogNotice: public ofxOAuthLogMessage
+{
+public:
+    ofLogNotice(const std::string& module = ""): ofxOAuthLogMessage(OF_LOG_NOTICE, module)
+    {
+    }
+};
+
+
+class ofLogWarning: public ofxOAuthLogMessage
+{
+public:
+    ofLogWarning(const std::string& module = ""): ofxOAuthLogMessage(OF_LOG_WARNING, module)
+    {
+    }
+};
+
+
+class ofLogError: public ofxOAuthLogMessage
+{
+public:
+    ofLogError(const std::string& module = ""): ofxOAuthLogMessage(OF_LOG_ERROR, module)
+    {
+    }
+};
+
+
+inline void ofSetLogLevel(ofLogLevel level)
+{
+    ofxOAuthLogMessage::getLevel() = level;
+}
+
+
+inline ofLogLevel ofGetLogLevel()
+{
+    return ofxOAuthLogMessage::getLevel();
+}
+
+
+#else
+
+
+#include "ofLog.h"
+
+
+#endif
@@ -0,0 +1,480 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Poco/Mutex.h"
+#include "ofxOAuthHistogram.h"
+#include "ofxOAuthTransport.h"
+
+
+// Request counters and per-stage latency histograms, kept per endpoint
+// (host and path, without the query).  All times are in microseconds.
+//
+// Paths often carry ids (/1.1/statuses/show/123.json), so endpoints are
+// normalized before they are counted: by default numeric path segments
+// become ":id".  Past getMaxEndpoints() distinct endpoints, the rest are
+// counted together as "other", so neither memory nor the number of
+// Prometheus series grows without bound.
+//
+// The transport stages (DNS through TRANSFER, and TOTAL) are taken from
+// curl's own timers; on a reused connection DNS, CONNECT and TLS are 0.
+// SIGN, QUEUE and PARSE are measured by the addon.
+//
+// Counters and histograms are lock-free; only finding an endpoint's entry
+// takes a (short) lock.  If given the transport's circuit breaker, its
+// per-host state, trips and rejections are exported alongside.
+class ofxOAuthMetrics
+{
+public:
+    enum Stage
+    {
+        SIGN = 0,
+        QUEUE,
+        DNS,
+        CONNECT,
+        TLS,
+        TTFB,
+        TRANSFER,
+        PARSE,
+        TOTAL,
+        NUM_STAGES
+    };
+
+    struct EndpointSnapshot
+    {
+        EndpointSnapshot():
+            requests(0),
+            errors(0),
+            bytesReceived(0),
+            bytesDecoded(0)
+        {
+        }
+
+        std::string endpoint;
+        uint64_t requests;
+        uint64_t errors;        //< transport errors and 4xx / 5xx replies
+        uint64_t bytesReceived; //< response bodies, as sent (compressed or not)
+        uint64_t bytesDecoded;  //< response bodies, after content decoding
+        ofxOAuthHistogram::Snapshot stages[NUM_STAGES];
+    };
+
+    // Maps an endpoint ("host/path") to the label it is counted under.
+    typedef std::function<std::string(const std::string& endpoint)> Normalizer;
+
+    enum
+    {
+        DEFAULT_MAX_ENDPOINTS = 256
+    };
+
+    ofxOAuthMetrics():
+        _normalizer(&ofxOAuthMetrics::normalizeIds),
+        _maxEndpoints(DEFAULT_MAX_ENDPOINTS),
+        _circuitBreaker(0)
+    {
+    }
+
+    virtual ~ofxOAuthMetrics()
+    {
+    }
+
+    void record(const std::string& endpoint, Stage stage, uint64_t microseconds)
+    {
+        _get(endpoint)->stages[stage].record(microseconds);
+    }
+
+    // Records a finished transfer.  Requests refused by the circuit breaker
+    // never reached the network and are only counted as errors.
+    void record(const ofxOAuthRequest& request, const ofxOAuthResponse& response)
+    {
+        std::shared_ptr<_Endpoint> endpoint = _get(getEndpoint(request.url));
+
+        endpoint->requests.fetch_add(1, std::memory_order_relaxed);
+
+        if(!response.isComplete() || response.status >= 400)
+        {
+            endpoint->errors.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if(response.isRejected()) return;
+
+        endpoint->bytesReceived.fetch_add(response.wireBytes, std::memory_order_relaxed);
+        endpoint->bytesDecoded.fetch_add(response.decodedBytes, std::memory_order_relaxed);
+
+        const ofxOAuthResponse::Timings& timings = response.timings;
+
+        if(request.queuedAt != 0) endpoint->stages[QUEUE].record(timings.queue);
+
+        endpoint->stages[DNS].record(timings.dns);
+        endpoint->stages[CONNECT].record(timings.connect);
+        endpoint->stages[TLS].record(timings.tls);
+        endpoint->stages[TTFB].record(timings.ttfb);
+        endpoint->stages[TRANSFER].record(timings.transfer);
+        endpoint->stages[TOTAL].record(timings.total);
+    }
+
+    std::vector<EndpointSnapshot> getSnapshot() const
+    {
+        std::vector<std::pair<std::string, std::shared_ptr<_Endpoint> > > endpoints;
+
+        {
+            Poco::Mutex::ScopedLock lock(_mutex);
+            endpoints.assign(_endpoints.begin(), _endpoints.end());
+        }
+
+        std::vector<EndpointSnapshot> snapshot(endpoints.size());
+
+        for(std::size_t i = 0; i < endpoints.size(); ++i)
+        {
+            const _Endpoint& endpoint = *endpoints[i].second;
+
+            snapshot[i].endpoint = endpoints[i].first;
+            snapshot[i].requests = endpoint.requests.load(std::memory_order_relaxed);
+            snapshot[i].errors = endpoint.errors.load(std::memory_order_relaxed);
+            snapshot[i].bytesReceived = endpoint.bytesReceived.load(std::memory_order_relaxed);
+            snapshot[i].bytesDecoded = endpoint.bytesDecoded.load(std::memory_order_relaxed);
+
+            for(std::size_t j = 0; j < NUM_STAGES; ++j)
+            {
+                snapshot[i].stages[j] = endpoint.stages[j].getSnapshot();
+            }
+        }
+
+        return snapshot;
+    }
+
+    // The breaker whose circuits toPrometheus() reports.  It must outlive
+    // the metrics, or be unset (0) first.
+    void setCircuitBreaker(const ofxOAuthCircuitBreaker* circuitBreaker)
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        _circuitBreaker = circuitBreaker;
+    }
+
+    // The Prometheus text exposition format.  Stages are summaries, in
+    // seconds, with the 0.5, 0.9 and 0.99 quantiles.
+    std::string toPrometheus() const
+    {
+        static const double quantiles[] = { 0.5, 0.9, 0.99 };
+
+        std::vector<EndpointSnapshot> snapshot = getSnapshot();
+
+        std::string text;
+
+        text += "# HELP ofxoauth_requests_total Requests sent, per endpoint.\n";
+        text += "# TYPE ofxoauth_requests_total counter\n";
+
+        for(std::size_t i = 0; i < snapshot.size(); ++i)
+        {
+            text += "ofxoauth_requests_total{endpoint=\"" + _escape(snapshot[i].endpoint) + "\"} " + _toString(snapshot[i].requests) + "\n";
+        }
+
+        text += "# HELP ofxoauth_errors_total Transport errors and 4xx / 5xx replies, per endpoint.\n";
+        text += "# TYPE ofxoauth_errors_total counter\n";
+
+        for(std::size_t i = 0; i < snapshot.size(); ++i)
+        {
+            text += "ofxoauth_errors_total{endpoint=\"" + _escape(snapshot[i].endpoint) + "\"} " + _toString(snapshot[i].errors) + "\n";
+        }
+
+        text += "# HELP ofxoauth_received_bytes_total Response body bytes as sent, compressed or not, per endpoint.\n";
+        text += "# TYPE ofxoauth_received_bytes_total counter\n";
+
+        for(std::size_t i = 0; i < snapshot.size(); ++i)
+        {
+            text += "ofxoauth_received_bytes_total{endpoint=\"" + _escape(snapshot[i].endpoint) + "\"} " + _toString(snapshot[i].bytesReceived) + "\n";
+        }
+
+        text += "# HELP ofxoauth_decoded_bytes_total Response body bytes after content decoding, per endpoint.\n";
+        text += "# TYPE ofxoauth_decoded_bytes_total counter\n";
+
+        for(std::size_t i = 0; i < snapshot.size(); ++i)
+        {
+            text += "ofxoauth_decoded_bytes_total{endpoint=\"" + _escape(snapshot[i].endpoint) + "\"} " + _toString(snapshot[i].bytesDecoded) + "\n";
+        }
+
+        text += "# HELP ofxoauth_stage_seconds Time spent per request stage, per endpoint.\n";
+        text += "# TYPE ofxoauth_stage_seconds summary\n";
+
+        for(std::size_t i = 0; i < snapshot.size(); ++i)
+        {
+            for(std::size_t j = 0; j < NUM_STAGES; ++j)
+            {
+                const ofxOAuthHistogram::Snapshot& stage = snapshot[i].stages[j];
+
+                if(stage.count == 0) continue;
+
+                std::string labels = "endpoint=\"" + _escape(snapshot[i].endpoint) + "\",stage=\"" + toString(static_cast<Stage>(j)) + "\"";
+
+                for(std::size_t k = 0; k < sizeof(quantiles) / sizeof(quantiles[0]); ++k)
+                {
+                    text += "ofxoauth_stage_seconds{" + labels + ",quantile=\"" + _toString(quantiles[k]) + "\"} " + _toSeconds(stage.getPercentile(quantiles[k])) + "\n";
+                }
+
+                text += "ofxoauth_stage_seconds_sum{" + labels + "} " + _toSeconds(stage.sum) + "\n";
+                text += "ofxoauth_stage_seconds_count{" + labels + "} " + _toString(stage.count) + "\n";
+            }
+        }
+
+        std::vector<ofxOAuthCircuitBreaker::Stats> circuits;
+
+        {
+            Poco::Mutex::ScopedLock lock(_mutex);
+            if(0 != _circuitBreaker) circuits = _circuitBreaker->getStats();
+        }
+
+        if(circuits.empty()) return text;
+
+        text += "# HELP ofxoauth_circuit_state Circuit breaker state, per host: 0 closed, 1 open, 2 half-open.\n";
+        text += "# TYPE ofxoauth_circuit_state gauge\n";
+
+        for(std::size_t i = 0; i < circuits.size(); ++i)
+        {
+            text += "ofxoauth_circuit_state{host=\"" + _escape(circuits[i].host) + "\"} " + _toString(static_cast<uint64_t>(circuits[i].state)) + "\n";
+        }
+
+        text += "# HELP ofxoauth_circuit_trips_total Times the circuit opened, per host.\n";
+        text += "# TYPE ofxoauth_circuit_trips_total counter\n";
+
+        for(std::size_t i = 0; i < circuits.size(); ++i)
+        {
+            text += "ofxoauth_circuit_trips_total{host=\"" + _escape(circuits[i].host) + "\"} " + _toString(static_cast<uint64_t>(circuits[i].trips)) + "\n";
+        }
+
+        text += "# HELP ofxoauth_circuit_rejected_total Requests refused by an open circuit, per host.\n";
+        text += "# TYPE ofxoauth_circuit_rejected_total counter\n";
+
+        for(std::size_t i = 0; i < circuits.size(); ++i)
+        {
+            text += "ofxoauth_circuit_rejected_total{host=\"" + _escape(circuits[i].host) + "\"} " + _toString(static_cast<uint64_t>(circuits[i].rejected)) + "\n";
+        }
+
+        return text;
+    }
+
+    void reset()
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        _endpoints.clear();
+    }
+
+    // Must be set before the metrics are shared between threads.  An empty
+    // normalizer counts endpoints as they are.
+    void setNormalizer(Normalizer normalizer)
+    {
+        _normalizer = normalizer;
+    }
+
+    void setMaxEndpoints(std::size_t maxEndpoints)
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        _maxEndpoints = maxEndpoints;
+    }
+
+    std::size_t getMaxEndpoints() const
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        return _maxEndpoints;
+    }
+
+    // The default normalizer: path segments that are a number, with or
+    // without an extension, become ":id" (/statuses/show/123.json becomes
+    // /statuses/show/:id.json).
+    static std::string normalizeIds(const std::string& endpoint)
+    {
+        std::string result;
+        result.reserve(endpoint.size());
+
+        std::string::size_type begin = 0;
+
+        while(begin <= endpoint.size())
+        {
+            std::string::size_type end = endpoint.find('/', begin);
+
+            if(end == std::string::npos) end = endpoint.size();
+
+            std::string::size_type stem = begin;
+
+            while(stem < end && isdigit(static_cast<unsigned char>(endpoint[stem]))) ++stem;
+
+            // an extension is letters only, so a version like 1.1 is kept.
+            std::string::size_type extension = stem + 1;
+
+            while(extension < end && isalpha(static_cast<unsigned char>(endpoint[extension]))) ++extension;
+
+            bool isId = stem > begin && (stem == end || (endpoint[stem] == '.' && extension == end && extension > stem + 1));
+
+            // the host is never a path segment.
+            if(begin > 0 && isId)
+            {
+                result += ":id";
+                result.append(endpoint, stem, end - stem);
+            }
+            else
+            {
+                result.append(endpoint, begin, end - begin);
+            }
+
+            if(end < endpoint.size()) result += '/';
+
+            begin = end + 1;
+        }
+
+        return result;
+    }
+
+    static std::string toString(Stage stage)
+    {
+        switch(stage)
+        {
+            case SIGN:
+                return "sign";
+            case QUEUE:
+                return "queue";
+            case DNS:
+                return "dns";
+            case CONNECT:
+                return "connect";
+            case TLS:
+                return "tls";
+            case TTFB:
+                return "ttfb";
+            case TRANSFER:
+                return "transfer";
+            case PARSE:
+                return "parse";
+            default:
+                return "total";
+        }
+    }
+
+    // "host/path" of an absolute url; the query and fragment are dropped.
+    static std::string getEndpoint(const std::string& url)
+    {
+        std::string::size_type begin = url.find("://");
+
+        begin = (begin == std::string::npos) ? 0 : begin + 3;
+
+        std::string::size_type end = url.find_first_of("?#", begin);
+
+        return url.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+    }
+
+protected:
+    struct _Endpoint
+    {
+        _Endpoint():
+            requests(0),
+            errors(0),
+            bytesReceived(0),
+            bytesDecoded(0)
+        {
+        }
+
+        std::atomic<uint64_t> requests;
+        std::atomic<uint64_t> errors;
+        std::atomic<uint64_t> bytesReceived;
+        std::atomic<uint64_t> bytesDecoded;
+        ofxOAuthHistogram stages[NUM_STAGES];
+    };
+
+    std::shared_ptr<_Endpoint> _get(const std::string& endpoint)
+    {
+        std::string label = _normalizer ? _normalizer(endpoint) : endpoint;
+
+        Poco::Mutex::ScopedLock lock(_mutex);
+
+        std::map<std::string, std::shared_ptr<_Endpoint> >::iterator iter = _endpoints.find(label);
+
+        if(iter != _endpoints.end()) return iter->second;
+
+        if(_endpoints.size() >= _maxEndpoints) label = "other";
+
+        std::shared_ptr<_Endpoint>& entry = _endpoints[label];
+
+        if(!entry) entry = std::make_shared<_Endpoint>();
+
+        return entry;
+    }
+
+    static std::string _escape(const std::string& value)
+    {
+        std::string escaped;
+
+        for(std::size_t i = 0; i < value.size(); ++i)
+        {
+            if(value[i] == '\\' || value[i] == '"') escaped += '\\';
+            if(value[i] == '\n')
+            {
+                escaped += "\\n";
+                continue;
+            }
+            escaped += value[i];
+        }
+
+        return escaped;
+    }
+
+    static std::string _toString(uint64_t value)
+    {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%llu", static_cast<unsigned long long>(value));
+        return buffer;
+    }
+
+    static std::string _toString(double value)
+    {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%g", value);
+        return buffer;
+    }
+
+    static std::string _toSeconds(uint64_t microseconds)
+    {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%.6f", microseconds / 1000000.0);
+        return buffer;
+    }
+
+    std::map<std::string, std::shared_ptr<_Endpoint> > _endpoints;
+
+    Normalizer _normalizer;
+    std::size_t _maxEndpoints; //< beyond which endpoints count as "other"
+    const ofxOAuthCircuitBreaker* _circuitBreaker;
+
+    mutable Poco::Mutex _mutex;
+
+};
@@ -0,0 +1,185 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include <memory>
+#include <string>
+#include "Poco/Exception.h"
+#include "Poco/ThreadPool.h"
+#include "Poco/URI.h"
+#include "Poco/Net/HTTPRequestHandler.h"
+#include "Poco/Net/HTTPRequestHandlerFactory.h"
+#include "Poco/Net/HTTPServer.h"
+#include "Poco/Net/HTTPServerParams.h"
+#include "Poco/Net/HTTPServerRequest.h"
+#include "Poco/Net/HTTPServerResponse.h"
+#include "Poco/Net/ServerSocket.h"
+#include "Poco/Net/SocketAddress.h"
+#include "ofxOAuthLog.h"
+#include "ofxOAuthMetrics.h"
+
+
+class ofxOAuthMetricsRequestHandler: public Poco::Net::HTTPRequestHandler
+{
+public:
+    ofxOAuthMetricsRequestHandler(const ofxOAuthMetrics& metrics):
+        _metrics(metrics)
+    {
+    }
+
+    virtual ~ofxOAuthMetricsRequestHandler()
+    {
+    }
+
+    void handleRequest(Poco::Net::HTTPServerRequest& request,
+                       Poco::Net::HTTPServerResponse& response)
+    {
+        std::string path = Poco::URI(request.getURI()).getPath();
+
+        std::string body;
+
+        if(path == "/metrics" || path == "/")
+        {
+            body = _metrics.toPrometheus();
+            response.setContentType("text/plain; version=0.0.4");
+        }
+        else
+        {
+            body = "Not found.\n";
+            response.setStatusAndReason(Poco::Net::HTTPResponse::HTTP_NOT_FOUND);
+            response.setContentType("text/plain");
+        }
+
+        response.setContentLength(static_cast<long>(body.size()));
+        response.send() << body;
+    }
+
+protected:
+    const ofxOAuthMetrics& _metrics;
+
+};
+
+
+class ofxOAuthMetricsRequestHandlerFactory: public Poco::Net::HTTPRequestHandlerFactory
+{
+public:
+    ofxOAuthMetricsRequestHandlerFactory(const ofxOAuthMetrics& metrics):
+        _metrics(metrics)
+    {
+    }
+
+    Poco::Net::HTTPRequestHandler* createRequestHandler(const Poco::Net::HTTPServerRequest&)
+    {
+        return new ofxOAuthMetricsRequestHandler(_metrics);
+    }
+
+protected:
+    const ofxOAuthMetrics& _metrics;
+
+};
+
+
+// Serves ofxOAuthMetrics as Prometheus text at http://127.0.0.1:port/metrics.
+// It only listens on the loopback interface.  The metrics must outlive the
+// server.
+class ofxOAuthMetricsServer
+{
+public:
+    ofxOAuthMetricsServer(const ofxOAuthMetrics& metrics, int port = 9464):
+        _metrics(metrics),
+        _port(port),
+        _pool(1, 2)
+    {
+    }
+
+    virtual ~ofxOAuthMetricsServer()
+    {
+        stop();
+    }
+
+    bool start()
+    {
+        if(_server) return true;
+
+        try
+        {
+            Poco::Net::ServerSocket socket(Poco::Net::SocketAddress("127.0.0.1", static_cast<unsigned short>(_port)));
+
+            Poco::Net::HTTPServerParams* params = new Poco::Net::HTTPServerParams();
+            params->setMaxThreads(2);
+            params->setServerName("ofxOAuthMetricsServer/1.0");
+
+            _server.reset(new Poco::Net::HTTPServer(new ofxOAuthMetricsRequestHandlerFactory(_metrics),
+                                                    _pool,
+                                                    socket,
+                                                    params));
+            _server->start();
+        }
+        catch(const Poco::Exception& exc)
+        {
+            ofLogError("ofxOAuthMetricsServer::start") << "Unable to listen on " << getURL() << " : " << exc.displayText();
+            _server.reset();
+            return false;
+        }
+
+        ofLogVerbose("ofxOAuthMetricsServer::start") << "Serving metrics @ " << getURL();
+
+        return true;
+    }
+
+    void stop()
+    {
+        if(!_server) return;
+
+        _server->stop();
+        _server.reset();
+        _pool.joinAll();
+    }
+
+    bool isRunning() const
+    {
+        return 0 != _server.get();
+    }
+
+    std::string getURL() const
+    {
+        return "http://127.0.0.1:" + std::to_string(_port) + "/metrics";
+    }
+
+    int getPort() const
+    {
+        return _port;
+    }
+
+protected:
+    const ofxOAuthMetrics& _metrics;
+    int _port;
+    Poco::ThreadPool _pool;
+    std::shared_ptr<Poco::Net::HTTPServer> _server;
+
+};
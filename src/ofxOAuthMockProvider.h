@@ -0,0 +1,788 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <oauth.h>
+#include "Poco/DateTimeFormat.h"
+#include "Poco/DateTimeFormatter.h"
+#include "Poco/Exception.h"
+#include "Poco/Mutex.h"
+#include "Poco/String.h"
+#include "Poco/Thread.h"
+#include "Poco/ThreadPool.h"
+#include "Poco/Timestamp.h"
+#include "Poco/URI.h"
+#include "Poco/Net/HTTPRequestHandler.h"
+#include "Poco/Net/HTTPRequestHandlerFactory.h"
+#include "Poco/Net/HTTPServer.h"
+#include "Poco/Net/HTTPServerParams.h"
+#include "Poco/Net/HTTPServerRequest.h"
+#include "Poco/Net/HTTPServerResponse.h"
+#include "Poco/Net/ServerSocket.h"
+#include "Poco/Net/SocketAddress.h"
+#include "ofxOAuthFormDecoder.h"
+
+
+// A local stand-in for an OAuth 1.0a provider, for end-to-end and load
+// tests that should not touch a real API.  It listens on 127.0.0.1 and
+// implements the whole flow:
+//
+//      GET /oauth/request_token    signed with the consumer only
+//      GET /oauth/authorize        approves at once; the verifier is in the
+//                                  body and, unless the callback is "oob",
+//                                  in a redirect to the callback
+//      GET /oauth/access_token     signed with the request token + verifier
+//      anything else               signed with an access token; answered
+//                                  with a body of responseSize bytes after
+//                                  latency (+ up to latencyJitter) ms
+//
+// Signatures (HMAC-SHA1 and PLAINTEXT), timestamps and nonces are checked
+// like a strict provider would, and failures are answered with a 401 and
+// an oauth_problem.  A signed request can override the response with
+// mock_size=<bytes> and mock_latency=<ms> parameters.
+//
+//      ofxOAuthMockProvider provider;
+//      provider.start();
+//      oauth.setup(provider.getURL(),
+//                  provider.getRequestTokenURL(),
+//                  provider.getAccessTokenURL(),
+//                  provider.getAuthorizationURL(),
+//                  provider.getSettings().consumerKey,
+//                  provider.getSettings().consumerSecret);
+//
+class ofxOAuthMockProvider
+{
+public:
+    typedef std::vector<std::pair<std::string, std::string> > Parameters;
+
+    struct Settings
+    {
+        Settings():
+            port(8999),
+            consumerKey("mock-consumer-key"),
+            consumerSecret("mock-consumer-secret"),
+            latency(0),
+            latencyJitter(0),
+            responseSize(1024),
+            timestampWindow(300),
+            maxThreads(32)
+        {
+        }
+
+        int port;
+        std::string consumerKey;
+        std::string consumerSecret;
+        long latency;             //< milliseconds before a resource is answered
+        long latencyJitter;       //< up to this many more milliseconds, at random
+        std::size_t responseSize; //< bytes of a resource body
+        long timestampWindow;     //< seconds a timestamp may be off
+        int maxThreads;           //< requests served at once
+    };
+
+    struct Stats
+    {
+        Stats():
+            requests(0),
+            requestTokens(0),
+            accessTokens(0),
+            resources(0),
+            rejected(0)
+        {
+        }
+
+        unsigned long long requests;
+        unsigned long long requestTokens; //< issued
+        unsigned long long accessTokens;  //< issued
+        unsigned long long resources;     //< signed resource requests served
+        unsigned long long rejected;      //< answered with an oauth_problem
+        std::map<std::string, unsigned long long> problems; //< by oauth_problem
+    };
+
+    ofxOAuthMockProvider(const Settings& settings = Settings()):
+        _settings(settings),
+        _random(std::random_device()()),
+        _serial(0)
+    {
+    }
+
+    virtual ~ofxOAuthMockProvider()
+    {
+        stop();
+    }
+
+    // Call before start().
+    void setSettings(const Settings& settings)
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        _settings = settings;
+    }
+
+    Settings getSettings() const
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        return _settings;
+    }
+
+    Stats getStats() const
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        return _stats;
+    }
+
+    bool start()
+    {
+        if(_server) return true;
+
+        Settings settings = getSettings();
+
+        try
+        {
+            Poco::Net::ServerSocket socket(Poco::Net::SocketAddress("127.0.0.1", static_cast<unsigned short>(settings.port)));
+
+            Poco::Net::HTTPServerParams* params = new Poco::Net::HTTPServerParams();
+            params->setMaxThreads(settings.maxThreads);
+            params->setMaxQueued(settings.maxThreads * 16);
+            params->setServerName("ofxOAuthMockProvider/1.0");
+
+            _pool.reset(new Poco::ThreadPool(2, settings.maxThreads));
+            _server.reset(new Poco::Net::HTTPServer(new _HandlerFactory(*this), *_pool, socket, params));
+            _server->start();
+        }
+        catch(const Poco::Exception&)
+        {
+            _server.reset();
+            _pool.reset();
+            return false;
+        }
+
+        return true;
+    }
+
+    void stop()
+    {
+        if(!_server) return;
+
+        _server->stop();
+        _server.reset();
+        _pool->joinAll();
+        _pool.reset();
+    }
+
+    bool isRunning() const
+    {
+        return 0 != _server.get();
+    }
+
+    std::string getURL() const
+    {
+        std::ostringstream url;
+        url << "http://127.0.0.1:" << getSettings().port;
+        return url.str();
+    }
+
+    std::string getRequestTokenURL() const
+    {
+        return getURL() + "/oauth/request_token";
+    }
+
+    std::string getAccessTokenURL() const
+    {
+        return getURL() + "/oauth/access_token";
+    }
+
+    // ofxOAuth appends "oauth_token=...".
+    std::string getAuthorizationURL() const
+    {
+        return getURL() + "/oauth/authorize?";
+    }
+
+    // Approves a request token, as a user would on the authorization page,
+    // and returns its verifier (empty if the token is unknown).  Lets an
+    // in-process client skip the browser round trip.
+    std::string authorize(const std::string& requestToken)
+    {
+        std::string callback;
+        return authorize(requestToken, callback);
+    }
+
+    std::string authorize(const std::string& requestToken, std::string& callback)
+    {
+        std::string verifier = _generate("v", 16);
+
+        Poco::Mutex::ScopedLock lock(_mutex);
+
+        std::map<std::string, _Token>::iterator iter = _requestTokens.find(requestToken);
+
+        if(iter == _requestTokens.end()) return "";
+
+        iter->second.verifier = verifier;
+        callback = iter->second.callback;
+
+        return verifier;
+    }
+
+    // The signature base string (RFC 5849, 3.4.1).  baseURL is the scheme,
+    // authority and path; parameters are decoded and include everything
+    // but oauth_signature and realm.
+    static std::string getSignatureBaseString(const std::string& method,
+                                              const std::string& baseURL,
+                                              const Parameters& parameters)
+    {
+        std::vector<std::string> encoded;
+
+        for(std::size_t i = 0; i < parameters.size(); ++i)
+        {
+            encoded.push_back(_escape(parameters[i].first) + "=" + _escape(parameters[i].second));
+        }
+
+        // sorting "key=value" strings sorts by key, then value, since '='
+        // sorts before every unreserved character.
+        std::sort(encoded.begin(), encoded.end());
+
+        std::string normalized;
+
+        for(std::size_t i = 0; i < encoded.size(); ++i)
+        {
+            if(i > 0) normalized += "&";
+            normalized += encoded[i];
+        }
+
+        return Poco::toUpper(method) + "&" + _escape(baseURL) + "&" + _escape(normalized);
+    }
+
+    // Returns an empty string if the signature is valid, otherwise the
+    // oauth_problem to report.
+    static std::string verifySignature(const std::string& method,
+                                       const std::string& baseURL,
+                                       const Parameters& parameters,
+                                       const std::string& consumerSecret,
+                                       const std::string& tokenSecret)
+    {
+        std::string signature;
+        std::string signatureMethod;
+        Parameters signedParameters;
+
+        for(std::size_t i = 0; i < parameters.size(); ++i)
+        {
+            if(parameters[i].first == "oauth_signature")
+            {
+                signature = parameters[i].second;
+            }
+            else if(parameters[i].first != "realm")
+            {
+                if(parameters[i].first == "oauth_signature_method") signatureMethod = parameters[i].second;
+                signedParameters.push_back(parameters[i]);
+            }
+        }
+
+        if(signature.empty()) return "parameter_absent";
+
+        std::string key = _escape(consumerSecret) + "&" + _escape(tokenSecret);
+        std::string expected;
+
+        if(signatureMethod == "HMAC-SHA1")
+        {
+            std::string base = getSignatureBaseString(method, baseURL, signedParameters);
+            char* p = oauth_sign_hmac_sha1(base.c_str(), key.c_str());
+            if(0 != p)
+            {
+                expected = p;
+                free(p);
+            }
+        }
+        else if(signatureMethod == "PLAINTEXT")
+        {
+            expected = key;
+        }
+        else
+        {
+            return "signature_method_rejected";
+        }
+
+        if(expected.empty() || 0 == oauth_time_independent_equals(expected.c_str(), signature.c_str()))
+        {
+            return "signature_invalid";
+        }
+
+        return "";
+    }
+
+    // Collects the decoded parameters of an Authorization: OAuth header.
+    static void parseAuthorizationHeader(const std::string& header, Parameters& parameters)
+    {
+        if(Poco::icompare(header.substr(0, 6), "OAuth ") != 0) return;
+
+        std::string::size_type position = 6;
+
+        while(position < header.size())
+        {
+            std::string::size_type equals = header.find('=', position);
+
+            if(equals == std::string::npos) break;
+
+            std::string name = Poco::trim(header.substr(position, equals - position));
+            std::string value;
+
+            std::string::size_type end = 0;
+
+            if(equals + 1 < header.size() && header[equals + 1] == '"')
+            {
+                end = header.find('"', equals + 2);
+                if(end == std::string::npos) end = header.size();
+                value = header.substr(equals + 2, end - (equals + 2));
+                end = header.find(',', end);
+            }
+            else
+            {
+                end = header.find(',', equals);
+                value = Poco::trim(header.substr(equals + 1, end == std::string::npos ? std::string::npos : end - (equals + 1)));
+            }
+
+            parameters.push_back(std::make_pair(name, _unescape(value)));
+
+            if(end == std::string::npos) break;
+
+            position = end + 1;
+        }
+    }
+
+    // Collects the decoded parameters of a query string or form body.
+    static void parseForm(const std::string& form, Parameters& parameters)
+    {
+        std::string buffer = form; // decoded in place
+        ofxOAuthFormDecoder decoder(buffer);
+        ofxOAuthFormDecoder::Field field;
+
+        while(decoder.next(field))
+        {
+            parameters.push_back(std::make_pair(field.key.str(), field.value.str()));
+        }
+    }
+
+protected:
+    struct _Token
+    {
+        std::string secret;
+        std::string callback;
+        std::string verifier;
+        unsigned long long userId;
+    };
+
+    class _Handler: public Poco::Net::HTTPRequestHandler
+    {
+    public:
+        _Handler(ofxOAuthMockProvider& provider): _provider(provider)
+        {
+        }
+
+        void handleRequest(Poco::Net::HTTPServerRequest& request,
+                           Poco::Net::HTTPServerResponse& response)
+        {
+            _provider._handle(request, response);
+        }
+
+    protected:
+        ofxOAuthMockProvider& _provider;
+
+    };
+
+    class _HandlerFactory: public Poco::Net::HTTPRequestHandlerFactory
+    {
+    public:
+        _HandlerFactory(ofxOAuthMockProvider& provider): _provider(provider)
+        {
+        }
+
+        Poco::Net::HTTPRequestHandler* createRequestHandler(const Poco::Net::HTTPServerRequest&)
+        {
+            return new _Handler(_provider);
+        }
+
+    protected:
+        ofxOAuthMockProvider& _provider;
+
+    };
+
+    void _handle(Poco::Net::HTTPServerRequest& request,
+                 Poco::Net::HTTPServerResponse& response)
+    {
+        Settings settings = getSettings();
+
+        {
+            Poco::Mutex::ScopedLock lock(_mutex);
+            ++_stats.requests;
+        }
+
+        Poco::URI uri(request.getURI());
+        std::string path = uri.getPath();
+
+        Parameters parameters;
+        parseAuthorizationHeader(request.get("Authorization", ""), parameters);
+        parseForm(uri.getRawQuery(), parameters);
+
+        if(Poco::icompare(request.getContentType().substr(0, 33), "application/x-www-form-urlencoded") == 0)
+        {
+            std::string body;
+            char buffer[4096];
+
+            while(request.stream().read(buffer, sizeof(buffer)) || request.stream().gcount() > 0)
+            {
+                body.append(buffer, static_cast<std::size_t>(request.stream().gcount()));
+            }
+
+            parseForm(body, parameters);
+        }
+
+        std::string baseURL = "http://" + Poco::toLower(request.getHost()) + path;
+
+        // the clock of a provider is what clients have to match.
+        response.set("Date", Poco::DateTimeFormatter::format(Poco::Timestamp(), Poco::DateTimeFormat::HTTP_FORMAT));
+
+        if(path == "/oauth/authorize")
+        {
+            _authorize(parameters, response);
+            return;
+        }
+
+        std::string token = _get(parameters, "oauth_token");
+        std::string problem = _checkProtocol(settings, parameters);
+
+        if(problem.empty())
+        {
+            if(path == "/oauth/request_token")
+            {
+                problem = verifySignature(request.getMethod(), baseURL, parameters, settings.consumerSecret, "");
+
+                if(problem.empty())
+                {
+                    _sendForm(response, _issueRequestToken(_get(parameters, "oauth_callback")));
+                    return;
+                }
+            }
+            else if(path == "/oauth/access_token")
+            {
+                _Token requestToken;
+
+                if(!_findToken(_requestTokens, token, requestToken))
+                {
+                    problem = "token_rejected";
+                }
+                else if(requestToken.verifier.empty() || requestToken.verifier != _get(parameters, "oauth_verifier"))
+                {
+                    problem = "permission_denied";
+                }
+                else
+                {
+                    problem = verifySignature(request.getMethod(), baseURL, parameters, settings.consumerSecret, requestToken.secret);
+                }
+
+                if(problem.empty())
+                {
+                    _sendForm(response, _issueAccessToken(token));
+                    return;
+                }
+            }
+            else
+            {
+                _Token accessToken;
+
+                if(!_findToken(_accessTokens, token, accessToken))
+                {
+                    problem = "token_rejected";
+                }
+                else
+                {
+                    problem = verifySignature(request.getMethod(), baseURL, parameters, settings.consumerSecret, accessToken.secret);
+                }
+
+                if(problem.empty())
+                {
+                    _serveResource(settings, parameters, accessToken, response);
+                    return;
+                }
+            }
+        }
+
+        _reject(response, problem);
+    }
+
+    // Consumer key, timestamp and nonce, shared by every signed endpoint.
+    std::string _checkProtocol(const Settings& settings, const Parameters& parameters)
+    {
+        if(_get(parameters, "oauth_consumer_key") != settings.consumerKey) return "consumer_key_unknown";
+
+        std::string version = _get(parameters, "oauth_version");
+
+        if(!version.empty() && version != "1.0") return "version_rejected";
+
+        std::string timestamp = _get(parameters, "oauth_timestamp");
+        std::string nonce = _get(parameters, "oauth_nonce");
+
+        if(timestamp.empty() || nonce.empty()) return "parameter_absent";
+
+        long long seconds = atoll(timestamp.c_str());
+        long long now = static_cast<long long>(time(0));
+
+        if(seconds < now - settings.timestampWindow || seconds > now + settings.timestampWindow)
+        {
+            return "timestamp_refused";
+        }
+
+        Poco::Mutex::ScopedLock lock(_mutex);
+
+        // forget nonces whose timestamps can no longer be accepted.
+        std::map<long long, std::set<std::string> >::iterator expired = _nonces.lower_bound(now - settings.timestampWindow);
+        _nonces.erase(_nonces.begin(), expired);
+
+        if(!_nonces[seconds].insert(settings.consumerKey + "&" + _get(parameters, "oauth_token") + "&" + nonce).second)
+        {
+            return "nonce_used";
+        }
+
+        return "";
+    }
+
+    void _authorize(const Parameters& parameters, Poco::Net::HTTPServerResponse& response)
+    {
+        std::string token = _get(parameters, "oauth_token");
+        std::string callback;
+        std::string verifier = authorize(token, callback);
+
+        if(verifier.empty())
+        {
+            _reject(response, "token_rejected");
+            return;
+        }
+
+        std::string form = "oauth_token=" + _escape(token) + "&oauth_verifier=" + _escape(verifier);
+
+        if(!callback.empty() && callback != "oob")
+        {
+            response.set("Location", callback + (callback.find('?') == std::string::npos ? "?" : "&") + form);
+            response.setStatusAndReason(Poco::Net::HTTPResponse::HTTP_FOUND);
+        }
+
+        _send(response, "application/x-www-form-urlencoded", form);
+    }
+
+    std::string _issueRequestToken(const std::string& callback)
+    {
+        _Token token;
+        token.secret = _generate("rs", 32);
+        token.callback = callback;
+        token.userId = 0;
+
+        std::string key = _generate("rt", 24);
+
+        Poco::Mutex::ScopedLock lock(_mutex);
+
+        _requestTokens[key] = token;
+        ++_stats.requestTokens;
+
+        return "oauth_token=" + key + "&oauth_token_secret=" + token.secret + "&oauth_callback_confirmed=true";
+    }
+
+    std::string _issueAccessToken(const std::string& requestToken)
+    {
+        _Token token;
+        token.secret = _generate("as", 32);
+        token.userId = 0;
+
+        std::string key = _generate("at", 24);
+
+        Poco::Mutex::ScopedLock lock(_mutex);
+
+        // a request token is exchanged once.
+        _requestTokens.erase(requestToken);
+
+        token.userId = ++_serial;
+        _accessTokens[key] = token;
+        ++_stats.accessTokens;
+
+        std::ostringstream form;
+        form << "oauth_token=" << key << "&oauth_token_secret=" << token.secret;
+        form << "&user_id=" << token.userId << "&screen_name=mock_user_" << token.userId;
+
+        return form.str();
+    }
+
+    void _serveResource(const Settings& settings,
+                        const Parameters& parameters,
+                        const _Token& token,
+                        Poco::Net::HTTPServerResponse& response)
+    {
+        std::string size = _get(parameters, "mock_size");
+        std::string latency = _get(parameters, "mock_latency");
+
+        std::size_t responseSize = size.empty() ? settings.responseSize : static_cast<std::size_t>(atol(size.c_str()));
+        long delay = latency.empty() ? settings.latency : atol(latency.c_str());
+
+        if(settings.latencyJitter > 0)
+        {
+            Poco::Mutex::ScopedLock lock(_mutex);
+            delay += std::uniform_int_distribution<long>(0, settings.latencyJitter)(_random);
+        }
+
+        if(delay > 0) Poco::Thread::sleep(delay);
+
+        std::ostringstream head;
+        head << "{\"user_id\":" << token.userId << ",\"data\":\"";
+
+        std::string body = head.str();
+        std::string tail = "\"}";
+
+        if(responseSize > body.size() + tail.size())
+        {
+            body.append(responseSize - body.size() - tail.size(), 'x');
+        }
+
+        body += tail;
+
+        {
+            Poco::Mutex::ScopedLock lock(_mutex);
+            ++_stats.resources;
+        }
+
+        _send(response, "application/json", body);
+    }
+
+    void _reject(Poco::Net::HTTPServerResponse& response, const std::string& problem)
+    {
+        {
+            Poco::Mutex::ScopedLock lock(_mutex);
+            ++_stats.rejected;
+            ++_stats.problems[problem];
+        }
+
+        response.setStatusAndReason(Poco::Net::HTTPResponse::HTTP_UNAUTHORIZED);
+        response.set("WWW-Authenticate", "OAuth realm=\"ofxOAuthMockProvider\", oauth_problem=\"" + problem + "\"");
+
+        _send(response, "application/x-www-form-urlencoded", "oauth_problem=" + problem);
+    }
+
+    void _sendForm(Poco::Net::HTTPServerResponse& response, const std::string& form)
+    {
+        _send(response, "application/x-www-form-urlencoded", form);
+    }
+
+    static void _send(Poco::Net::HTTPServerResponse& response,
+                      const std::string& contentType,
+                      const std::string& body)
+    {
+        response.setContentType(contentType);
+        response.setContentLength(static_cast<long>(body.size()));
+        response.send() << body;
+    }
+
+    bool _findToken(const std::map<std::string, _Token>& tokens, const std::string& key, _Token& token) const
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+
+        std::map<std::string, _Token>::const_iterator iter = tokens.find(key);
+
+        if(iter == tokens.end()) return false;
+
+        token = iter->second;
+
+        return true;
+    }
+
+    std::string _generate(const std::string& prefix, std::size_t length)
+    {
+        static const char alphabet[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+
+        Poco::Mutex::ScopedLock lock(_mutex);
+
+        std::uniform_int_distribution<std::size_t> distribution(0, sizeof(alphabet) - 2);
+
+        std::string value = prefix + "-";
+
+        for(std::size_t i = 0; i < length; ++i)
+        {
+            value += alphabet[distribution(_random)];
+        }
+
+        return value;
+    }
+
+    static std::string _get(const Parameters& parameters, const std::string& name)
+    {
+        for(std::size_t i = 0; i < parameters.size(); ++i)
+        {
+            if(parameters[i].first == name) return parameters[i].second;
+        }
+
+        return "";
+    }
+
+    static std::string _escape(const std::string& value)
+    {
+        char* p = oauth_url_escape(value.c_str());
+        std::string escaped = p ? p : "";
+        free(p);
+        return escaped;
+    }
+
+    static std::string _unescape(const std::string& value)
+    {
+        char* p = oauth_url_unescape(value.c_str(), 0);
+        std::string unescaped = p ? p : "";
+        free(p);
+        return unescaped;
+    }
+
+    Settings _settings;
+    Stats _stats;
+
+    std::map<std::string, _Token> _requestTokens;
+    std::map<std::string, _Token> _accessTokens;
+    std::map<long long, std::set<std::string> > _nonces; //< by timestamp
+
+    std::mt19937 _random;
+    unsigned long long _serial;
+
+    std::shared_ptr<Poco::ThreadPool> _pool;
+    std::shared_ptr<Poco::Net::HTTPServer> _server;
+
+    mutable Poco::Mutex _mutex;
+
+};
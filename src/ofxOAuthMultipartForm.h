@@ -0,0 +1,264 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <curl/curl.h>
+#include "ofxOAuthFormDecoder.h"
+#include "ofxOAuthUploadSource.h"
+// the form API older curls have was deprecated by the mime API in 7.56.0.
+#if LIBCURL_VERSION_NUM >= 0x073800
+#define OFX_OAUTH_HAS_CURL_MIME 1
+#endif
+
+
+// The parts of a multipart/form-data request.  Any number of plain fields
+// and file fields can be added; file fields are streamed to curl either from
+// a memory-mapped file or straight from a caller-owned buffer, so nothing is
+// written to a temporary file and nothing is copied.
+//
+//      ofxOAuthMultipartForm form;
+//      form.addField("status", "Hello");
+//      form.addBuffer("media[]", jpeg.getBinaryBuffer(), jpeg.size(), "frame.jpg", "image/jpeg");
+//      form.addFile("media[]", ofToDataPath("logo.png", true));
+//
+// Buffers are not copied and must outlive the request.
+class ofxOAuthMultipartForm
+{
+public:
+    ofxOAuthMultipartForm()
+    {
+    }
+
+    virtual ~ofxOAuthMultipartForm()
+    {
+    }
+
+    void addField(const std::string& name, const std::string& value)
+    {
+        Part part;
+        part.name = name;
+        part.value = value;
+        _parts.push_back(part);
+    }
+
+    // Adds every pair of an a=b&c=d query string as a plain field.  Values
+    // are percent-decoded, since multipart fields are sent verbatim.
+    void addFields(const std::string& query)
+    {
+        std::string buffer = query; // decoded in place
+        ofxOAuthFormDecoder decoder(buffer);
+        ofxOAuthFormDecoder::Field field;
+
+        while(decoder.next(field))
+        {
+            addField(field.key.str(), field.value.str());
+        }
+    }
+
+    bool addFile(const std::string& name,
+                 const std::string& path,
+                 const std::string& contentType = "")
+    {
+        std::shared_ptr<ofxOAuthUploadSource> source(new ofxOAuthUploadSource());
+
+        if(!source->openFile(path)) return false;
+
+        Part part;
+        part.name = name;
+        part.contentType = contentType;
+        part.source = source;
+        _parts.push_back(part);
+
+        return true;
+    }
+
+    void addBuffer(const std::string& name,
+                   const void* data,
+                   std::size_t size,
+                   const std::string& filename,
+                   const std::string& contentType = "")
+    {
+        std::shared_ptr<ofxOAuthUploadSource> source(new ofxOAuthUploadSource());
+        // a file part needs a file name, otherwise it is sent as a field.
+        source->setBuffer(data, size, filename.empty() ? name : filename);
+
+        Part part;
+        part.name = name;
+        part.contentType = contentType;
+        part.source = source;
+        _parts.push_back(part);
+    }
+
+    bool empty() const
+    {
+        return _parts.empty();
+    }
+
+    std::size_t size() const
+    {
+        return _parts.size();
+    }
+
+    void clear()
+    {
+        _parts.clear();
+    }
+
+#if defined(OFX_OAUTH_HAS_CURL_MIME)
+    typedef curl_mime* Post;
+#else
+    typedef struct curl_httppost* Post;
+#endif
+
+    // Builds the curl form and sets it, and whatever reads its file parts,
+    // on the handle.  Returns 0 if the form could not be built; otherwise
+    // release the result with freePost() once the transfer is done.
+    Post attach(CURL* curl)
+    {
+#if defined(OFX_OAUTH_HAS_CURL_MIME)
+        curl_mime* post = curl_mime_init(curl);
+
+        if(0 == post) return 0;
+
+        for(std::size_t i = 0; i < _parts.size(); ++i)
+        {
+            Part& part = _parts[i];
+
+            curl_mimepart* mimePart = curl_mime_addpart(post);
+
+            CURLcode result = 0 == mimePart ? CURLE_OUT_OF_MEMORY : curl_mime_name(mimePart, part.name.c_str());
+
+            if(CURLE_OK == result && !part.source)
+            {
+                result = curl_mime_data(mimePart, part.value.data(), part.value.size());
+            }
+            else if(CURLE_OK == result)
+            {
+                // rewind, in case the form is sent more than once.
+                part.source->rewind();
+
+                const char* contentType = part.contentType.empty() ? "application/octet-stream" : part.contentType.c_str();
+
+                result = curl_mime_data_cb(mimePart,
+                                           (curl_off_t)part.source->size(),
+                                           ofxOAuthUploadSource::readCallback,
+                                           ofxOAuthUploadSource::seekCallback,
+                                           0,
+                                           part.source.get());
+
+                if(CURLE_OK == result) result = curl_mime_filename(mimePart, part.source->getName().c_str());
+                if(CURLE_OK == result) result = curl_mime_type(mimePart, contentType);
+            }
+
+            if(CURLE_OK != result)
+            {
+                curl_mime_free(post);
+                return 0;
+            }
+        }
+
+        curl_easy_setopt(curl, CURLOPT_MIMEPOST, post);
+#else
+        struct curl_httppost* post = 0;
+        struct curl_httppost* last = 0;
+
+        for(std::size_t i = 0; i < _parts.size(); ++i)
+        {
+            Part& part = _parts[i];
+
+            CURLFORMcode result;
+
+            if(!part.source)
+            {
+                long length = static_cast<long>(part.value.size());
+
+                result = curl_formadd(&post, &last,
+                                      CURLFORM_COPYNAME, part.name.c_str(),
+                                      CURLFORM_COPYCONTENTS, part.value.c_str(),
+                                      CURLFORM_CONTENTSLENGTH, length,
+                                      CURLFORM_END);
+            }
+            else
+            {
+                // rewind, in case the form is sent more than once.
+                part.source->rewind();
+
+                const char* contentType = part.contentType.empty() ? "application/octet-stream" : part.contentType.c_str();
+                long length = static_cast<long>(part.source->size());
+
+                result = curl_formadd(&post, &last,
+                                      CURLFORM_COPYNAME, part.name.c_str(),
+                                      CURLFORM_STREAM, (void*)part.source.get(),
+                                      CURLFORM_CONTENTSLENGTH, length,
+                                      CURLFORM_FILENAME, part.source->getName().c_str(),
+                                      CURLFORM_CONTENTTYPE, contentType,
+                                      CURLFORM_END);
+            }
+
+            // 0 is CURL_FORMADD_OK.
+            if(0 != result)
+            {
+                curl_formfree(post);
+                return 0;
+            }
+        }
+
+        // CURLFORM_STREAM parts are pulled through the read callback, with
+        // their ofxOAuthUploadSource as the userdata.
+        curl_easy_setopt(curl, CURLOPT_HTTPPOST, post);
+        curl_easy_setopt(curl, CURLOPT_READFUNCTION, ofxOAuthUploadSource::readCallback);
+#endif
+
+        return post;
+    }
+
+    static void freePost(Post post)
+    {
+#if defined(OFX_OAUTH_HAS_CURL_MIME)
+        curl_mime_free(post);
+#else
+        curl_formfree(post);
+#endif
+    }
+
+private:
+    struct Part
+    {
+        std::string name;
+        std::string value; //< plain fields only
+        std::string contentType; //< file fields only
+        std::shared_ptr<ofxOAuthUploadSource> source; //< null for plain fields
+    };
+
+    std::vector<Part> _parts;
+
+};
+
@@ -0,0 +1,533 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+#pragma once
+
+
+#include <stdlib.h>
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <oauth.h>
+#include "Poco/Condition.h"
+#include "Poco/Mutex.h"
+#include "Poco/ScopedUnlock.h"
+#include "ofxOAuthAsyncResponse.h"
+#include "ofxOAuthCancellationToken.h"
+#include "ofxOAuthJSONExtractor.h"
+#include "ofxOAuthRetryPolicy.h"
+#include "ofxOAuthTransport.h"
+
+
+// Walks a paged endpoint, fetching pages ahead of the caller.  Each page is
+// scanned with an ofxOAuthJSONExtractor as it arrives; with CURSOR and
+// NEXT_LINK paging the next page is signed and sent from the I/O thread the
+// moment the current page's cursor has been read, without waiting for the
+// rest of its body or for the caller.  MAX_ID paging needs the lowest id on
+// the page, so the next page goes out once the current one is complete.
+//
+//      ofxOAuthPaginator::Settings settings;
+//      settings.uri = "/1.1/followers/ids.json";
+//      settings.query = "screen_name=openframeworks&count=5000&stringify_ids=true";
+//      settings.items = "/ids/*";
+//      settings.cursor = "/next_cursor_str";
+//
+//      std::shared_ptr<ofxOAuthPaginator> pages = oauth.paginate(settings);
+//      ofxOAuthPaginator::Page page;
+//
+//      while(pages->next(page))
+//      {
+//          // page.items ...
+//      }
+//
+//      if(pages->hasFailed()) ... // page.response holds the failed reply
+//
+class ofxOAuthPaginator
+{
+public:
+    enum Style
+    {
+        CURSOR,   //< cursor=<value of settings.cursor>, until it is 0
+        MAX_ID,   //< max_id=<lowest id on the page - 1>, until a page is empty
+        NEXT_LINK //< the query (or URL) in settings.cursor, until it is missing
+    };
+
+    // Fetches uri with query, scanning the reply with extractor.  uri may
+    // also be an absolute URL, taken from a next link.
+    typedef std::function<ofxOAuthAsyncResponse(const std::string& uri,
+                                                const std::string& query,
+                                                std::shared_ptr<ofxOAuthJSONExtractor> extractor,
+                                                std::shared_ptr<ofxOAuthCancellationToken> cancellationToken)> Fetcher;
+
+    struct Settings
+    {
+        Settings():
+            style(CURSOR),
+            firstCursor("-1"),
+            prefetchDepth(2),
+            maxBufferedBytes(8 * 1024 * 1024)
+        {
+        }
+
+        std::string uri;
+        std::string query;            //< sent with every page
+        Style style;
+        std::string items;            //< pointer to each item, e.g. /statuses/*
+        std::string cursor;           //< pointer to the cursor, the item ids (MAX_ID) or the next link
+        std::string parameter;        //< defaults to cursor or max_id
+        std::string firstCursor;      //< CURSOR only; empty sends none
+        std::string sinceId;          //< MAX_ID only; the since_id bound for every page
+        std::size_t prefetchDepth;    //< pages requested but not yet taken by next()
+        std::size_t maxBufferedBytes; //< item bytes of pages waiting for next() that pause prefetching
+    };
+
+    struct Page
+    {
+        Page(): index(0)
+        {
+        }
+
+        std::size_t index;
+        std::string uri;
+        std::string query;
+        std::vector<std::string> items;
+        ofxOAuthResponse response;
+    };
+
+    ofxOAuthPaginator(const Settings& settings, Fetcher fetcher):
+        _state(std::make_shared<_State>(settings, fetcher))
+    {
+    }
+
+    // Aborts any prefetched pages still in flight.
+    virtual ~ofxOAuthPaginator()
+    {
+        _state->cancel();
+    }
+
+    // Blocks until the next page is in.  Returns false after the last page,
+    // or with the failed page if a request failed.
+    bool next(Page& page)
+    {
+        return _state->next(page);
+    }
+
+    bool hasFailed() const
+    {
+        return _state->hasFailed();
+    }
+
+    // MAX_ID only: the highest id seen so far, for a later since_id.
+    std::string getNewestId() const
+    {
+        return _state->getNewestId();
+    }
+
+private:
+    ofxOAuthPaginator(const ofxOAuthPaginator&);
+    ofxOAuthPaginator& operator=(const ofxOAuthPaginator&);
+
+    // Shared with the transfers, which may finish after the paginator is
+    // gone.
+    class _State: public std::enable_shared_from_this<_State>
+    {
+    public:
+        _State(const Settings& settings, Fetcher fetcher):
+            _settings(settings),
+            _fetcher(fetcher),
+            _cancellationToken(std::make_shared<ofxOAuthCancellationToken>()),
+            _isStarted(false),
+            _hasNext(false),
+            _hasLast(false),
+            _hasFailed(false),
+            _isCancelled(false),
+            _nextIndex(0),
+            _lastIndex(0),
+            _consumed(0),
+            _bufferedBytes(0),
+            _issuing(0)
+        {
+            if(_settings.parameter.empty())
+            {
+                _settings.parameter = _settings.style == MAX_ID ? "max_id" : "cursor";
+            }
+
+            _settings.prefetchDepth = std::max<std::size_t>(1, _settings.prefetchDepth);
+        }
+
+        bool next(Page& page)
+        {
+            {
+                Poco::Mutex::ScopedLock lock(_mutex);
+
+                if(!_isStarted)
+                {
+                    _isStarted = true;
+                    _hasNext = true;
+                    _nextUri = _settings.uri;
+                    _nextQuery = _settings.query;
+
+                    if(_settings.style == CURSOR && !_settings.firstCursor.empty())
+                    {
+                        _nextQuery = _withParameter(_nextQuery, _settings.parameter, _settings.firstCursor);
+                    }
+                    else if(_settings.style == MAX_ID && !_settings.sinceId.empty())
+                    {
+                        _nextQuery = _withParameter(_nextQuery, "since_id", _settings.sinceId);
+                    }
+                }
+            }
+
+            _issue();
+
+            Poco::Mutex::ScopedLock lock(_mutex);
+
+            for(;;)
+            {
+                if(_hasFailed || (_hasLast && _consumed > _lastIndex))
+                {
+                    return false;
+                }
+
+                std::map<std::size_t, _Slot>::iterator iter = _slots.find(_consumed);
+
+                if(iter != _slots.end() && iter->second.isDone)
+                {
+                    bool isComplete = iter->second.isComplete;
+
+                    page = std::move(iter->second.page);
+                    _bufferedBytes -= iter->second.bytes;
+                    _slots.erase(iter);
+                    ++_consumed;
+
+                    if(!isComplete || !ofxOAuthRetryPolicy::isSuccess(page.response))
+                    {
+                        // pages after a failed one are of no use.
+                        _hasFailed = true;
+                        _isCancelled = true;
+                        _cancellationToken->cancel();
+                        return false;
+                    }
+
+                    break;
+                }
+
+                _condition.wait(_mutex);
+            }
+
+            {
+                Poco::ScopedUnlock<Poco::Mutex> unlock(_mutex);
+                _issue();
+            }
+
+            return true;
+        }
+
+        void cancel()
+        {
+            Poco::Mutex::ScopedLock lock(_mutex);
+
+            _isCancelled = true;
+            _cancellationToken->cancel();
+
+            // the fetcher must not be running once the client may be gone.
+            while(_issuing > 0)
+            {
+                _condition.wait(_mutex);
+            }
+        }
+
+        bool hasFailed() const
+        {
+            Poco::Mutex::ScopedLock lock(_mutex);
+            return _hasFailed;
+        }
+
+        std::string getNewestId() const
+        {
+            Poco::Mutex::ScopedLock lock(_mutex);
+            return _newestId;
+        }
+
+    private:
+        struct _Slot
+        {
+            _Slot(): isDone(false), isComplete(false), hasCursor(false), bytes(0)
+            {
+            }
+
+            Page page;
+            bool isDone;
+            bool isComplete;
+            bool hasCursor;
+            std::size_t bytes;
+        };
+
+        // Sends every page that is known and allowed by the prefetch
+        // limits.  Called without the lock held.
+        void _issue()
+        {
+            for(;;)
+            {
+                std::size_t index = 0;
+                std::string uri;
+                std::string query;
+
+                {
+                    Poco::Mutex::ScopedLock lock(_mutex);
+
+                    if(!_hasNext || _isCancelled) return;
+
+                    if(_slots.size() >= _settings.prefetchDepth) return;
+
+                    if(!_slots.empty() && _bufferedBytes >= _settings.maxBufferedBytes) return;
+
+                    index = _nextIndex++;
+                    uri = _nextUri;
+                    query = _nextQuery;
+                    _hasNext = false;
+
+                    _Slot& slot = _slots[index];
+                    slot.page.index = index;
+                    slot.page.uri = uri;
+                    slot.page.query = query;
+
+                    ++_issuing;
+                }
+
+                _fetch(index, uri, query);
+
+                Poco::Mutex::ScopedLock lock(_mutex);
+                --_issuing;
+                _condition.broadcast();
+            }
+        }
+
+        void _fetch(std::size_t index, const std::string& uri, const std::string& query)
+        {
+            std::shared_ptr<_State> self = shared_from_this();
+            std::shared_ptr<ofxOAuthJSONExtractor> extractor = std::make_shared<ofxOAuthJSONExtractor>();
+
+            if(!_settings.items.empty()) extractor->add(_settings.items);
+
+            extractor->add(_settings.cursor);
+
+            if(_settings.style != MAX_ID)
+            {
+                // runs on the I/O thread, part way through the body.
+                std::string cursor = _settings.cursor;
+
+                extractor->setListener([self, index, cursor](const std::string& pointer, const std::string& value)
+                {
+                    if(pointer == cursor && self->_setCursor(index, value))
+                    {
+                        self->_issue();
+                    }
+                });
+            }
+
+            _fetcher(uri, query, extractor, _cancellationToken).then([self, index, extractor](ofxOAuthResponse& response)
+            {
+                self->_complete(index, *extractor, response);
+                self->_issue();
+            });
+        }
+
+        // Decides the page after index.  Returns true if there is one.
+        bool _setCursor(std::size_t index, const std::string& value)
+        {
+            Poco::Mutex::ScopedLock lock(_mutex);
+
+            std::map<std::size_t, _Slot>::iterator iter = _slots.find(index);
+
+            if(iter == _slots.end() || iter->second.hasCursor) return false;
+
+            iter->second.hasCursor = true;
+
+            bool isLast = value.empty() || value == "0" || value == "null";
+
+            if(!isLast && _settings.style == CURSOR)
+            {
+                _nextUri = _settings.uri;
+                _nextQuery = _withParameter(_settings.query, _settings.parameter, value);
+            }
+            else if(!isLast && _settings.style == NEXT_LINK)
+            {
+                std::string link = value;
+                std::size_t question = link.find('?');
+
+                _nextUri = question == 0 ? _settings.uri : link.substr(0, question);
+                _nextQuery = question == std::string::npos ? "" : link.substr(question + 1);
+            }
+            else if(!isLast && _settings.style == MAX_ID)
+            {
+                _nextUri = _settings.uri;
+                _nextQuery = _withParameter(_settings.query, _settings.parameter, value);
+
+                if(!_settings.sinceId.empty())
+                {
+                    _nextQuery = _withParameter(_nextQuery, "since_id", _settings.sinceId);
+                }
+            }
+
+            if(isLast)
+            {
+                _hasLast = true;
+                _lastIndex = index;
+                _condition.broadcast();
+                return false;
+            }
+
+            _hasNext = true;
+            return true;
+        }
+
+        void _complete(std::size_t index,
+                       const ofxOAuthJSONExtractor& extractor,
+                       const ofxOAuthResponse& response)
+        {
+            std::string cursor;
+
+            if(_settings.style == MAX_ID)
+            {
+                cursor = _getMaxId(extractor.getAll(_settings.cursor));
+            }
+            else
+            {
+                cursor = extractor.get(_settings.cursor, "");
+            }
+
+            bool isComplete = extractor.isComplete();
+
+            // a failed page ends the walk when it is taken.
+            if(isComplete && ofxOAuthRetryPolicy::isSuccess(response))
+            {
+                _setCursor(index, cursor);
+            }
+
+            Poco::Mutex::ScopedLock lock(_mutex);
+
+            std::map<std::size_t, _Slot>::iterator iter = _slots.find(index);
+
+            if(iter == _slots.end()) return;
+
+            _Slot& slot = iter->second;
+            slot.page.response = response;
+            slot.isDone = true;
+            slot.isComplete = isComplete;
+
+            if(!_settings.items.empty())
+            {
+                slot.page.items = extractor.getAll(_settings.items);
+            }
+
+            for(std::size_t i = 0; i < slot.page.items.size(); ++i)
+            {
+                slot.bytes += slot.page.items[i].size();
+            }
+
+            _bufferedBytes += slot.bytes;
+            _condition.broadcast();
+        }
+
+        // The max_id for the page after one holding ids, and the newest id
+        // so far.  Empty if there are no ids.  Called without the lock.
+        std::string _getMaxId(const std::vector<std::string>& ids)
+        {
+            if(ids.empty()) return "";
+
+            unsigned long long lowest = 0;
+            unsigned long long highest = 0;
+
+            for(std::size_t i = 0; i < ids.size(); ++i)
+            {
+                unsigned long long id = strtoull(ids[i].c_str(), 0, 10);
+
+                if(i == 0 || id < lowest) lowest = id;
+                if(i == 0 || id > highest) highest = id;
+            }
+
+            {
+                Poco::Mutex::ScopedLock lock(_mutex);
+
+                if(_newestId.empty() || highest > strtoull(_newestId.c_str(), 0, 10))
+                {
+                    _newestId = std::to_string(highest);
+                }
+            }
+
+            return lowest > 0 ? std::to_string(lowest - 1) : "";
+        }
+
+        static std::string _withParameter(const std::string& query,
+                                          const std::string& name,
+                                          const std::string& value)
+        {
+            std::string escaped;
+            char* p = oauth_url_escape(value.c_str());
+
+            if(0 != p)
+            {
+                escaped = p;
+                free(p);
+            }
+
+            return (query.empty() ? "" : query + "&") + name + "=" + escaped;
+        }
+
+        Settings _settings;
+        Fetcher _fetcher;
+        std::shared_ptr<ofxOAuthCancellationToken> _cancellationToken;
+
+        mutable Poco::Mutex _mutex;
+        Poco::Condition _condition;
+
+        std::map<std::size_t, _Slot> _slots;
+
+        bool _isStarted;
+        bool _hasNext;
+        bool _hasLast;
+        bool _hasFailed;
+        bool _isCancelled;
+
+        std::string _nextUri;
+        std::string _nextQuery;
+        std::size_t _nextIndex;
+        std::size_t _lastIndex;
+        std::size_t _consumed;
+        std::size_t _bufferedBytes;
+        std::size_t _issuing;
+
+        std::string _newestId;
+
+    };
+
+    std::shared_ptr<_State> _state;
+
+};
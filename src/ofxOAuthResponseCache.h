@@ -0,0 +1,371 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <fstream>
+#include <iterator>
+#include <list>
+#include <map>
+#include <string>
+#include <openssl/evp.h>
+#include "Poco/Mutex.h"
+#include "ofxOAuthAtomicFile.h"
+
+
+// A bounded, in-memory LRU of GET responses that carried an ETag or a
+// Last-Modified header, used to revalidate requests with If-None-Match /
+// If-Modified-Since.  When the server answers 304 Not Modified, the cached
+// body is served instead.  An optional disk tier keeps entries across runs.
+//
+// Keys are the canonical request: method, url without the oauth_*
+// parameters (so no nonce, timestamp or signature) and the access token.
+// Only a SHA-256 of the key reaches the disk, never the key itself.
+class ofxOAuthResponseCache
+{
+public:
+    struct Entry
+    {
+        std::string etag;
+        std::string lastModified;
+        std::string body;
+    };
+
+    struct Stats
+    {
+        Stats(): hits(0), misses(0), evictions(0), bytesSaved(0)
+        {
+        }
+
+        double getHitRatio() const
+        {
+            uint64_t total = hits + misses;
+            return total > 0 ? double(hits) / double(total) : 0.0;
+        }
+
+        uint64_t hits;       //< requests answered 304 and served from cache
+        uint64_t misses;     //< requests that downloaded a full body
+        uint64_t evictions;  //< entries dropped from memory to stay in budget
+        uint64_t bytesSaved; //< body bytes not downloaded thanks to 304s
+    };
+
+    enum
+    {
+        DEFAULT_MAX_BYTES = 8 * 1024 * 1024
+    };
+
+    ofxOAuthResponseCache(std::size_t maxBytes = DEFAULT_MAX_BYTES):
+        _maxBytes(maxBytes),
+        _bytes(0)
+    {
+    }
+
+    virtual ~ofxOAuthResponseCache()
+    {
+    }
+
+    static std::string makeKey(const std::string& method,
+                               const std::string& url,
+                               const std::string& token)
+    {
+        return method + " " + url + " " + token;
+    }
+
+    void setMaxBytes(std::size_t maxBytes)
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        _maxBytes = maxBytes;
+        _trim();
+    }
+
+    std::size_t getMaxBytes() const
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        return _maxBytes;
+    }
+
+    // An existing, writable directory (absolute path), or "" to disable
+    // the disk tier.
+    void setDiskDirectory(const std::string& directory)
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        _diskDirectory = directory;
+        if(!_diskDirectory.empty() && _diskDirectory[_diskDirectory.size() - 1] != '/')
+        {
+            _diskDirectory += "/";
+        }
+    }
+
+    std::string getDiskDirectory() const
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        return _diskDirectory;
+    }
+
+    // Disk I/O happens outside the cache lock, so a slow disk only holds
+    // up requests that miss memory.
+    bool get(const std::string& key, Entry& entry)
+    {
+        std::string diskDirectory;
+
+        {
+            Poco::Mutex::ScopedLock lock(_mutex);
+
+            Index::iterator iter = _index.find(key);
+
+            if(iter != _index.end())
+            {
+                // move to the front of the lru list.
+                _entries.splice(_entries.begin(), _entries, iter->second);
+                entry = iter->second->second;
+                return true;
+            }
+
+            diskDirectory = _diskDirectory;
+        }
+
+        if(diskDirectory.empty() || !_readFromDisk(diskDirectory, key, entry))
+        {
+            return false;
+        }
+
+        Poco::Mutex::ScopedLock lock(_mutex);
+        _insert(key, entry);
+        return true;
+    }
+
+    void put(const std::string& key, const Entry& entry)
+    {
+        std::string diskDirectory;
+
+        {
+            Poco::Mutex::ScopedLock lock(_mutex);
+            _insert(key, entry);
+            diskDirectory = _diskDirectory;
+        }
+
+        if(!diskDirectory.empty())
+        {
+            _writeToDisk(diskDirectory, key, entry);
+        }
+    }
+
+    void remove(const std::string& key)
+    {
+        std::string diskDirectory;
+
+        {
+            Poco::Mutex::ScopedLock lock(_mutex);
+
+            Index::iterator iter = _index.find(key);
+
+            if(iter != _index.end())
+            {
+                _bytes -= _sizeOf(*iter->second);
+                _entries.erase(iter->second);
+                _index.erase(iter);
+            }
+
+            diskDirectory = _diskDirectory;
+        }
+
+        if(!diskDirectory.empty())
+        {
+            Poco::Mutex::ScopedLock lock(_diskMutex);
+            ::remove((diskDirectory + _hash(key) + ".cache").c_str());
+        }
+    }
+
+    void recordHit(std::size_t bytesSaved)
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        ++_stats.hits;
+        _stats.bytesSaved += bytesSaved;
+    }
+
+    void recordMiss()
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        ++_stats.misses;
+    }
+
+    Stats getStats() const
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        return _stats;
+    }
+
+    std::size_t size() const
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        return _entries.size();
+    }
+
+    std::size_t getBytes() const
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        return _bytes;
+    }
+
+    // Clears memory only; the disk tier is left alone.
+    void clear()
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        _entries.clear();
+        _index.clear();
+        _bytes = 0;
+    }
+
+protected:
+    typedef std::pair<std::string, Entry> Item;
+    typedef std::list<Item> Entries;
+    typedef std::map<std::string, Entries::iterator> Index;
+
+    static std::size_t _sizeOf(const Item& item)
+    {
+        return item.first.size() +
+               item.second.etag.size() +
+               item.second.lastModified.size() +
+               item.second.body.size();
+    }
+
+    void _insert(const std::string& key, const Entry& entry)
+    {
+        Index::iterator iter = _index.find(key);
+
+        if(iter != _index.end())
+        {
+            _bytes -= _sizeOf(*iter->second);
+            _entries.erase(iter->second);
+            _index.erase(iter);
+        }
+
+        Item item(key, entry);
+
+        std::size_t size = _sizeOf(item);
+
+        if(size > _maxBytes) return; // would never fit
+
+        _entries.push_front(item);
+        _index[key] = _entries.begin();
+        _bytes += size;
+
+        _trim();
+    }
+
+    void _trim()
+    {
+        while(_bytes > _maxBytes && !_entries.empty())
+        {
+            const Item& last = _entries.back();
+            _bytes -= _sizeOf(last);
+            _index.erase(last.first);
+            _entries.pop_back();
+            ++_stats.evictions;
+        }
+    }
+
+    // Hex SHA-256 of the key: names the file and identifies the entry in
+    // it, since the key holds the access token.
+    static std::string _hash(const std::string& key)
+    {
+        unsigned char digest[EVP_MAX_MD_SIZE];
+        unsigned int length = 0;
+
+        EVP_Digest(key.data(), key.size(), digest, &length, EVP_sha256(), 0);
+
+        static const char* hex = "0123456789abcdef";
+
+        std::string result;
+        result.reserve(length * 2);
+
+        for(unsigned int i = 0; i < length; ++i)
+        {
+            result += hex[digest[i] >> 4];
+            result += hex[digest[i] & 0x0f];
+        }
+
+        return result;
+    }
+
+    // Disk entries are: hash of key \n etag \n last-modified \n body.
+    bool _readFromDisk(const std::string& directory, const std::string& key, Entry& entry) const
+    {
+        std::string hash = _hash(key);
+
+        Poco::Mutex::ScopedLock lock(_diskMutex);
+
+        std::ifstream file((directory + hash + ".cache").c_str(), std::ios::binary);
+
+        if(!file) return false;
+
+        std::string storedHash;
+
+        if(!std::getline(file, storedHash) || storedHash != hash ||
+           !std::getline(file, entry.etag) ||
+           !std::getline(file, entry.lastModified))
+        {
+            return false;
+        }
+
+        entry.body.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+        return true;
+    }
+
+    void _writeToDisk(const std::string& directory, const std::string& key, const Entry& entry) const
+    {
+        std::string hash = _hash(key);
+
+        std::string data;
+        data.reserve(hash.size() + entry.etag.size() + entry.lastModified.size() + entry.body.size() + 3);
+        data += hash + "\n";
+        data += entry.etag + "\n";
+        data += entry.lastModified + "\n";
+        data += entry.body;
+
+        // writers of the same entry would share its temporary file.
+        Poco::Mutex::ScopedLock lock(_diskMutex);
+        ofxOAuthAtomicFile::write(directory + hash + ".cache", data);
+    }
+
+    std::size_t _maxBytes;
+    std::size_t _bytes;
+
+    Entries _entries;
+    Index _index;
+
+    std::string _diskDirectory;
+
+    Stats _stats;
+
+    mutable Poco::Mutex _mutex;
+    mutable Poco::Mutex _diskMutex; //< serializes disk tier file access
+
+};
@@ -0,0 +1,421 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include <stdlib.h>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include "Poco/Mutex.h"
+#include "Poco/Thread.h"
+#include "ofxOAuthCancellationToken.h"
+#include "ofxOAuthFormDecoder.h"
+#include "ofxOAuthTransport.h"
+
+
+// Retries failed requests with decorrelated-jitter backoff
+// (delay = min(maxDelay, random(baseDelay, 3 * previous delay))).
+//
+// Transport errors, 5xx and 429 replies are retried.  401s and replies
+// reporting an oauth_problem (in WWW-Authenticate or a form-encoded body)
+// are not: the request itself is wrong and sending it again only adds load.  A Retry-After header is honored, up to
+// maxDelay.
+//
+// Requests that are not idempotent (POST, PATCH) are only retried when
+// the server cannot have acted on them: the connection was never made, or
+// the reply was 429 or 503.  Set retryNonIdempotent to retry them like the
+// rest.
+//
+// Retries draw from a budget shared by every request of the client: each
+// request adds budgetRatio tokens (up to budgetMax) and each retry spends
+// one.  During an outage this caps retries at a fraction of the traffic
+// instead of multiplying it.
+//
+// A Corrector gets a look at failures that are not retryable.  If it
+// returns true it has fixed what was wrong on our side (e.g. the clock
+// offset after a refused timestamp) and the request is signed and sent once
+// more, at once and from the budget like any retry.  That one re-send is
+// made even when no attempts are left, so it also happens with retries off.
+//
+// Off by default (maxAttempts 1): every call sends one request, as before,
+// plus the corrected one.
+class ofxOAuthRetryPolicy
+{
+public:
+    // Performs one attempt.  attempt is 0 for the first one; later attempts
+    // must be signed again, with a fresh nonce and timestamp.
+    typedef std::function<bool(std::size_t attempt, ofxOAuthResponse& response)> Attempt;
+
+    typedef std::function<bool(const ofxOAuthResponse& response)> Corrector;
+
+    struct Settings
+    {
+        Settings():
+            maxAttempts(1),
+            baseDelay(100),
+            maxDelay(10000),
+            budgetRatio(0.1),
+            budgetMax(10),
+            retryNonIdempotent(false)
+        {
+        }
+
+        std::size_t maxAttempts; //< including the first one, 1 disables retries
+        long baseDelay;          //< milliseconds
+        long maxDelay;           //< milliseconds
+        double budgetRatio;      //< retry tokens earned per request
+        double budgetMax;        //< most retry tokens that can be saved up
+        bool retryNonIdempotent;
+    };
+
+    struct Stats
+    {
+        Stats():
+            requests(0),
+            retries(0),
+            notRetryable(0),
+            budgetExhausted(0),
+            corrected(0)
+        {
+        }
+
+        unsigned long long requests;
+        unsigned long long retries;
+        unsigned long long notRetryable;    //< failures that were not retried by design
+        unsigned long long budgetExhausted; //< retries skipped for lack of budget
+        unsigned long long corrected;       //< failures sent again after the Corrector fixed them
+    };
+
+    ofxOAuthRetryPolicy(): _budget(0), _random(std::random_device()())
+    {
+        _budget = _settings.budgetMax;
+    }
+
+    virtual ~ofxOAuthRetryPolicy()
+    {
+    }
+
+    void setSettings(const Settings& settings)
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        _settings = settings;
+        if(_budget > _settings.budgetMax) _budget = _settings.budgetMax;
+    }
+
+    Settings getSettings() const
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        return _settings;
+    }
+
+    Stats getStats() const
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        return _stats;
+    }
+
+    void setCorrector(Corrector corrector)
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        _corrector = corrector;
+    }
+
+    // One request's way through its attempts, for begin() and next().
+    struct Attempts
+    {
+        Attempts():
+            count(0),
+            delay(0),
+            isCorrected(false)
+        {
+        }
+
+        std::size_t count; //< attempts made so far
+        long delay;        //< the last backoff, milliseconds
+        bool isCorrected;  //< the corrector has fixed a failure already
+        Settings settings;
+        Corrector corrector;
+    };
+
+    // Runs attempts until one succeeds, fails in a way that is not
+    // retryable, or the attempts or budget run out.  Returns the last
+    // response's isComplete().
+    bool perform(Attempt attempt,
+                 ofxOAuthResponse& response,
+                 bool isIdempotent,
+                 std::shared_ptr<ofxOAuthCancellationToken> cancellationToken = std::shared_ptr<ofxOAuthCancellationToken>())
+    {
+        Attempts attempts;
+        begin(attempts);
+
+        long wait = 0;
+
+        do
+        {
+            if(wait > 0 && !_sleep(wait, cancellationToken)) break;
+
+            response = ofxOAuthResponse();
+
+            attempt(attempts.count, response);
+        }
+        while(next(attempts, response, isIdempotent, wait));
+
+        return response.isComplete();
+    }
+
+    // perform() in steps, for requests that must not block a thread while
+    // they wait: begin() before the first attempt, next() with the response
+    // of each.
+    void begin(Attempts& attempts)
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+
+        attempts = Attempts();
+        attempts.settings = _settings;
+        attempts.corrector = _corrector;
+        attempts.delay = _settings.baseDelay;
+
+        ++_stats.requests;
+        _budget = std::min(_settings.budgetMax, _budget + _settings.budgetRatio);
+    }
+
+    // Returns true if the request is to be signed and sent again, after
+    // wait milliseconds.
+    bool next(Attempts& attempts, const ofxOAuthResponse& response, bool isIdempotent, long& wait)
+    {
+        const Settings& settings = attempts.settings;
+
+        ++attempts.count;
+        wait = 0;
+
+        if(isSuccess(response)) return false;
+
+        bool isCorrection = false;
+
+        if(!isRetryable(response, isIdempotent || settings.retryNonIdempotent))
+        {
+            // the corrector runs even on the last attempt: the
+            // corrected request is sent past maxAttempts.
+            isCorrection = !attempts.isCorrected && attempts.corrector && attempts.corrector(response);
+
+            if(!isCorrection)
+            {
+                Poco::Mutex::ScopedLock lock(_mutex);
+                ++_stats.notRetryable;
+                return false;
+            }
+
+            attempts.isCorrected = true;
+        }
+
+        if(attempts.count >= settings.maxAttempts && !isCorrection) return false;
+
+        {
+            Poco::Mutex::ScopedLock lock(_mutex);
+
+            if(_budget < 1)
+            {
+                ++_stats.budgetExhausted;
+                return false;
+            }
+
+            _budget -= 1;
+
+            if(isCorrection)
+            {
+                // sent again at once, in corrected time.
+                ++_stats.corrected;
+                return true;
+            }
+
+            ++_stats.retries;
+
+            attempts.delay = _nextDelay(settings, attempts.delay);
+        }
+
+        wait = std::max(attempts.delay, std::min(settings.maxDelay, getRetryAfter(response)));
+
+        return true;
+    }
+
+    static bool isSuccess(const ofxOAuthResponse& response)
+    {
+        return response.isComplete() && response.status < 400;
+    }
+
+    // isIdempotent false limits retries to failures the server cannot have
+    // acted on.
+    static bool isRetryable(const ofxOAuthResponse& response, bool isIdempotent)
+    {
+        if(!response.isComplete())
+        {
+            // cancelled, or failing fast while the host is down.
+            if(response.isCancelled() || response.isRejected()) return false;
+
+            if(isIdempotent) return true;
+
+            return response.error == CURLE_COULDNT_RESOLVE_HOST ||
+                   response.error == CURLE_COULDNT_RESOLVE_PROXY ||
+                   response.error == CURLE_COULDNT_CONNECT;
+        }
+
+        // the signature, token or timestamp was rejected.
+        if(response.status == 401 || isOAuthProblem(response)) return false;
+
+        if(response.status == 429 || response.status == 503) return true;
+
+        return isIdempotent && response.status >= 500;
+    }
+
+    static bool isOAuthProblem(const ofxOAuthResponse& response)
+    {
+        return !getOAuthProblem(response).empty();
+    }
+
+    // The oauth_problem parameter (e.g. timestamp_refused) of the OAuth
+    // problem reporting extension, from the WWW-Authenticate header or a
+    // form-encoded body.  Empty if the reply has none.
+    static std::string getOAuthProblem(const ofxOAuthResponse& response)
+    {
+        std::string problem = getAuthParam(response.headers.get("WWW-Authenticate", ""), "oauth_problem");
+
+        // e.g. oauth_problem=timestamp_refused&oauth_acceptable_timestamps=...
+        if(problem.empty() && !response.body.empty() && response.body.size() <= MAX_PROBLEM_BODY)
+        {
+            std::string body = response.body;
+
+            ofxOAuthFormDecoder decoder(body);
+            ofxOAuthFormDecoder::Field field;
+
+            while(decoder.next(field))
+            {
+                if(field.id == ofxOAuthFormDecoder::OAUTH_PROBLEM && field.hasValue)
+                {
+                    problem = field.value.str();
+                    break;
+                }
+            }
+        }
+
+        return problem;
+    }
+
+    // A parameter of an auth header, e.g. oauth_problem in
+    // OAuth realm="api", oauth_problem="timestamp_refused"
+    static std::string getAuthParam(const std::string& header, const std::string& name)
+    {
+        std::string::size_type pos = 0;
+
+        while((pos = header.find(name, pos)) != std::string::npos)
+        {
+            std::string::size_type end = pos + name.size();
+
+            bool isStart = pos == 0 || header[pos - 1] == ' ' || header[pos - 1] == ',' || header[pos - 1] == '\t';
+
+            pos = end;
+
+            if(!isStart) continue;
+
+            while(end < header.size() && (header[end] == ' ' || header[end] == '\t')) ++end;
+
+            if(end >= header.size() || header[end] != '=') continue;
+
+            ++end;
+
+            while(end < header.size() && (header[end] == ' ' || header[end] == '\t')) ++end;
+
+            if(end < header.size() && header[end] == '"')
+            {
+                std::string::size_type close = header.find('"', end + 1);
+                if(close == std::string::npos) return "";
+                return header.substr(end + 1, close - end - 1);
+            }
+
+            std::string::size_type close = header.find_first_of(", \t", end);
+            return header.substr(end, close == std::string::npos ? std::string::npos : close - end);
+        }
+
+        return "";
+    }
+
+    // The Retry-After delay in milliseconds, 0 if there is none.  Only the
+    // delta-seconds form is understood.
+    static long getRetryAfter(const ofxOAuthResponse& response)
+    {
+        std::string value = response.headers.get("Retry-After", "");
+
+        if(value.empty() || value.find_first_not_of("0123456789") != std::string::npos)
+        {
+            return 0;
+        }
+
+        return atol(value.c_str()) * 1000;
+    }
+
+protected:
+    enum
+    {
+        // problem replies are short; longer bodies are not decoded.
+        MAX_PROBLEM_BODY = 4096
+    };
+
+    long _nextDelay(const Settings& settings, long previous)
+    {
+        long upper = std::max(settings.baseDelay, previous * 3);
+        std::uniform_int_distribution<long> distribution(settings.baseDelay, upper);
+        return std::min(settings.maxDelay, distribution(_random));
+    }
+
+    // Returns false if cancelled while waiting.
+    static bool _sleep(long milliseconds, std::shared_ptr<ofxOAuthCancellationToken> cancellationToken)
+    {
+        const long slice = 50;
+
+        while(milliseconds > 0)
+        {
+            if(cancellationToken && cancellationToken->isCancelled()) return false;
+
+            long step = std::min(slice, milliseconds);
+            Poco::Thread::sleep(step);
+            milliseconds -= step;
+        }
+
+        return !(cancellationToken && cancellationToken->isCancelled());
+    }
+
+    Settings _settings;
+    Stats _stats;
+    Corrector _corrector;
+    double _budget;
+    std::mt19937 _random;
+
+    mutable Poco::Mutex _mutex;
+
+};
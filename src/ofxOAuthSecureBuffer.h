@@ -0,0 +1,149 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <cstddef>
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+
+// A fixed-size block of page-aligned memory for secrets.  The pages are
+// locked so they are never swapped out, excluded from core dumps where the
+// platform allows it, and wiped before they are released.
+class ofxOAuthSecureBuffer
+{
+public:
+    ofxOAuthSecureBuffer():
+        _data(0),
+        _size(0),
+        _isLocked(false)
+    {
+    }
+
+    virtual ~ofxOAuthSecureBuffer()
+    {
+        release();
+    }
+
+    // Allocates at least size bytes of zeroed memory, releasing (and wiping)
+    // anything held before.  Returns false if the memory could not be
+    // allocated.  If it could not be locked, the memory is still usable but
+    // isLocked() returns false.
+    bool allocate(std::size_t size)
+    {
+        release();
+
+        if(0 == size) return true;
+
+#if defined(_WIN32)
+        _data = static_cast<unsigned char*>(calloc(1, size));
+        if(0 == _data) return false;
+        _size = size;
+#else
+        std::size_t page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        std::size_t rounded = ((size + page - 1) / page) * page;
+
+        void* p = mmap(0, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+
+        if(p == MAP_FAILED) return false;
+
+        _data = static_cast<unsigned char*>(p);
+        _size = rounded;
+        _isLocked = (0 == mlock(_data, _size));
+#if defined(MADV_DONTDUMP)
+        madvise(_data, _size, MADV_DONTDUMP);
+#endif
+#endif
+        return true;
+    }
+
+    void release()
+    {
+        if(0 == _data) return;
+
+        wipe(_data, _size);
+
+#if defined(_WIN32)
+        free(_data);
+#else
+        if(_isLocked) munlock(_data, _size);
+        munmap(_data, _size);
+#endif
+        _data = 0;
+        _size = 0;
+        _isLocked = false;
+    }
+
+    unsigned char* data()
+    {
+        return _data;
+    }
+
+    const unsigned char* data() const
+    {
+        return _data;
+    }
+
+    std::size_t size() const
+    {
+        return _size;
+    }
+
+    bool isLocked() const
+    {
+        return _isLocked;
+    }
+
+    void swap(ofxOAuthSecureBuffer& other)
+    {
+        std::swap(_data, other._data);
+        std::swap(_size, other._size);
+        std::swap(_isLocked, other._isLocked);
+    }
+
+    // Zeroes memory in a way the compiler will not optimize away.
+    static void wipe(void* data, std::size_t size)
+    {
+        volatile unsigned char* p = static_cast<volatile unsigned char*>(data);
+        while(size--) *p++ = 0;
+    }
+
+private:
+    ofxOAuthSecureBuffer(const ofxOAuthSecureBuffer&);
+    ofxOAuthSecureBuffer& operator=(const ofxOAuthSecureBuffer&);
+
+    unsigned char* _data;
+    std::size_t _size;
+    bool _isLocked;
+
+};
@@ -0,0 +1,248 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include <stdint.h>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Poco/Event.h"
+#include "Poco/Mutex.h"
+#include "ofxOAuthAsyncResponse.h"
+#include "ofxOAuthTransport.h"
+
+
+// Collapses identical concurrent requests into one.  The first caller for a
+// key performs the request; callers that arrive with the same key while it
+// is in flight wait for it and receive a copy of its response.  Blocking
+// (run()) and asynchronous (runAsync()) callers share the same calls.
+//
+// Only use this for idempotent requests (i.e. GET), and make sure the key
+// covers everything that makes two requests differ (method, url, token).
+class ofxOAuthSingleFlight
+{
+public:
+    typedef std::function<void(ofxOAuthResponse&)> Function;
+    typedef std::function<ofxOAuthAsyncResponse()> AsyncFunction;
+
+    struct Stats
+    {
+        Stats(): calls(0), performed(0), merged(0)
+        {
+        }
+
+        uint64_t calls;     //< calls to run() and runAsync()
+        uint64_t performed; //< calls that went to the network
+        uint64_t merged;    //< calls that shared another call's response
+    };
+
+    ofxOAuthSingleFlight()
+    {
+    }
+
+    virtual ~ofxOAuthSingleFlight()
+    {
+    }
+
+    // Returns true if the response was shared from another in-flight call.
+    // If function throws, the callers waiting on it get a failed response
+    // and the exception is passed on to the caller that made it.
+    bool run(const std::string& key, Function function, ofxOAuthResponse& response)
+    {
+        std::shared_ptr<Call> call;
+
+        if(!_join(key, call))
+        {
+            call->done.wait();
+            response = call->response;
+            return true;
+        }
+
+        try
+        {
+            function(response);
+        }
+        catch(const std::exception& exc)
+        {
+            _publish(key, call, _failed(exc.what()));
+            throw;
+        }
+        catch(...)
+        {
+            _publish(key, call, _failed("unknown exception"));
+            throw;
+        }
+
+        _publish(key, call, response);
+
+        return false;
+    }
+
+    // run() for asynchronous requests.  The first caller for a key starts
+    // the request with function; everyone waiting on it, blocking or not,
+    // is handed the response when it completes.  Each caller gets its own
+    // ofxOAuthAsyncResponse, so each can take the response its own way.
+    ofxOAuthAsyncResponse runAsync(const std::string& key, AsyncFunction function)
+    {
+        std::shared_ptr<Call> call;
+
+        std::shared_ptr<ofxOAuthAsyncResponse::State> state = std::make_shared<ofxOAuthAsyncResponse::State>();
+
+        bool isLeader = _join(key, call, state);
+
+        if(!isLeader)
+        {
+            return ofxOAuthAsyncResponse(state);
+        }
+
+        std::shared_ptr<ofxOAuthAsyncResponse::State> leader;
+
+        try
+        {
+            leader = function().getState();
+        }
+        catch(const std::exception& exc)
+        {
+            _publish(key, call, _failed(exc.what()));
+            throw;
+        }
+        catch(...)
+        {
+            _publish(key, call, _failed("unknown exception"));
+            throw;
+        }
+
+        ofxOAuthExecutor::Task publish = [this, key, call, leader]()
+        {
+            _publish(key, call, leader->getResponse());
+        };
+
+        if(!leader->wait(publish, 0))
+        {
+            publish();
+        }
+
+        return ofxOAuthAsyncResponse(state);
+    }
+
+    Stats getStats() const
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        return _stats;
+    }
+
+protected:
+    struct Call
+    {
+        Call(): done(false) // manual reset, so every waiter wakes up
+        {
+        }
+
+        Poco::Event done;
+        ofxOAuthResponse response;
+        std::vector<std::shared_ptr<ofxOAuthAsyncResponse::State> > waiters;
+    };
+
+    typedef std::map<std::string, std::shared_ptr<Call> > Calls;
+
+    // Finds the call in flight for key, or starts one.  Returns true if the
+    // caller leads it.  A waiter, if given, is completed with the response.
+    bool _join(const std::string& key,
+               std::shared_ptr<Call>& call,
+               std::shared_ptr<ofxOAuthAsyncResponse::State> waiter = std::shared_ptr<ofxOAuthAsyncResponse::State>())
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+
+        ++_stats.calls;
+
+        Calls::iterator iter = _calls.find(key);
+
+        bool isLeader = iter == _calls.end();
+
+        if(isLeader)
+        {
+            call = std::shared_ptr<Call>(new Call());
+            _calls[key] = call;
+            ++_stats.performed;
+        }
+        else
+        {
+            call = iter->second;
+            ++_stats.merged;
+        }
+
+        if(waiter) call->waiters.push_back(waiter);
+
+        return isLeader;
+    }
+
+    // Hands the leader's response to everyone waiting on the call.  New
+    // callers for the key start a call of their own from here on.
+    void _publish(const std::string& key, std::shared_ptr<Call> call, const ofxOAuthResponse& response)
+    {
+        std::vector<std::shared_ptr<ofxOAuthAsyncResponse::State> > waiters;
+
+        {
+            Poco::Mutex::ScopedLock lock(_mutex);
+
+            Calls::iterator iter = _calls.find(key);
+
+            if(iter != _calls.end() && iter->second == call)
+            {
+                _calls.erase(iter);
+            }
+
+            call->response = response;
+            waiters.swap(call->waiters);
+        }
+
+        call->done.set();
+
+        for(std::size_t i = 0; i < waiters.size(); ++i)
+        {
+            waiters[i]->complete(response);
+        }
+    }
+
+    static ofxOAuthResponse _failed(const std::string& what)
+    {
+        ofxOAuthResponse response;
+        response.error = CURLE_FAILED_INIT;
+        response.errorMessage = "The shared request failed: " + what;
+        return response;
+    }
+
+    Calls _calls;
+    Stats _stats;
+
+    mutable Poco::Mutex _mutex;
+
+};
@@ -0,0 +1,448 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <map>
+#include <vector>
+#include <curl/curl.h>
+#include "Poco/Mutex.h"
+#include "Poco/Runnable.h"
+#include "Poco/Thread.h"
+#include "Poco/Timestamp.h"
+#include "ofxOAuthLog.h"
+#if defined(_WIN32)
+#include <winsock2.h>
+#else
+#include <fcntl.h>
+#include <sys/select.h>
+#include <unistd.h>
+#endif
+
+
+// Runs many transfers on one thread with a curl multi handle.  The thread is
+// started by the first submit().  Connections are kept in the multi handle's
+// cache, so transfers to the same host share them whichever easy handle
+// they run on.
+//
+// At most maxActive transfers run at once; the rest wait in submission
+// order.  The bundled curl has neither curl_multi_wait nor a connection
+// limit, so both are done here.  A job can also be submitted with a delay
+// (e.g. a retry after backoff); it waits on the loop, without a thread of
+// its own, and then queues like any other.
+class ofxOAuthTransferLoop: public Poco::Runnable
+{
+public:
+    // One transfer.  All calls are made on the loop thread.
+    class Job
+    {
+    public:
+        virtual ~Job()
+        {
+        }
+
+        // Returns a configured easy handle, or 0 if the job finished
+        // without one (e.g. it was refused); it is then deleted without a
+        // call to end().
+        virtual CURL* begin() = 0;
+
+        // The transfer finished with result.  curl is 0 if the job was
+        // never begun because the loop stopped.
+        virtual void end(CURL* curl, CURLcode result) = 0;
+    };
+
+    ofxOAuthTransferLoop():
+        _multi(0),
+        _maxActive(64),
+        _isStopping(false)
+    {
+        _wake[0] = -1;
+        _wake[1] = -1;
+    }
+
+    virtual ~ofxOAuthTransferLoop()
+    {
+        stop();
+    }
+
+    void setMaxActive(std::size_t maxActive)
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        _maxActive = std::max<std::size_t>(1, maxActive);
+    }
+
+    std::size_t getMaxActive() const
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        return _maxActive;
+    }
+
+    // Takes ownership of job, which is queued after delay milliseconds.
+    // After stop() the job is ended at once, with CURLE_ABORTED_BY_CALLBACK.
+    void submit(Job* job, long delay = 0)
+    {
+        {
+            Poco::Mutex::ScopedLock lock(_mutex);
+
+            if(!_isStopping && _start())
+            {
+                if(delay > 0)
+                {
+                    _delayed.insert(std::make_pair(Poco::Timestamp().epochMicroseconds() + Poco::Timestamp::TimeVal(delay) * 1000, job));
+                }
+                else
+                {
+                    _pending.push_back(job);
+                }
+
+                _wakeUp();
+                return;
+            }
+        }
+
+        _abandon(job);
+    }
+
+    // Ends every pending and running job with CURLE_ABORTED_BY_CALLBACK
+    // and joins the thread.
+    void stop()
+    {
+        {
+            Poco::Mutex::ScopedLock lock(_mutex);
+            _isStopping = true;
+            _wakeUp();
+        }
+
+        if(_thread.isRunning())
+        {
+            _thread.join();
+        }
+
+        if(0 != _multi)
+        {
+            curl_multi_cleanup(_multi);
+            _multi = 0;
+        }
+
+#if !defined(_WIN32)
+        if(_wake[0] >= 0) ::close(_wake[0]);
+        if(_wake[1] >= 0) ::close(_wake[1]);
+#endif
+        _wake[0] = -1;
+        _wake[1] = -1;
+    }
+
+    void run()
+    {
+        std::vector<Job*> starting;
+
+        for(;;)
+        {
+            {
+                Poco::Mutex::ScopedLock lock(_mutex);
+
+                if(_isStopping) break;
+
+                Poco::Timestamp::TimeVal now = Poco::Timestamp().epochMicroseconds();
+
+                while(!_delayed.empty() && _delayed.begin()->first <= now)
+                {
+                    _pending.push_back(_delayed.begin()->second);
+                    _delayed.erase(_delayed.begin());
+                }
+
+                while(!_pending.empty() && _running.size() + starting.size() < _maxActive)
+                {
+                    starting.push_back(_pending.front());
+                    _pending.pop_front();
+                }
+            }
+
+            for(std::size_t i = 0; i < starting.size(); ++i)
+            {
+                CURL* curl = _begin(starting[i]);
+
+                if(0 == curl) continue;
+
+                curl_easy_setopt(curl, CURLOPT_PRIVATE, starting[i]);
+                curl_multi_add_handle(_multi, curl);
+            }
+
+            starting.clear();
+
+            int running = 0;
+
+            while(curl_multi_perform(_multi, &running) == CURLM_CALL_MULTI_PERFORM)
+            {
+            }
+
+            bool hasFinished = false;
+            int queued = 0;
+            CURLMsg* message = 0;
+
+            while((message = curl_multi_info_read(_multi, &queued)) != 0)
+            {
+                if(message->msg != CURLMSG_DONE) continue;
+
+                // the message is freed when the handle is removed.
+                CURL* curl = message->easy_handle;
+                CURLcode result = message->data.result;
+
+                _finish(curl, result);
+                hasFinished = true;
+            }
+
+            // finished transfers make room for pending ones.
+            if(!hasFinished) _wait();
+        }
+
+        // stopping: abort what is running, then what never started.
+        while(!_running.empty())
+        {
+            _finish(_running.back(), CURLE_ABORTED_BY_CALLBACK);
+        }
+
+        std::deque<Job*> pending;
+
+        {
+            Poco::Mutex::ScopedLock lock(_mutex);
+            pending.swap(_pending);
+
+            for(Delayed::iterator iter = _delayed.begin(); iter != _delayed.end(); ++iter)
+            {
+                pending.push_back(iter->second);
+            }
+
+            _delayed.clear();
+        }
+
+        for(std::size_t i = 0; i < pending.size(); ++i)
+        {
+            _abandon(pending[i]);
+        }
+    }
+
+protected:
+    enum
+    {
+        MAX_WAIT = 1000 //< milliseconds, in case a wake-up is missed
+    };
+
+    // Starts the thread; called with the mutex held.
+    bool _start()
+    {
+        if(_thread.isRunning()) return true;
+
+        _multi = curl_multi_init();
+
+        if(0 == _multi)
+        {
+            ofLogError("ofxOAuthTransferLoop::submit") << "Unable to initialize curl multi.";
+            return false;
+        }
+
+#if !defined(_WIN32)
+        if(::pipe(_wake) == 0)
+        {
+            fcntl(_wake[0], F_SETFL, fcntl(_wake[0], F_GETFL) | O_NONBLOCK);
+            fcntl(_wake[1], F_SETFL, fcntl(_wake[1], F_GETFL) | O_NONBLOCK);
+        }
+        else
+        {
+            // without a pipe, new jobs are noticed at the next poll.
+            _wake[0] = -1;
+            _wake[1] = -1;
+        }
+#endif
+
+        _thread.setName("ofxOAuthTransferLoop");
+        _thread.start(*this);
+
+        return true;
+    }
+
+    CURL* _begin(Job* job)
+    {
+        CURL* curl = 0;
+
+        try
+        {
+            curl = job->begin();
+        }
+        catch(const std::exception& exc)
+        {
+            ofLogError("ofxOAuthTransferLoop::run") << "Job failed to begin: " << exc.what();
+        }
+
+        if(0 == curl)
+        {
+            delete job;
+            return 0;
+        }
+
+        _running.push_back(curl);
+
+        return curl;
+    }
+
+    void _finish(CURL* curl, CURLcode result)
+    {
+        Job* job = 0;
+        curl_easy_getinfo(curl, CURLINFO_PRIVATE, reinterpret_cast<char**>(&job));
+        curl_multi_remove_handle(_multi, curl);
+        _running.erase(std::remove(_running.begin(), _running.end(), curl), _running.end());
+
+        try
+        {
+            job->end(curl, result);
+        }
+        catch(const std::exception& exc)
+        {
+            ofLogError("ofxOAuthTransferLoop::run") << "Job failed to end: " << exc.what();
+        }
+
+        delete job;
+    }
+
+    static void _abandon(Job* job)
+    {
+        try
+        {
+            job->end(0, CURLE_ABORTED_BY_CALLBACK);
+        }
+        catch(const std::exception& exc)
+        {
+            ofLogError("ofxOAuthTransferLoop::stop") << "Job failed to end: " << exc.what();
+        }
+
+        delete job;
+    }
+
+    // Called with the mutex held.
+    void _wakeUp()
+    {
+#if !defined(_WIN32)
+        if(_wake[1] >= 0)
+        {
+            char c = 0;
+            ssize_t n = ::write(_wake[1], &c, 1);
+            (void)n; // a full pipe is already a pending wake-up.
+        }
+#endif
+    }
+
+    // Waits for socket activity, a curl timeout or a wake-up.
+    void _wait()
+    {
+        long timeout = -1;
+        curl_multi_timeout(_multi, &timeout);
+
+        if(timeout == 0) return;
+
+        if(timeout < 0 || timeout > MAX_WAIT) timeout = MAX_WAIT;
+
+        {
+            Poco::Mutex::ScopedLock lock(_mutex);
+
+            // wake up when the next delayed job is due.
+            if(!_delayed.empty())
+            {
+                Poco::Timestamp::TimeVal due = _delayed.begin()->first - Poco::Timestamp().epochMicroseconds();
+                timeout = std::min(timeout, std::max(0L, static_cast<long>((due + 999) / 1000)));
+            }
+        }
+
+        if(timeout == 0) return;
+
+        fd_set readSet;
+        fd_set writeSet;
+        fd_set errorSet;
+
+        FD_ZERO(&readSet);
+        FD_ZERO(&writeSet);
+        FD_ZERO(&errorSet);
+
+        int maxfd = -1;
+        curl_multi_fdset(_multi, &readSet, &writeSet, &errorSet, &maxfd);
+
+#if defined(_WIN32)
+        // there is no wake pipe; poll for new jobs every few milliseconds.
+        timeout = std::min(timeout, 10L);
+
+        if(maxfd < 0)
+        {
+            Poco::Thread::sleep(timeout);
+            return;
+        }
+#else
+        if(_wake[0] >= 0)
+        {
+            FD_SET(_wake[0], &readSet);
+            maxfd = std::max(maxfd, _wake[0]);
+        }
+        else
+        {
+            timeout = std::min(timeout, 10L);
+        }
+#endif
+
+        struct timeval tv;
+        tv.tv_sec = timeout / 1000;
+        tv.tv_usec = (timeout % 1000) * 1000;
+
+        select(maxfd + 1, &readSet, &writeSet, &errorSet, &tv);
+
+#if !defined(_WIN32)
+        if(_wake[0] >= 0 && FD_ISSET(_wake[0], &readSet))
+        {
+            char buffer[64];
+            while(::read(_wake[0], buffer, sizeof(buffer)) > 0)
+            {
+            }
+        }
+#endif
+    }
+
+    CURLM* _multi;
+    int _wake[2]; //< self-pipe, written to when a job is submitted
+
+    typedef std::multimap<Poco::Timestamp::TimeVal, Job*> Delayed;
+
+    std::deque<Job*> _pending;
+    Delayed _delayed; //< by when they are due
+    std::vector<CURL*> _running; //< loop thread only
+    std::size_t _maxActive;
+    bool _isStopping;
+
+    Poco::Thread _thread;
+    mutable Poco::Mutex _mutex;
+
+};
@@ -0,0 +1,878 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <curl/curl.h>
+#include "Poco/Mutex.h"
+#include "Poco/String.h"
+#include "Poco/Timestamp.h"
+#include "Poco/Net/NameValueCollection.h"
+#include "ofxOAuthCancellationToken.h"
+#include "ofxOAuthCircuitBreaker.h"
+#include "ofxOAuthMultipartForm.h"
+#include "ofxOAuthTransferLoop.h"
+
+
+struct ofxOAuthRequest
+{
+    ofxOAuthRequest():
+        method("GET"),
+        form(0),
+        source(0),
+        connectTimeout(0),
+        timeout(0),
+        queuedAt(0)
+    {
+    }
+
+    // Replaces the header with the same name, or adds it.
+    void setHeader(const std::string& header)
+    {
+        std::string::size_type colon = header.find(':');
+
+        for(std::size_t i = 0; i < headers.size(); ++i)
+        {
+            if(colon != std::string::npos &&
+               headers[i].size() > colon &&
+               headers[i][colon] == ':' &&
+               Poco::icompare(headers[i].substr(0, colon), header.substr(0, colon)) == 0)
+            {
+                headers[i] = header;
+                return;
+            }
+        }
+
+        headers.push_back(header);
+    }
+
+    std::string method;
+    std::string url;                  //< complete url, including the query
+    std::vector<std::string> headers; //< "Name: value"
+    std::string body;
+    ofxOAuthMultipartForm* form;      //< if set, posted instead of body (not owned)
+    ofxOAuthUploadSource* source;     //< if set, streamed as the raw body (not owned)
+
+    long connectTimeout;              //< milliseconds, 0 for the transport default
+    long timeout;                     //< milliseconds for the whole transfer, 0 for the transport default
+    std::shared_ptr<ofxOAuthCancellationToken> cancellationToken; //< optional
+
+    // When the request was handed to a queue (Timestamp::epochMicroseconds),
+    // 0 if it was not.  The wait is reported in ofxOAuthResponse::timings.
+    Poco::Timestamp::TimeVal queuedAt;
+
+    // Called once, on the transfer thread, when the first byte of the
+    // response arrives.  Optional.
+    std::function<void()> onFirstByte;
+
+    // Called on the transfer thread with each chunk of a successful
+    // response's (decoded) body, which is then not kept in the response.
+    // Error replies (4xx / 5xx) are kept as usual.  Optional; not for
+    // hedged requests, whose duplicates would share it.
+    std::function<void(const char* data, std::size_t size)> onBody;
+};
+
+
+// Per-call settings for the client's requests, e.g.
+//
+//      ofxOAuthRequestOptions options;
+//      options.timeout = 2000;
+//      options.cancellationToken = token;
+//      std::string reply = oauth.get("/1.1/statuses/home_timeline.json", "", options);
+//
+// Zero timeouts use the client's, see setRequestTimeouts().  A cancellation
+// token converts to options, so one can be passed wherever they are taken.
+struct ofxOAuthRequestOptions
+{
+    ofxOAuthRequestOptions():
+        connectTimeout(0),
+        timeout(0)
+    {
+    }
+
+    ofxOAuthRequestOptions(std::shared_ptr<ofxOAuthCancellationToken> cancellationToken):
+        connectTimeout(0),
+        timeout(0),
+        cancellationToken(cancellationToken)
+    {
+    }
+
+    // Sets the request's timeouts and token.
+    void apply(ofxOAuthRequest& request) const
+    {
+        request.connectTimeout = connectTimeout;
+        request.timeout = timeout;
+        request.cancellationToken = cancellationToken;
+    }
+
+    // True if nothing is set.
+    bool isDefault() const
+    {
+        return 0 == connectTimeout && 0 == timeout && !cancellationToken;
+    }
+
+    long connectTimeout; //< milliseconds, 0 for the client's
+    long timeout;        //< milliseconds for each attempt, 0 for the client's
+    std::shared_ptr<ofxOAuthCancellationToken> cancellationToken; //< optional, also ends waits between retries
+};
+
+
+struct ofxOAuthResponse
+{
+    // Where the time went, in microseconds.  dns, connect and tls are 0 on a
+    // reused connection.
+    struct Timings
+    {
+        Timings():
+            queue(0),
+            dns(0),
+            connect(0),
+            tls(0),
+            ttfb(0),
+            transfer(0),
+            total(0)
+        {
+        }
+
+        uint64_t queue;    //< waiting to be performed
+        uint64_t dns;
+        uint64_t connect;  //< tcp
+        uint64_t tls;
+        uint64_t ttfb;     //< request sent to the first response byte
+        uint64_t transfer; //< first to last byte
+        uint64_t total;    //< dns to last byte
+    };
+
+    ofxOAuthResponse():
+        status(0),
+        error(CURLE_OK),
+        rejected(false),
+        wireBytes(0),
+        decodedBytes(0)
+    {
+    }
+
+    // True if the transfer completed, whatever the HTTP status.
+    bool isComplete() const
+    {
+        return error == CURLE_OK && status > 0;
+    }
+
+    bool isCancelled() const
+    {
+        return error == CURLE_ABORTED_BY_CALLBACK;
+    }
+
+    bool isTimedOut() const
+    {
+        return error == CURLE_OPERATION_TIMEDOUT;
+    }
+
+    // True if the circuit breaker refused to send the request.
+    bool isRejected() const
+    {
+        return rejected;
+    }
+
+    long status;
+    CURLcode error;
+    std::string errorMessage;
+    bool rejected;
+    Timings timings;
+
+    // Body bytes as sent by the server and after content decoding; they
+    // differ when the body came gzip or deflate encoded.
+    uint64_t wireBytes;
+    uint64_t decodedBytes;
+
+    Poco::Net::NameValueCollection headers; //< names compare case-insensitively
+    std::string body;
+};
+
+
+// Performs requests with libcurl.  Easy handles are kept in a small pool
+// and reused, so keep-alive connections (and TLS sessions) survive between
+// calls to the same host.  Asynchronous requests all run on one I/O
+// thread, see ofxOAuthTransferLoop.
+class ofxOAuthTransport
+{
+public:
+    ofxOAuthTransport():
+        _connectTimeout(0),
+        _timeout(0),
+        _isCompressionEnabled(true),
+        _isSSLVerificationEnabled(true)
+    {
+        curl_global_init(CURL_GLOBAL_DEFAULT);
+    }
+
+    virtual ~ofxOAuthTransport()
+    {
+        // asynchronous transfers end (aborted) before their handles go.
+        _loop.stop();
+
+        Poco::Mutex::ScopedLock lock(_mutex);
+
+        for(std::size_t i = 0; i < _handles.size(); ++i)
+        {
+            curl_easy_cleanup(_handles[i]);
+        }
+    }
+
+    // Default deadlines, in milliseconds, for requests that do not set their
+    // own.  0 means no limit.
+    void setTimeouts(long connectTimeout, long timeout)
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        _connectTimeout = connectTimeout;
+        _timeout = timeout;
+    }
+
+    void setSSLCACertificateFile(const std::string& pathname)
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        _SSLCACertificateFile = pathname;
+    }
+
+    // Verify the server's certificate and host name (against the CA file,
+    // if one is set).  On by default; turn it off only for testing against
+    // a server whose certificate cannot be verified.
+    void setSSLVerificationEnabled(bool enabled)
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        _isSSLVerificationEnabled = enabled;
+    }
+
+    bool isSSLVerificationEnabled() const
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        return _isSSLVerificationEnabled;
+    }
+
+    void setUserAgent(const std::string& userAgent)
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        _userAgent = userAgent;
+    }
+
+    // Ask for gzip or deflate encoded responses (any encoding curl can
+    // decode).  Bodies are inflated as they arrive, so the response holds
+    // the decoded body; the Content-Encoding header is left as sent.  On
+    // by default.
+    void setCompressionEnabled(bool enabled)
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        _isCompressionEnabled = enabled;
+    }
+
+    bool isCompressionEnabled() const
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        return _isCompressionEnabled;
+    }
+
+    // Called on the requesting thread (the I/O thread for asynchronous
+    // requests) after every transfer, complete or not.  Must be set before the transport is shared between threads.
+    typedef std::function<void(const ofxOAuthRequest& request, const ofxOAuthResponse& response)> Observer;
+
+    void setObserver(Observer observer)
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+        _observer = observer;
+    }
+
+    // Per-host circuits; see ofxOAuthCircuitBreaker.
+    ofxOAuthCircuitBreaker& getCircuitBreaker()
+    {
+        return _circuitBreaker;
+    }
+
+    const ofxOAuthCircuitBreaker& getCircuitBreaker() const
+    {
+        return _circuitBreaker;
+    }
+
+    // Blocks until the transfer is finished.  Returns response.isComplete().
+    bool perform(const ofxOAuthRequest& request, ofxOAuthResponse& response)
+    {
+        _Transfer transfer(request, response);
+
+        CURL* curl = _begin(transfer);
+
+        if(0 == curl) return false;
+
+        _end(curl, transfer, curl_easy_perform(curl));
+
+        return response.isComplete();
+    }
+
+    // Called once, on the transport's I/O thread, when an asynchronous
+    // transfer finishes.  It should return quickly; other transfers wait.
+    typedef std::function<void(const ofxOAuthRequest& request, ofxOAuthResponse& response)> Completion;
+
+    // Queues the transfer on the transport's I/O thread and returns at
+    // once.  Every asynchronous transfer shares that one thread and its
+    // connections.  The request is copied, but a form or source it points
+    // to must outlive the completion.  With a delay (milliseconds), the
+    // transfer is queued that much later, e.g. to retry after a backoff.
+    void performAsync(const ofxOAuthRequest& request, Completion completion, long delay = 0)
+    {
+        ofxOAuthRequest queued = request;
+
+        if(queued.queuedAt == 0)
+        {
+            // the delay is not counted as time spent in the queue.
+            queued.queuedAt = Poco::Timestamp().epochMicroseconds() + std::max(0L, delay) * 1000;
+        }
+
+        _loop.submit(new _AsyncTransfer(*this, queued, completion), delay);
+    }
+
+    // Ends every asynchronous transfer now, aborted, and stops the I/O
+    // thread.  Later ones are aborted as they are queued.  The destructor
+    // does this too.
+    void stop()
+    {
+        _loop.stop();
+    }
+
+    // The most asynchronous transfers run at once (64 by default); the
+    // rest wait for a slot, in order.
+    void setMaxAsyncTransfers(std::size_t maxTransfers)
+    {
+        _loop.setMaxActive(maxTransfers);
+    }
+
+    std::size_t getMaxAsyncTransfers() const
+    {
+        return _loop.getMaxActive();
+    }
+
+protected:
+    enum
+    {
+        MAX_IDLE_HANDLES = 8
+    };
+
+    CURL* _acquire()
+    {
+        CURL* curl = 0;
+
+        std::string userAgent;
+        std::string SSLCACertificateFile;
+        bool isCompressionEnabled = false;
+        bool isSSLVerificationEnabled = true;
+
+        {
+            Poco::Mutex::ScopedLock lock(_mutex);
+
+            if(!_handles.empty())
+            {
+                curl = _handles.back();
+                _handles.pop_back();
+            }
+
+            userAgent = _userAgent;
+            SSLCACertificateFile = _SSLCACertificateFile;
+            isCompressionEnabled = _isCompressionEnabled;
+            isSSLVerificationEnabled = _isSSLVerificationEnabled;
+        }
+
+        if(0 == curl)
+        {
+            curl = curl_easy_init();
+            if(0 == curl) return 0;
+        }
+        else
+        {
+            // reset options, but keep the connection and session caches.
+            curl_easy_reset(curl);
+        }
+
+        curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+
+        if(!userAgent.empty())
+        {
+            curl_easy_setopt(curl, CURLOPT_USERAGENT, userAgent.c_str());
+        }
+
+        if(isCompressionEnabled)
+        {
+            // "" offers every encoding curl was built to decode.
+            curl_easy_setopt(curl, CURLOPT_ENCODING, "");
+        }
+
+        if(!isSSLVerificationEnabled)
+        {
+            curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+            curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+        }
+
+        if(!SSLCACertificateFile.empty())
+        {
+            curl_easy_setopt(curl, CURLOPT_CAINFO, SSLCACertificateFile.c_str());
+        }
+
+        return curl;
+    }
+
+    void _release(CURL* curl)
+    {
+        Poco::Mutex::ScopedLock lock(_mutex);
+
+        if(_handles.size() < MAX_IDLE_HANDLES)
+        {
+            _handles.push_back(curl);
+        }
+        else
+        {
+            curl_easy_cleanup(curl);
+        }
+    }
+
+    // curl reports each time from the start of the transfer.
+    static void _getTimings(CURL* curl, ofxOAuthResponse::Timings& timings)
+    {
+        double nameLookup = 0;
+        double connect = 0;
+        double appConnect = 0;
+        double preTransfer = 0;
+        double startTransfer = 0;
+        double total = 0;
+
+        curl_easy_getinfo(curl, CURLINFO_NAMELOOKUP_TIME, &nameLookup);
+        curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME, &connect);
+        curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME, &appConnect);
+        curl_easy_getinfo(curl, CURLINFO_PRETRANSFER_TIME, &preTransfer);
+        curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME, &startTransfer);
+        curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME, &total);
+
+        timings.dns = _toMicroseconds(nameLookup);
+        timings.connect = _toMicroseconds(connect - nameLookup);
+        timings.tls = appConnect > 0 ? _toMicroseconds(appConnect - connect) : 0;
+        timings.ttfb = startTransfer > 0 ? _toMicroseconds(startTransfer - preTransfer) : 0;
+        timings.transfer = startTransfer > 0 ? _toMicroseconds(total - startTransfer) : 0;
+        timings.total = _toMicroseconds(total);
+    }
+
+    static uint64_t _toMicroseconds(double seconds)
+    {
+        return seconds > 0 ? static_cast<uint64_t>(seconds * 1000000.0 + 0.5) : 0;
+    }
+
+    // The state of one transfer, from _begin() to _end().
+    struct _Transfer
+    {
+        _Transfer(const ofxOAuthRequest& _request, ofxOAuthResponse& _response):
+            request(_request),
+            response(_response),
+            slist(0),
+            post(0),
+            hasFirstByte(false),
+            status(0)
+        {
+            errorBuffer[0] = 0;
+        }
+
+        const ofxOAuthRequest& request;
+        ofxOAuthResponse& response;
+        std::string host;
+        struct curl_slist* slist;
+        ofxOAuthMultipartForm::Post post;
+        char errorBuffer[CURL_ERROR_SIZE];
+        bool hasFirstByte;
+        long status; //< from the last status line, while the body arrives
+    };
+
+    // Returns an easy handle ready to perform, or 0 if the request was not
+    // sent; the response then holds the reason.
+    CURL* _begin(_Transfer& transfer)
+    {
+        const ofxOAuthRequest& request = transfer.request;
+        ofxOAuthResponse& response = transfer.response;
+
+        if(request.queuedAt != 0)
+        {
+            Poco::Timestamp::TimeDiff wait = Poco::Timestamp().epochMicroseconds() - request.queuedAt;
+            response.timings.queue = wait > 0 ? static_cast<uint64_t>(wait) : 0;
+        }
+
+        if(request.cancellationToken && request.cancellationToken->isCancelled())
+        {
+            response.error = CURLE_ABORTED_BY_CALLBACK;
+            response.errorMessage = "Cancelled.";
+            return 0;
+        }
+
+        transfer.host = ofxOAuthCircuitBreaker::getHost(request.url);
+
+        if(!_circuitBreaker.allow(transfer.host))
+        {
+            response.error = CURLE_COULDNT_CONNECT;
+            response.errorMessage = "Circuit open for " + transfer.host + ".";
+            response.rejected = true;
+            return 0;
+        }
+
+        CURL* curl = _acquire();
+
+        if(0 == curl)
+        {
+            _circuitBreaker.record(transfer.host, ofxOAuthCircuitBreaker::IGNORED);
+            response.error = CURLE_FAILED_INIT;
+            response.errorMessage = "Unable to initialize curl.";
+            return 0;
+        }
+
+        for(std::size_t i = 0; i < request.headers.size(); ++i)
+        {
+            transfer.slist = curl_slist_append(transfer.slist, request.headers[i].c_str());
+        }
+
+        curl_easy_setopt(curl, CURLOPT_URL, request.url.c_str());
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, transfer.slist);
+        curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, transfer.errorBuffer);
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, _writeCallback);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &transfer);
+        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, _headerCallback);
+        curl_easy_setopt(curl, CURLOPT_HEADERDATA, &transfer);
+
+        long connectTimeout = request.connectTimeout;
+        long timeout = request.timeout;
+
+        {
+            Poco::Mutex::ScopedLock lock(_mutex);
+            if(connectTimeout <= 0) connectTimeout = _connectTimeout;
+            if(timeout <= 0) timeout = _timeout;
+        }
+
+        if(connectTimeout > 0)
+        {
+            curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, connectTimeout);
+        }
+
+        if(timeout > 0)
+        {
+            curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, timeout);
+        }
+
+        if(request.cancellationToken)
+        {
+            curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+#if LIBCURL_VERSION_NUM >= 0x072000
+            curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, _xferInfoCallback);
+            curl_easy_setopt(curl, CURLOPT_XFERINFODATA, request.cancellationToken.get());
+#else
+            // CURLOPT_XFERINFOFUNCTION is newer than the bundled curl.
+            curl_easy_setopt(curl, CURLOPT_PROGRESSFUNCTION, _progressCallback);
+            curl_easy_setopt(curl, CURLOPT_PROGRESSDATA, request.cancellationToken.get());
+#endif
+        }
+
+        if(0 != request.form)
+        {
+            transfer.post = request.form->attach(curl);
+
+            if(0 == transfer.post)
+            {
+                curl_slist_free_all(transfer.slist);
+                transfer.slist = 0;
+                _release(curl);
+                _circuitBreaker.record(transfer.host, ofxOAuthCircuitBreaker::IGNORED);
+                response.error = CURLE_FAILED_INIT;
+                response.errorMessage = "Unable to build the multipart form.";
+                return 0;
+            }
+        }
+        else if(0 != request.source)
+        {
+            request.source->rewind();
+
+            if(request.method == "POST")
+            {
+                curl_easy_setopt(curl, CURLOPT_POST, 1L);
+                curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t)request.source->size());
+            }
+            else
+            {
+                curl_easy_setopt(curl, CURLOPT_UPLOAD, 1L);
+                curl_easy_setopt(curl, CURLOPT_INFILESIZE_LARGE, (curl_off_t)request.source->size());
+                curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, request.method.c_str());
+            }
+
+            curl_easy_setopt(curl, CURLOPT_READFUNCTION, ofxOAuthUploadSource::readCallback);
+            curl_easy_setopt(curl, CURLOPT_READDATA, request.source);
+            curl_easy_setopt(curl, CURLOPT_SEEKFUNCTION, ofxOAuthUploadSource::seekCallback);
+            curl_easy_setopt(curl, CURLOPT_SEEKDATA, request.source);
+        }
+        else if(request.method == "GET")
+        {
+            curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
+        }
+        else if(request.method == "HEAD")
+        {
+            // no body is transferred, or waited for.
+            curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
+        }
+        else if(request.method == "POST")
+        {
+            curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request.body.c_str());
+            curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, (long)request.body.size());
+        }
+        else
+        {
+            curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, request.method.c_str());
+
+            if(!request.body.empty())
+            {
+                curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request.body.c_str());
+                curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, (long)request.body.size());
+            }
+        }
+
+        return curl;
+    }
+
+    // Collects the result of a transfer begun by _begin() and returns the
+    // handle to the pool.
+    void _end(CURL* curl, _Transfer& transfer, CURLcode result)
+    {
+        ofxOAuthResponse& response = transfer.response;
+
+        response.error = result;
+
+        if(response.error == CURLE_OK)
+        {
+            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response.status);
+        }
+        else
+        {
+            response.errorMessage = transfer.errorBuffer[0] ? transfer.errorBuffer : curl_easy_strerror(response.error);
+        }
+
+        _getTimings(curl, response.timings);
+
+        // counted before decoding.
+#if LIBCURL_VERSION_NUM >= 0x073700
+        curl_off_t downloaded = 0;
+        curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &downloaded);
+#else
+        double downloaded = 0;
+        curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD, &downloaded);
+#endif
+        response.wireBytes = downloaded > 0 ? static_cast<uint64_t>(downloaded) : 0;
+
+        // an aborted transfer leaves its connection mid-response; curl
+        // closes that connection rather than caching it, so the handle
+        // itself can go back to the pool as usual.
+        if(response.isCancelled())
+        {
+            response.errorMessage = "Cancelled.";
+        }
+
+        curl_slist_free_all(transfer.slist);
+        transfer.slist = 0;
+
+        if(0 != transfer.post)
+        {
+            ofxOAuthMultipartForm::freePost(transfer.post);
+            transfer.post = 0;
+        }
+
+        _release(curl);
+
+        if(response.isCancelled())
+        {
+            _circuitBreaker.record(transfer.host, ofxOAuthCircuitBreaker::IGNORED);
+        }
+        else if(!response.isComplete() || response.status >= 500)
+        {
+            _circuitBreaker.record(transfer.host, ofxOAuthCircuitBreaker::FAILURE);
+        }
+        else
+        {
+            _circuitBreaker.record(transfer.host, ofxOAuthCircuitBreaker::SUCCESS);
+        }
+
+        Observer observer;
+
+        {
+            Poco::Mutex::ScopedLock lock(_mutex);
+            observer = _observer;
+        }
+
+        if(observer) observer(transfer.request, response);
+    }
+
+    // An asynchronous transfer, owning its copy of the request and the
+    // response.
+    class _AsyncTransfer: public ofxOAuthTransferLoop::Job
+    {
+    public:
+        _AsyncTransfer(ofxOAuthTransport& transport,
+                       const ofxOAuthRequest& request,
+                       Completion completion):
+            _transport(transport),
+            _request(request),
+            _completion(completion),
+            _transfer(_request, _response)
+        {
+        }
+
+        CURL* begin()
+        {
+            CURL* curl = _transport._begin(_transfer);
+            if(0 == curl) _complete();
+            return curl;
+        }
+
+        void end(CURL* curl, CURLcode result)
+        {
+            if(0 != curl)
+            {
+                _transport._end(curl, _transfer, result);
+            }
+            else
+            {
+                _response.error = result;
+                _response.errorMessage = "Transport stopped.";
+            }
+
+            _complete();
+        }
+
+    private:
+        void _complete()
+        {
+            if(_completion) _completion(_request, _response);
+        }
+
+        ofxOAuthTransport& _transport;
+        ofxOAuthRequest _request;
+        ofxOAuthResponse _response;
+        Completion _completion;
+        _Transfer _transfer;
+    };
+
+#if LIBCURL_VERSION_NUM >= 0x072000
+    static int _xferInfoCallback(void* data, curl_off_t, curl_off_t, curl_off_t, curl_off_t)
+    {
+        return static_cast<ofxOAuthCancellationToken*>(data)->isCancelled() ? 1 : 0;
+    }
+#else
+    static int _progressCallback(void* data, double, double, double, double)
+    {
+        return static_cast<ofxOAuthCancellationToken*>(data)->isCancelled() ? 1 : 0;
+    }
+#endif
+
+    static std::size_t _writeCallback(char* ptr,
+                                      std::size_t size,
+                                      std::size_t nmemb,
+                                      void* data)
+    {
+        _Transfer* transfer = static_cast<_Transfer*>(data);
+        ofxOAuthResponse* response = &transfer->response;
+
+        if(transfer->request.onBody && transfer->status < 400)
+        {
+            transfer->request.onBody(ptr, size * nmemb);
+        }
+        else
+        {
+            response->body.append(ptr, size * nmemb);
+        }
+
+        response->decodedBytes += size * nmemb;
+        return size * nmemb;
+    }
+
+    static std::size_t _headerCallback(char* ptr,
+                                       std::size_t size,
+                                       std::size_t nmemb,
+                                       void* data)
+    {
+        _Transfer* transfer = static_cast<_Transfer*>(data);
+        ofxOAuthResponse* response = &transfer->response;
+
+        // headers always arrive before the body.
+        if(!transfer->hasFirstByte)
+        {
+            transfer->hasFirstByte = true;
+            if(transfer->request.onFirstByte) transfer->request.onFirstByte();
+        }
+
+        std::size_t length = size * nmemb;
+        std::string line(ptr, length);
+
+        if(line.compare(0, 5, "HTTP/") == 0)
+        {
+            // a new status line (e.g. after a redirect) starts a new set.
+            response->headers.clear();
+
+            std::string::size_type space = line.find(' ');
+            transfer->status = space != std::string::npos ? atol(line.c_str() + space + 1) : 0;
+        }
+        else
+        {
+            std::string::size_type colon = line.find(':');
+
+            if(colon != std::string::npos)
+            {
+                response->headers.add(Poco::trim(line.substr(0, colon)),
+                                      Poco::trim(line.substr(colon + 1)));
+            }
+        }
+
+        return length;
+    }
+
+    std::vector<CURL*> _handles;
+
+    std::string _userAgent;
+    std::string _SSLCACertificateFile;
+    Observer _observer;
+    ofxOAuthCircuitBreaker _circuitBreaker;
+    long _connectTimeout;
+    long _timeout;
+    bool _isCompressionEnabled;
+    bool _isSSLVerificationEnabled;
+
+    // runs asynchronous transfers
+    ofxOAuthTransferLoop _loop;
+
+    mutable Poco::Mutex _mutex;
+
+};
@@ -0,0 +1,254 @@
+// =============================================================================
+//
+// Copyright (c) 2010-2013 Christopher Baker <http://christopherbaker.net>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// =============================================================================
+
+
+
+#pragma once
+
+
+#include <stdio.h>
+#include <string.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <curl/curl.h>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+// The body of an upload, fed to curl through its read callback.  A file is
+// memory-mapped rather than read through stdio, so curl copies straight from
+// the page cache into its send buffer; where it cannot be mapped (Windows,
+// or a failed mmap) it is read into memory instead.  A caller-owned buffer can be
+// registered instead; it is not copied and must outlive the transfer.
+//
+//      ofxOAuthUploadSource source;
+//      source.openFile("/path/to/video.mp4");
+//      curl_easy_setopt(curl, CURLOPT_READFUNCTION, ofxOAuthUploadSource::readCallback);
+//      curl_easy_setopt(curl, CURLOPT_READDATA, &source);
+//
+class ofxOAuthUploadSource
+{
+public:
+    ofxOAuthUploadSource():
+        _data(0),
+        _size(0),
+        _offset(0),
+        _isMapped(false)
+    {
+    }
+
+    virtual ~ofxOAuthUploadSource()
+    {
+        close();
+    }
+
+    bool openFile(const std::string& path)
+    {
+        close();
+
+#if defined(_WIN32)
+        return _readFile(path);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+
+        if(fd < 0) return false;
+
+        struct stat statbuf;
+
+        if(fstat(fd, &statbuf) != 0)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        _size = static_cast<std::size_t>(statbuf.st_size);
+
+        if(_size > 0)
+        {
+            void* p = mmap(0, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if(p == MAP_FAILED)
+            {
+                ::close(fd);
+                _size = 0;
+                return _readFile(path);
+            }
+
+            // we read front to back exactly once.
+            madvise(p, _size, MADV_SEQUENTIAL);
+
+            _data = static_cast<const char*>(p);
+            _isMapped = true;
+        }
+
+        // the mapping stays valid after the descriptor is closed.
+        ::close(fd);
+
+        _name = path.substr(path.find_last_of("/\\") + 1);
+
+        return true;
+#endif
+    }
+
+    // Registers a caller-owned buffer.  Nothing is copied.
+    void setBuffer(const void* data, std::size_t size, const std::string& name = "")
+    {
+        close();
+        _data = static_cast<const char*>(data);
+        _size = size;
+        _name = name;
+    }
+
+    void close()
+    {
+#if !defined(_WIN32)
+        if(_isMapped) munmap(const_cast<char*>(_data), _size);
+#endif
+        std::vector<char>().swap(_buffer);
+        _data = 0;
+        _size = 0;
+        _offset = 0;
+        _isMapped = false;
+        _name.clear();
+    }
+
+    const char* data() const
+    {
+        return _data;
+    }
+
+    std::size_t size() const
+    {
+        return _size;
+    }
+
+    std::size_t remaining() const
+    {
+        return _size - _offset;
+    }
+
+    // The file name, as sent in the multipart Content-Disposition.
+    const std::string& getName() const
+    {
+        return _name;
+    }
+
+    void rewind()
+    {
+        _offset = 0;
+    }
+
+    std::size_t read(char* buffer, std::size_t length)
+    {
+        std::size_t n = remaining() < length ? remaining() : length;
+        memcpy(buffer, _data + _offset, n);
+        _offset += n;
+        return n;
+    }
+
+    // CURLOPT_READFUNCTION (and CURLFORM_STREAM / curl_mime_data_cb())
+    // compatible callback.
+    static std::size_t readCallback(char* buffer,
+                                    std::size_t size,
+                                    std::size_t nitems,
+                                    void* userdata)
+    {
+        return static_cast<ofxOAuthUploadSource*>(userdata)->read(buffer, size * nitems);
+    }
+
+    // CURLOPT_SEEKFUNCTION compatible callback, used if curl has to resend
+    // the body (e.g. after a redirect).
+    static int seekCallback(void* userdata, curl_off_t offset, int origin)
+    {
+        ofxOAuthUploadSource* source = static_cast<ofxOAuthUploadSource*>(userdata);
+
+        curl_off_t base = 0;
+
+        if(origin == SEEK_CUR) base = static_cast<curl_off_t>(source->_offset);
+        else if(origin == SEEK_END) base = static_cast<curl_off_t>(source->_size);
+
+        curl_off_t position = base + offset;
+
+        if(position < 0 || position > static_cast<curl_off_t>(source->_size))
+        {
+            return CURL_SEEKFUNC_FAIL;
+        }
+
+        source->_offset = static_cast<std::size_t>(position);
+        return CURL_SEEKFUNC_OK;
+    }
+
+private:
+    ofxOAuthUploadSource(const ofxOAuthUploadSource&);
+    ofxOAuthUploadSource& operator=(const ofxOAuthUploadSource&);
+
+    // The fallback where mapping is not available: the whole file is read
+    // into memory once.
+    bool _readFile(const std::string& path)
+    {
+        FILE* file = fopen(path.c_str(), "rb");
+
+        if(0 == file) return false;
+
+        bool isRead = false;
+
+        if(fseek(file, 0, SEEK_END) == 0)
+        {
+            long length = ftell(file);
+
+            if(length >= 0 && fseek(file, 0, SEEK_SET) == 0)
+            {
+                _buffer.resize(static_cast<std::size_t>(length));
+                isRead = _buffer.empty() || fread(&_buffer[0], 1, _buffer.size(), file) == _buffer.size();
+            }
+        }
+
+        fclose(file);
+
+        if(!isRead)
+        {
+            std::vector<char>().swap(_buffer);
+            return false;
+        }
+
+        _data = _buffer.empty() ? 0 : &_buffer[0];
+        _size = _buffer.size();
+        _name = path.substr(path.find_last_of("/\\") + 1);
+
+        return true;
+    }
+
+    const char* _data;
+    std::size_t _size;
+    std::size_t _offset;
+    bool _isMapped;
+    std::vector<char> _buffer; //< the file, where it is not mapped
+    std::string _name;
+
+};
@@ -39,6 +39,7 @@
 #include "Poco/Net/HTTPServerResponse.h"
 #include "Poco/Net/NameValueCollection.h"
 #include "ofMain.h"
+#include "ofxOAuthFormDecoder.h"
 #include "ofxOAuthVerifierCallbackInterface.h"
 
 
@@ -96,7 +97,7 @@ public:
         }
         
         Poco::Net::NameValueCollection queryParams;
-        parseQuery(uri.getQuery(),queryParams);
+        parseQuery(uri.getRawQuery(),queryParams); // raw, the decoder unescapes
         if(!queryParams.empty())
         {
             callback->receivedVerifierCallbackGetParams(queryParams);
@@ -256,18 +257,19 @@ protected:
     {
         if(!query.empty())
         {
-            // could use oauth_split_url_parameters here.
-            std::vector<std::string> params = ofSplitString(query, "&", true);
-            for(int i = 0; i < params.size(); i++)
+            std::string buffer = query; // decoded in place
+            ofxOAuthFormDecoder decoder(buffer);
+            ofxOAuthFormDecoder::Field field;
+
+            while(decoder.next(field))
             {
-                std::vector<std::string> tokens = ofSplitString(params[i], "=");
-                if(tokens.size() == 2)
+                if(field.hasValue)
                 {
-                    returnParams.set(tokens[0], tokens[1]);
+                    returnParams.set(field.key.str(), field.value.str());
                 }
                 else
                 {
-                    ofLogWarning("ofxOAuthAuthReqHandler::parseQuery") << "Return parameter did not have 2 values: " << ofToString(params[i]) << " - skipping.";
+                    ofLogWarning("ofxOAuthAuthReqHandler::parseQuery") << "Return parameter did not have a value: " << field.key.str() << " - skipping.";
                 }
             }
         }
@@ -297,7 +299,7 @@ public:
     {
     }
 
-    Poco::Net::HTTPRequestHandler* createRequestHandler(const Poco::Net::HTTPServerRequest& request)
+    Poco::Net::HTTPRequestHandler* createRequestHandler(const Poco::Net::HTTPServerRequest&)
     {
         return new ofxOAuthAuthReqHandler(callback, docRoot); 
     }